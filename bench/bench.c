@@ -0,0 +1,133 @@
+#include "bench.h"
+#include "../include/div64.h"
+#include "../include/stdio.h"
+#include "../include/string.h"
+#include "../kernel/console/console.h"
+#include "../kernel/cpu/cpu.h"
+#include "../kernel/time/ktime.h"
+#include "../drivers/io/io.h"
+#include "../drivers/serial/serial.h"
+
+/* Benchmarks
+ *
+ * The benchmarks are registered with BENCH in the .bench section; link.ld collects them between bench_start and
+ * bench_end, so a suite is added by adding a file. Booting with "bench" on the kernel command line runs them all
+ * (make bench runs them under QEMU and exits it once done).
+ *
+ * Each benchmark runs BENCH_WARMUP_TRIALS unmeasured trials, then BENCH_TRIALS measured ones. A trial is timed with
+ * rdtsc around a batch of iterations, with the interrupts disabled, and the sorted samples give the minimum (the best
+ * case), the median (the typical case) and the 99th percentile (the tail).
+ *
+ * The results go to COM1, one line per benchmark:
+ *
+ *     BENCH name=<name> iterations=<n> trials=<n> min=<cycles> median=<cycles> p99=<cycles> median_ns=<ns>
+ *
+ * between a BENCH-START and a BENCH-END line. Other lines on the port (the output of the benchmarks themselves) do
+ * not start with BENCH. The serial console is switched off while the benchmarks run. */
+
+// Defined in link.ld
+extern const struct bench bench_start[];
+extern const struct bench bench_end[];
+
+volatile uint32_t bench_sink;
+
+static uint32_t samples[BENCH_TRIALS];
+
+/** bench_print:
+ *  Writes a line of results to COM1 and waits until it is sent, so that the output is complete when QEMU exits.
+ */
+static void bench_print(const char *format, ...) {
+    char line[160];
+    va_list ap;
+    int length;
+
+    va_start(ap, format);
+    length = vsnprintf(line, sizeof(line), format, ap);
+    va_end(ap);
+    if (length >= (int) sizeof(line)) {
+        length = sizeof(line) - 1;
+    }
+
+    serial_write(SERIAL_COM1, line, length);
+    serial_flush(SERIAL_COM1);
+}
+
+/** bench_trial:
+ *  Runs one trial of a benchmark.
+ *
+ *  @return The cycles of one iteration
+ */
+static uint32_t bench_trial(const struct bench *bench) {
+    uint32_t flags;
+    uint64_t start;
+    uint64_t cycles;
+
+    if (bench->prepare) {
+        bench->prepare(bench->arg);
+    }
+
+    flags = irq_save();
+    start = rdtsc();
+    bench->run(bench->iterations, bench->arg);
+    cycles = rdtsc() - start;
+    irq_restore(flags);
+
+    div64_u32(&cycles, bench->iterations);
+    return cycles > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t) cycles;
+}
+
+/** sort_samples:
+ *  Sorts the samples in ascending order. Insertion sort, there are few samples and they are often nearly sorted.
+ */
+static void sort_samples(uint32_t *values, uint32_t count) {
+    for (uint32_t i = 1; i < count; i++) {
+        uint32_t value = values[i];
+        uint32_t j = i;
+
+        while (j > 0 && values[j - 1] > value) {
+            values[j] = values[j - 1];
+            j--;
+        }
+        values[j] = value;
+    }
+}
+
+/** bench_run:
+ *  Runs a benchmark and reports its results.
+ */
+static void bench_run(const struct bench *bench) {
+    uint32_t median;
+
+    for (int i = 0; i < BENCH_WARMUP_TRIALS; i++) {
+        bench_trial(bench);
+    }
+    for (int i = 0; i < BENCH_TRIALS; i++) {
+        samples[i] = bench_trial(bench);
+    }
+    sort_samples(samples, BENCH_TRIALS);
+
+    median = samples[BENCH_TRIALS / 2];
+    bench_print("BENCH name=%s iterations=%u trials=%u min=%u median=%u p99=%u median_ns=%u\n", bench->name,
+                bench->iterations, BENCH_TRIALS, samples[0], median, samples[BENCH_TRIALS * 99 / 100],
+                (uint32_t) ktime_cycles_to_ns(median));
+}
+
+/** bench_run_all:
+ *  Runs every registered benchmark, then exits QEMU through the isa-debug-exit device. Returns if the device is not
+ *  present.
+ */
+void bench_run_all() {
+    int serial_console = console_serial_sink.enabled;
+
+    console_serial_sink.enabled = 0;
+    serial_flush(SERIAL_COM1);
+
+    bench_print("BENCH-START count=%u tsc_khz=%u\n", (uint32_t) (bench_end - bench_start), ktime_get_tsc_khz());
+    for (const struct bench *bench = bench_start; bench < bench_end; bench++) {
+        bench_run(bench);
+    }
+    bench_print("BENCH-END\n");
+
+    console_serial_sink.enabled = serial_console;
+    outb(BENCH_DEBUG_EXIT_PORT, 0);
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include "../include/stdint.h"
+
+// Trials run before the measured ones, to warm up the caches, the TLB and the branch predictors.
+#define BENCH_WARMUP_TRIALS     5
+// Measured trials of a benchmark, odd so that the median is a sample.
+#define BENCH_TRIALS            101
+// Default number of calls of the benchmark function per trial, the cost of rdtsc is spread over them.
+#define BENCH_ITERATIONS        64
+
+// The isa-debug-exit device of QEMU (-device isa-debug-exit,iobase=0xf4,iosize=0x04): writing v exits QEMU with the
+// status (v << 1) | 1. Without the device the write is ignored.
+#define BENCH_DEBUG_EXIT_PORT   0xF4
+
+/* A benchmark. A trial calls prepare (outside the measurement), then measures run with the interrupts disabled; run
+ * repeats the operation iterations times. The results are the cycles of one iteration. */
+struct bench {
+    const char *name;
+    void (*run)(uint32_t iterations, uint32_t arg);
+    void (*prepare)(uint32_t arg);      // may be 0
+    uint32_t arg;                       // passed to run and prepare, e.g. a buffer size
+    uint32_t iterations;
+};
+
+/* Registers a benchmark in the .bench section, where bench_run_all finds it. The same run function can be registered
+ * several times with different arguments. */
+#define BENCH_ENTRY(id, run_function, prepare_function, argument, count)                                       \
+    static const struct bench bench_entry_##id __attribute__((section(".bench"), used, aligned(4))) =         \
+        {#id, run_function, prepare_function, argument, count}
+
+/* Defines and registers a benchmark, the body follows the macro and repeats the operation iterations times:
+ *
+ *     BENCH(strlen_short) {
+ *         for (uint32_t i = 0; i < iterations; i++) {
+ *             bench_sink += strlen("short");
+ *         }
+ *     }
+ */
+#define BENCH(name)                                                                                             \
+    static void bench_##name(uint32_t iterations, uint32_t arg);                                                \
+    BENCH_ENTRY(name, bench_##name, 0, 0, BENCH_ITERATIONS);                                                    \
+    static void bench_##name(uint32_t iterations, __attribute__((unused)) uint32_t arg)
+
+// Results stored here are not optimized away.
+extern volatile uint32_t bench_sink;
+
+void bench_run_all();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include "bench.h"
+#include "../kernel/console/console.h"
+#include "../drivers/framebuffer/framebuffer.h"
+#include "../drivers/serial/serial.h"
+
+/* Benchmarks of the console paths. The lines are short and end with a newline, as most console output does, so the
+ * screen scrolls on every iteration once it is full. */
+
+static char line[] = "bench: the quick brown fox jumps over the lazy dog\n";
+
+BENCH(os_printf) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        os_printf("bench: %s %d 0x%x\n", "os_printf", i, i);
+    }
+}
+
+BENCH(fb_write_str) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        fb_write_str(line);
+    }
+}
+
+/** serial_prepare:
+ *  Empties the transmit ring, so that every trial queues the same bytes instead of dropping them.
+ */
+static void serial_prepare(uint32_t arg) {
+    (void) arg;
+
+    serial_flush(SERIAL_COM1);
+}
+
+static void serial_run(uint32_t iterations, uint32_t arg) {
+    (void) arg;
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        serial_write_str(line);
+    }
+}
+BENCH_ENTRY(serial_write_str, serial_run, serial_prepare, 0, BENCH_ITERATIONS);
\ No newline at end of file
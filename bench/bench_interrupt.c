@@ -0,0 +1,19 @@
+#include "bench.h"
+#include "../drivers/interrupts/isr.h"
+
+/* Interrupt entry and exit: a software interrupt runs through the stub, the common handler, the dispatch and back
+ * through iret, which is the fixed cost every interrupt and exception pays. */
+
+// The breakpoint exception has a gate and no handler of its own.
+#define BENCH_INTERRUPT_VECTOR  3
+
+static void bench_interrupt_handler() {
+}
+
+BENCH(interrupt_round_trip) {
+    register_interrupt_handler(BENCH_INTERRUPT_VECTOR, bench_interrupt_handler);
+    for (uint32_t i = 0; i < iterations; i++) {
+        asm volatile("int %0" : : "i"(BENCH_INTERRUPT_VECTOR) : "memory");
+    }
+    register_interrupt_handler(BENCH_INTERRUPT_VECTOR, 0);
+}
\ No newline at end of file
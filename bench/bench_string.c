@@ -0,0 +1,78 @@
+#include "bench.h"
+#include "../include/string.h"
+
+/* Benchmarks of lib/string.c. The copy and fill sizes sweep across the point where the SSE2 routines take over
+ * (see kernel/cpu/fpu.c), so the cost of the switch shows up next to the bytes per cycle gained. */
+
+#define BENCH_BUFFER_SIZE       16384
+
+static uint8_t source[BENCH_BUFFER_SIZE] __attribute__((aligned(16)));
+static uint8_t destination[BENCH_BUFFER_SIZE] __attribute__((aligned(16)));
+
+static const char short_string[] = "SaturnOS";
+static char long_string[1024];
+
+/** prepare_long_string:
+ *  Fills the long string, once its benchmark is first prepared.
+ */
+static void prepare_long_string(uint32_t arg) {
+    (void) arg;
+
+    if (long_string[0] == 0) {
+        memset(long_string, 'x', sizeof(long_string) - 1);
+        long_string[sizeof(long_string) - 1] = 0;
+    }
+}
+
+BENCH(strlen_short) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        bench_sink += strlen(short_string);
+    }
+}
+
+static void strlen_long(uint32_t iterations, uint32_t arg) {
+    (void) arg;
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        bench_sink += strlen(long_string);
+    }
+}
+BENCH_ENTRY(strlen_1023, strlen_long, prepare_long_string, 0, BENCH_ITERATIONS);
+
+static void copy(uint32_t iterations, uint32_t size) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        memcpy(destination, source, size);
+    }
+}
+BENCH_ENTRY(memcpy_16, copy, 0, 16, BENCH_ITERATIONS);
+BENCH_ENTRY(memcpy_64, copy, 0, 64, BENCH_ITERATIONS);
+BENCH_ENTRY(memcpy_256, copy, 0, 256, BENCH_ITERATIONS);
+BENCH_ENTRY(memcpy_512, copy, 0, 512, BENCH_ITERATIONS);
+BENCH_ENTRY(memcpy_1024, copy, 0, 1024, BENCH_ITERATIONS);
+BENCH_ENTRY(memcpy_4096, copy, 0, 4096, BENCH_ITERATIONS);
+BENCH_ENTRY(memcpy_16384, copy, 0, 16384, 16);
+
+static void fill(uint32_t iterations, uint32_t size) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        memset(destination, i, size);
+    }
+}
+BENCH_ENTRY(memset_16, fill, 0, 16, BENCH_ITERATIONS);
+BENCH_ENTRY(memset_64, fill, 0, 64, BENCH_ITERATIONS);
+BENCH_ENTRY(memset_256, fill, 0, 256, BENCH_ITERATIONS);
+BENCH_ENTRY(memset_512, fill, 0, 512, BENCH_ITERATIONS);
+BENCH_ENTRY(memset_1024, fill, 0, 1024, BENCH_ITERATIONS);
+BENCH_ENTRY(memset_4096, fill, 0, 4096, BENCH_ITERATIONS);
+BENCH_ENTRY(memset_16384, fill, 0, 16384, 16);
+
+BENCH(memmove_overlap_1024) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        memmove(destination + 1, destination, 1024);
+    }
+}
+
+BENCH(memcmp_equal_256) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        bench_sink += memcmp(destination, destination + 4096, 256);
+    }
+}
\ No newline at end of file
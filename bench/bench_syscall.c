@@ -0,0 +1,69 @@
+#include "bench.h"
+#include "../include/string.h"
+#include "../kernel/syscall/syscall.h"
+#include "../mm/paging/paging.h"
+#include "../mm/physical/pmm.h"
+
+/* System call round trips from ring 3: the user code (bench_syscall_user.s) makes gettid system calls through int 0x80
+ * or sysenter, then exits. Each trial also enters and leaves user mode once, which the many iterations spread out. On
+ * a processor without sysenter the sysenter benchmark measures nothing. */
+
+#define BENCH_SYSCALL_ITERATIONS    1024
+
+// The user code and its stack are mapped into the kernel page directory, which the boot thread runs on.
+#define BENCH_USER_CODE             0x40000000
+#define BENCH_USER_STACK            0x40001000
+
+#define BENCH_PATH_INT80            0
+#define BENCH_PATH_SYSENTER         1
+
+// Defined in bench_syscall_user.s
+extern uint8_t bench_user_start[];
+extern uint8_t bench_user_int80[];
+extern uint8_t bench_user_sysenter[];
+extern uint8_t bench_user_end[];
+
+static int user_mapped;
+
+/** prepare_user:
+ *  Maps the user code and stack, once the first system call benchmark is prepared.
+ */
+static void prepare_user(uint32_t arg) {
+    uint32_t *directory = paging_kernel_directory();
+    uint32_t code, stack;
+
+    (void) arg;
+
+    if (user_mapped) {
+        return;
+    }
+    code = pmm_alloc_frame();
+    stack = pmm_alloc_frame();
+    if (code == 0 || stack == 0) {
+        if (code) {
+            pmm_free_frame(code);
+        }
+        if (stack) {
+            pmm_free_frame(stack);
+        }
+        return;
+    }
+
+    memcpy(phys_to_virt(code), bench_user_start, bench_user_end - bench_user_start);
+    if (paging_map_page(directory, BENCH_USER_CODE, code, PTE_USER) != 0 ||
+        paging_map_page(directory, BENCH_USER_STACK, stack, PTE_USER | PTE_WRITABLE) != 0) {
+        return;
+    }
+    user_mapped = 1;
+}
+
+static void syscall_round_trip(uint32_t iterations, uint32_t path) {
+    uint8_t *entry = path == BENCH_PATH_SYSENTER ? bench_user_sysenter : bench_user_int80;
+
+    if (!user_mapped || (path == BENCH_PATH_SYSENTER && !syscall_has_sysenter())) {
+        return;
+    }
+    bench_sink += user_enter(BENCH_USER_CODE + (entry - bench_user_start), BENCH_USER_STACK + PAGE_SIZE, iterations);
+}
+BENCH_ENTRY(syscall_int80, syscall_round_trip, prepare_user, BENCH_PATH_INT80, BENCH_SYSCALL_ITERATIONS);
+BENCH_ENTRY(syscall_sysenter, syscall_round_trip, prepare_user, BENCH_PATH_SYSENTER, BENCH_SYSCALL_ITERATIONS);
\ No newline at end of file
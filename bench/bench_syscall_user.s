@@ -0,0 +1,46 @@
+global bench_user_start     ; make the labels visible outside this file
+global bench_user_int80
+global bench_user_sysenter
+global bench_user_end
+
+SYSCALL_EXIT equ 0                  ; see syscall.h
+SYSCALL_GETTID equ 3
+
+section .text
+
+; User code of the system call benchmarks (bench_syscall.c), copied to a user page. It is position independent: only
+; relative jumps and calls. Both entry points make eax gettid system calls, then exit with status 0.
+bench_user_start:
+
+; bench_user_int80 - The int 0x80 path.
+bench_user_int80:
+    mov   esi, eax                  ; iterations, the system call does not use esi
+.loop:
+    mov   eax, SYSCALL_GETTID
+    int   0x80
+    dec   esi
+    jnz   .loop
+    jmp   bench_user_exit
+
+; bench_user_sysenter - The sysenter path. sysexit returns to the address in edx with the stack pointer in ecx.
+bench_user_sysenter:
+    mov   esi, eax                  ; iterations
+    call  .base                     ; the address of .return, computed relative to the return address of the call
+.base:
+    pop   edi
+    add   edi, .return - .base
+.loop:
+    mov   eax, SYSCALL_GETTID
+    mov   ecx, esp
+    mov   edx, edi
+    sysenter
+.return:
+    dec   esi
+    jnz   .loop
+
+bench_user_exit:
+    mov   eax, SYSCALL_EXIT
+    xor   ebx, ebx                  ; status 0
+    int   0x80
+
+bench_user_end:
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include "apic.h"
+#include "lapic.h"
+#include "ioapic.h"
+#include "../pic/pic.h"
+#include "../../kernel/acpi/acpi.h"
+#include "../../kernel/cpu/cpu.h"
+#include "../../kernel/log/log.h"
+
+/** init_apic:
+ *  Moves the IRQ lines from the 8259 PICs to the IO APIC, if the MADT describes one and the processor has a local
+ *  APIC. Otherwise the lines stay on the 8259, as init_idt remapped it. Called after init_idt and init_acpi, before
+ *  the drivers request their IRQ lines.
+ *
+ *  @return 0 if the APICs are used, -1 if the 8259 is kept
+ */
+int init_apic() {
+    const struct acpi_madt_info *madt = acpi_get_madt();
+    uint32_t flags;
+
+    if (madt == 0 || madt->ioapic_count == 0) {
+        return -1;
+    }
+
+    flags = irq_save();
+    if (init_lapic(madt->lapic_address) != 0 || init_ioapic(madt, lapic_id()) != 0) {
+        irq_restore(flags);
+        return -1;
+    }
+
+    // The 8259 stays remapped above the exceptions, so a spurious interrupt it may still raise is harmless.
+    pic_disable();
+    for (unsigned int irq = 0; irq < IRQ_LINES; irq++) {
+        if (ioapic_routes_irq(irq)) {
+            irq_set_chip(irq, &ioapic_chip);
+        }
+    }
+    irq_restore(flags);
+
+    log_info("APIC: IRQ lines routed through the IO APIC, 8259 disabled");
+    return 0;
+}
\ No newline at end of file
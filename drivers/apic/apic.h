@@ -0,0 +1,6 @@
+#ifndef __APIC_H__
+#define __APIC_H__
+
+int init_apic();
+
+#endif
\ No newline at end of file
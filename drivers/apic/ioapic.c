@@ -0,0 +1,147 @@
+#include "ioapic.h"
+#include "lapic.h"
+#include "../../mm/paging/paging.h"
+
+/* IO APIC
+ *
+ * The IO APIC receives the interrupts of the devices on its inputs (the global system interrupts, GSI) and sends them
+ * to the local APICs, as programmed in its redirection table. The ISA IRQs are routed to the vectors the 8259 used,
+ * IRQ_BASE_VECTOR + irq, so the IRQ lines keep their numbers; the MADT tells which input each IRQ is wired to, IRQ 0
+ * usually arrives on input 2.
+ *
+ * The EOI goes to the local APIC. */
+
+static struct ioapic ioapics[ACPI_MAX_IOAPICS];
+static int ioapic_count;
+// Redirection entry (low half) and input of each ISA IRQ
+static uint32_t irq_entries[IRQ_LINES];
+static uint32_t irq_gsi[IRQ_LINES];
+
+static uint32_t ioapic_read(struct ioapic *ioapic, uint32_t reg) {
+    ioapic->registers[IOAPIC_REGSEL / 4] = reg;
+    return ioapic->registers[IOAPIC_WINDOW / 4];
+}
+
+static void ioapic_write(struct ioapic *ioapic, uint32_t reg, uint32_t value) {
+    ioapic->registers[IOAPIC_REGSEL / 4] = reg;
+    ioapic->registers[IOAPIC_WINDOW / 4] = value;
+}
+
+/** ioapic_for_gsi:
+ *  Returns the IO APIC which has the given global system interrupt as input, 0 if none has.
+ */
+static struct ioapic *ioapic_for_gsi(uint32_t gsi) {
+    for (int i = 0; i < ioapic_count; i++) {
+        if (gsi >= ioapics[i].gsi_base && gsi < ioapics[i].gsi_base + ioapics[i].inputs) {
+            return &ioapics[i];
+        }
+    }
+    return 0;
+}
+
+/** ioapic_set_entry:
+ *  Writes the low half of the redirection entry of an ISA IRQ.
+ */
+static void ioapic_set_entry(unsigned int irq, uint32_t entry) {
+    struct ioapic *ioapic = ioapic_for_gsi(irq_gsi[irq]);
+
+    irq_entries[irq] = entry;
+    ioapic_write(ioapic, IOAPIC_REG_REDIRECTION + 2 * (irq_gsi[irq] - ioapic->gsi_base), entry);
+}
+
+/** isa_irq_overridden:
+ *  Checks whether the input an ISA IRQ would use by default is taken by another IRQ, e.g. input 2 by IRQ 0.
+ */
+static int isa_irq_overridden(const struct acpi_madt_info *madt, unsigned int irq) {
+    if (madt->isa_routes[irq].gsi != irq) {
+        return 0;
+    }
+    for (unsigned int other = 0; other < IRQ_LINES; other++) {
+        if (other != irq && madt->isa_routes[other].gsi == irq) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/** init_ioapic:
+ *  Masks all inputs of the IO APICs and programs the redirection entries of the ISA IRQs, masked until their lines
+ *  are unmasked through ioapic_chip.
+ *
+ *  @param madt        The IO APICs and the ISA IRQ routing
+ *  @param destination APIC ID of the processor which receives the interrupts
+ *  @return            0 on success, -1 if there is no usable IO APIC
+ */
+int init_ioapic(const struct acpi_madt_info *madt, uint32_t destination) {
+    for (int i = 0; i < madt->ioapic_count; i++) {
+        struct ioapic *ioapic = &ioapics[ioapic_count];
+
+        ioapic->registers = paging_map_mmio(madt->ioapics[i].address, IOAPIC_REGISTERS_SIZE);
+        if (ioapic->registers == 0) {
+            continue;
+        }
+        ioapic->gsi_base = madt->ioapics[i].gsi_base;
+        ioapic->inputs = ((ioapic_read(ioapic, IOAPIC_REG_VERSION) >> 16) & 0xFF) + 1;
+        for (uint32_t input = 0; input < ioapic->inputs; input++) {
+            ioapic_write(ioapic, IOAPIC_REG_REDIRECTION + 2 * input, IOAPIC_MASKED);
+        }
+        ioapic_count++;
+    }
+    if (ioapic_count == 0) {
+        return -1;
+    }
+
+    for (unsigned int irq = 0; irq < IRQ_LINES; irq++) {
+        const struct acpi_isa_route *route = &madt->isa_routes[irq];
+        struct ioapic *ioapic = ioapic_for_gsi(route->gsi);
+        uint32_t entry = IOAPIC_MASKED | (IRQ_BASE_VECTOR + irq);
+
+        irq_gsi[irq] = IOAPIC_NO_GSI;
+        if (ioapic == 0 || isa_irq_overridden(madt, irq)) {
+            continue;
+        }
+
+        // ISA interrupts are active high and edge triggered, unless the override says otherwise.
+        if ((route->flags & ACPI_POLARITY_MASK) == ACPI_POLARITY_LOW) {
+            entry |= IOAPIC_ACTIVE_LOW;
+        }
+        if ((route->flags & ACPI_TRIGGER_MASK) == ACPI_TRIGGER_LEVEL) {
+            entry |= IOAPIC_LEVEL_TRIGGERED;
+        }
+
+        irq_gsi[irq] = route->gsi;
+        ioapic_write(ioapic, IOAPIC_REG_REDIRECTION + 2 * (route->gsi - ioapic->gsi_base) + 1, destination << 24);
+        ioapic_set_entry(irq, entry);
+    }
+
+    return 0;
+}
+
+/** ioapic_routes_irq:
+ *  Checks whether an ISA IRQ is connected to an IO APIC input.
+ */
+int ioapic_routes_irq(unsigned int irq) {
+    return irq < IRQ_LINES && irq_gsi[irq] != IOAPIC_NO_GSI;
+}
+
+static void ioapic_chip_mask(unsigned int irq) {
+    ioapic_set_entry(irq, irq_entries[irq] | IOAPIC_MASKED);
+}
+
+static void ioapic_chip_unmask(unsigned int irq) {
+    ioapic_set_entry(irq, irq_entries[irq] & ~IOAPIC_MASKED);
+}
+
+static void ioapic_chip_eoi(unsigned int irq) {
+    (void) irq;
+    lapic_eoi();
+}
+
+// The IO APIC as the controller of the ISA IRQ lines. Spurious interrupts arrive on their own vector.
+struct irq_chip ioapic_chip = {
+    .name = "IO-APIC",
+    .mask = ioapic_chip_mask,
+    .unmask = ioapic_chip_unmask,
+    .eoi = ioapic_chip_eoi,
+    .is_spurious = 0,
+};
\ No newline at end of file
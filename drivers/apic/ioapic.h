@@ -0,0 +1,41 @@
+#ifndef __IOAPIC_H__
+#define __IOAPIC_H__
+
+#include "../../include/stdint.h"
+#include "../interrupts/irq.h"
+#include "../../kernel/acpi/acpi.h"
+
+#define IOAPIC_REGISTERS_SIZE   0x20
+
+// The registers are accessed indirectly: the index is written to IOREGSEL, the value read from or written to IOWIN.
+#define IOAPIC_REGSEL           0x00
+#define IOAPIC_WINDOW           0x10
+
+#define IOAPIC_REG_ID           0x00
+#define IOAPIC_REG_VERSION      0x01        /* bits 16 - 23: index of the last redirection entry */
+#define IOAPIC_REG_REDIRECTION  0x10        /* two registers per input, low half first */
+
+/* Redirection entry
+ * Bit:     | 63 .. 56 | 55 .. 17 | 16 | 15 | 14  | 13  | 12  | 11  | 10 .. 8 | 7 .. 0 |
+ * Content: |   dest   | reserved | M  | TM | IRR | POL | DS  | DM  |   DEL   | vector |
+ *
+ * M masks the input, TM selects level (1) or edge (0) triggering, POL active low (1) or high (0). With DM = 0
+ * (physical) and DEL = 0 (fixed), the vector is delivered to the local APIC whose ID is dest. */
+#define IOAPIC_MASKED           0x10000
+#define IOAPIC_LEVEL_TRIGGERED  0x08000
+#define IOAPIC_ACTIVE_LOW       0x02000
+
+#define IOAPIC_NO_GSI           0xFFFFFFFF
+
+struct ioapic {
+    volatile uint32_t *registers;
+    uint32_t gsi_base;
+    uint32_t inputs;
+};
+
+int init_ioapic(const struct acpi_madt_info *madt, uint32_t destination);
+int ioapic_routes_irq(unsigned int irq);
+
+extern struct irq_chip ioapic_chip;
+
+#endif
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "lapic.h"
+#include "../interrupts/isr.h"
+#include "../timer/pit.h"
+#include "../../include/div64.h"
+#include "../../kernel/cpu/cpu.h"
+#include "../../kernel/log/log.h"
+#include "../../kernel/time/ktime.h"
+#include "../../kernel/time/timer.h"
+#include "../../mm/paging/paging.h"
+
+/* Local APIC
+ *
+ * Every processor has a local APIC, which receives the interrupts routed to the processor (from the IO APIC, other
+ * processors, or its own timer) and delivers them by priority. Its registers are memory mapped, so the EOI of an
+ * interrupt is a single store instead of the port writes the 8259 needs.
+ *
+ * The local APIC timer counts down at the bus clock, which has no known frequency; it is calibrated against the PIT
+ * and then serves as the one-shot clock event of the timers, each processor programming its own. */
+
+static volatile uint32_t *lapic_registers;
+static uint32_t timer_ticks_per_second;
+
+static inline uint32_t lapic_read(uint32_t reg) {
+    return lapic_registers[reg / 4];
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t value) {
+    lapic_registers[reg / 4] = value;
+}
+
+/** lapic_timer_handler:
+ *  Handles the interrupt of the local APIC timer.
+ */
+static void lapic_timer_handler() {
+    timer_interrupt();
+    lapic_eoi();
+}
+
+/** lapic_timer_program:
+ *  Starts the local APIC timer of the running processor to interrupt once, after the given time.
+ *
+ *  @param delta Nanoseconds, at most the max_delta of lapic_clock_event
+ */
+static void lapic_timer_program(uint64_t delta) {
+    uint64_t count = delta * timer_ticks_per_second;
+
+    div64_u32(&count, NSEC_PER_SEC);
+    // An initial count of 0 stops the timer.
+    lapic_write(LAPIC_TIMER_INITIAL, count ? (uint32_t) count : 1);
+}
+
+/** lapic_timer_stop:
+ *  Stops the local APIC timer of the running processor.
+ */
+static void lapic_timer_stop() {
+    lapic_write(LAPIC_TIMER_INITIAL, 0);
+}
+
+static struct clock_event lapic_clock_event = {
+    .name = "local APIC",
+    .program = lapic_timer_program,
+    .stop = lapic_timer_stop,
+    .min_delta = LAPIC_TIMER_MIN_DELTA,
+};
+
+/** lapic_error_handler:
+ *  Reports the errors the local APIC found while sending or receiving interrupts.
+ */
+static void lapic_error_handler() {
+    uint32_t status;
+
+    // The status register is updated by a write, which also clears it.
+    lapic_write(LAPIC_ESR, 0);
+    status = lapic_read(LAPIC_ESR);
+    lapic_eoi();
+
+    log_error("Local APIC error, status 0x%x", status);
+}
+
+/** lapic_spurious_handler:
+ *  Handles the spurious interrupt, raised when an interrupt goes away before it is delivered. It is not in service
+ *  and must not be acknowledged; the vector statistics count it.
+ */
+static void lapic_spurious_handler() {
+}
+
+/** lapic_timer_calibrate:
+ *  Measures the frequency of the local APIC timer with the PIT.
+ */
+static void lapic_timer_calibrate() {
+    uint32_t elapsed;
+
+    lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_16);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED | LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_TIMER_INITIAL, 0xFFFFFFFF);
+    pit_busy_wait(LAPIC_CALIBRATION_TIME);
+    elapsed = 0xFFFFFFFF - lapic_read(LAPIC_TIMER_CURRENT);
+    lapic_write(LAPIC_TIMER_INITIAL, 0);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_VECTOR);
+
+    timer_ticks_per_second = elapsed * (1000000 / LAPIC_CALIBRATION_TIME);
+}
+
+/** lapic_init_cpu:
+ *  Enables the local APIC of the running processor. Its local interrupts stay masked, the interrupts of the devices
+ *  come through the IO APIC. Called by each processor for itself, after init_lapic mapped the registers.
+ */
+void lapic_init_cpu() {
+    // The firmware may have disabled the APIC globally, which hides its registers.
+    if (cpu_has_feature(CPU_FEATURE_MSR)) {
+        uint64_t base = rdmsr(MSR_APIC_BASE);
+
+        if (!(base & MSR_APIC_BASE_EN)) {
+            wrmsr(MSR_APIC_BASE, base | MSR_APIC_BASE_EN);
+        }
+    }
+
+    // LINT0 carries the 8259 in virtual wire mode, which is replaced by the IO APIC; LINT1 stays the NMI.
+    lapic_write(LAPIC_LVT_LINT0, LAPIC_LVT_MASKED);
+    // The timer in one-shot mode, stopped until the timers program it.
+    lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_16);
+    lapic_write(LAPIC_TIMER_INITIAL, 0);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_LVT_ERROR, LAPIC_ERROR_VECTOR);
+    lapic_write(LAPIC_ESR, 0);
+    lapic_write(LAPIC_ESR, 0);
+
+    // Accept interrupts of all priorities, and enable the APIC through the spurious interrupt register.
+    lapic_write(LAPIC_TPR, 0);
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+    lapic_eoi();
+}
+
+/** init_lapic:
+ *  Maps the local APIC registers, which every processor sees at the same address, and enables the local APIC of the
+ *  bootstrap processor.
+ *
+ *  @param physical_address Physical address of the registers, from the MADT
+ *  @return                 0 on success, -1 if the processor has no local APIC
+ */
+int init_lapic(uint32_t physical_address) {
+    if (!cpu_has_feature(CPU_FEATURE_APIC)) {
+        return -1;
+    }
+    if (physical_address == 0) {
+        physical_address = LAPIC_DEFAULT_ADDRESS;
+    }
+
+    lapic_registers = paging_map_mmio(physical_address, LAPIC_REGISTERS_SIZE);
+    if (lapic_registers == 0) {
+        return -1;
+    }
+
+    register_interrupt_handler(LAPIC_TIMER_VECTOR, lapic_timer_handler);
+    register_interrupt_handler(LAPIC_ERROR_VECTOR, lapic_error_handler);
+    register_interrupt_handler(LAPIC_SPURIOUS_VECTOR, lapic_spurious_handler);
+
+    lapic_init_cpu();
+    lapic_timer_calibrate();
+
+    return 0;
+}
+
+/** lapic_enabled:
+ *  Checks whether init_lapic enabled the local APIC.
+ */
+int lapic_enabled() {
+    return lapic_registers != 0;
+}
+
+/** lapic_id:
+ *  Returns the APIC ID of the running processor.
+ */
+uint32_t lapic_id() {
+    return lapic_read(LAPIC_ID) >> 24;
+}
+
+/** lapic_eoi:
+ *  Signals the end of the interrupt in service. For a level triggered interrupt, the EOI is also broadcast to the IO
+ *  APIC, which can then deliver the line again.
+ */
+void lapic_eoi() {
+    lapic_write(LAPIC_EOI, 0);
+}
+
+/** lapic_send_ipi:
+ *  Sends an inter-processor interrupt and waits until the local APIC has delivered it.
+ *
+ *  @param apic_id APIC ID of the target processor
+ *  @param command Low half of the interrupt command: delivery mode, level and vector
+ */
+static void lapic_send_ipi(uint32_t apic_id, uint32_t command) {
+    lapic_write(LAPIC_ICR_HIGH, apic_id << 24);
+    // Writing the low half sends the interrupt.
+    lapic_write(LAPIC_ICR_LOW, command);
+    while (lapic_read(LAPIC_ICR_LOW) & LAPIC_ICR_PENDING) {
+        asm volatile("pause");
+    }
+}
+
+/** lapic_send_init:
+ *  Sends an INIT IPI, which resets the target processor into its wait-for-startup state.
+ */
+void lapic_send_init(uint32_t apic_id) {
+    lapic_send_ipi(apic_id, LAPIC_ICR_INIT | LAPIC_ICR_LEVEL_ASSERT);
+}
+
+/** lapic_send_fixed:
+ *  Sends an interrupt with the given vector to another processor.
+ */
+void lapic_send_fixed(uint32_t apic_id, uint8_t vector) {
+    lapic_send_ipi(apic_id, LAPIC_ICR_FIXED | vector);
+}
+
+/** lapic_send_startup:
+ *  Sends a startup IPI, which starts a processor waiting for startup in real mode at address vector << 12.
+ */
+void lapic_send_startup(uint32_t apic_id, uint8_t vector) {
+    lapic_send_ipi(apic_id, LAPIC_ICR_STARTUP | vector);
+}
+
+/** lapic_timer_init:
+ *  Makes the local APIC timer the clock event of the timers.
+ *
+ *  @return 0 on success, -1 if the local APIC is not enabled or its timer could not be calibrated
+ */
+int lapic_timer_init() {
+    uint64_t max_delta = 0xFFFFFFFFULL * NSEC_PER_SEC;
+
+    if (lapic_registers == 0 || timer_ticks_per_second < NSEC_PER_SEC / LAPIC_TIMER_MIN_DELTA) {
+        return -1;
+    }
+
+    // The 32-bit counter limits the longest interrupt delay.
+    div64_u32(&max_delta, timer_ticks_per_second);
+    lapic_clock_event.max_delta = max_delta;
+    timer_set_clock_event(&lapic_clock_event);
+
+    log_info("Local APIC timer: %u Hz", timer_ticks_per_second);
+    return 0;
+}
\ No newline at end of file
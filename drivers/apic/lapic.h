@@ -0,0 +1,59 @@
+#ifndef __LAPIC_H__
+#define __LAPIC_H__
+
+#include "../../include/stdint.h"
+
+#define LAPIC_DEFAULT_ADDRESS   0xFEE00000
+#define LAPIC_REGISTERS_SIZE    0x400
+
+// Register offsets, every register is 32 bits wide and 16-byte aligned.
+#define LAPIC_ID                0x020
+#define LAPIC_VERSION           0x030
+#define LAPIC_TPR               0x080       /* Task Priority Register */
+#define LAPIC_EOI               0x0B0
+#define LAPIC_SVR               0x0F0       /* Spurious interrupt Vector Register */
+#define LAPIC_ESR               0x280       /* Error Status Register */
+#define LAPIC_ICR_LOW           0x300       /* Interrupt Command Register */
+#define LAPIC_ICR_HIGH          0x310
+#define LAPIC_LVT_TIMER         0x320
+#define LAPIC_LVT_LINT0         0x350
+#define LAPIC_LVT_LINT1         0x360
+#define LAPIC_LVT_ERROR         0x370
+#define LAPIC_TIMER_INITIAL     0x380
+#define LAPIC_TIMER_CURRENT     0x390
+#define LAPIC_TIMER_DIVIDE      0x3E0
+
+#define LAPIC_SVR_ENABLE        0x100
+#define LAPIC_LVT_MASKED        0x10000
+#define LAPIC_TIMER_PERIODIC    0x20000
+#define LAPIC_TIMER_DIVIDE_16   0x03
+
+// Interrupt command: delivery mode (bits 8 - 10), delivery status and level
+#define LAPIC_ICR_FIXED         0x00000
+#define LAPIC_ICR_INIT          0x00500
+#define LAPIC_ICR_STARTUP       0x00600
+#define LAPIC_ICR_PENDING       0x01000     /* the previous interrupt has not been sent yet */
+#define LAPIC_ICR_LEVEL_ASSERT  0x04000
+
+// Vectors of the interrupts the local APIC raises itself, above the IRQ lines.
+#define LAPIC_TIMER_VECTOR      0xF0
+#define LAPIC_RESCHEDULE_VECTOR 0xF1        /* sent by the scheduler to make another processor reschedule */
+#define LAPIC_ERROR_VECTOR      0xFE
+#define LAPIC_SPURIOUS_VECTOR   0xFF
+
+// The timer is calibrated by counting its decrements during a PIT busy wait.
+#define LAPIC_CALIBRATION_TIME  10000       /* microseconds */
+// Shortest delay the timer is programmed for, so that a deadline in the past still leaves time to return.
+#define LAPIC_TIMER_MIN_DELTA   1000        /* nanoseconds */
+
+int init_lapic(uint32_t physical_address);
+void lapic_init_cpu();
+int lapic_enabled();
+uint32_t lapic_id();
+void lapic_eoi();
+void lapic_send_init(uint32_t apic_id);
+void lapic_send_startup(uint32_t apic_id, uint8_t vector);
+void lapic_send_fixed(uint32_t apic_id, uint8_t vector);
+int lapic_timer_init();
+
+#endif
\ No newline at end of file
@@ -1,10 +1,61 @@
 #include "framebuffer.h"
-#include "../../include/string.h"
 #include "../../include/stdint.h"
 #include "../io/io.h"
-#include "../../include/stdarg.h"
+#include "../../kernel/cpu/cpu.h"
+#include "../../kernel/sync/spinlock.h"
 
-static char *fb = (char *) FRAME_BUFFER_ADDRESS;
+/* Text is not written to the video memory directly. The console is kept in RAM as a ring of FB_SCROLLBACK_LINES
+ * lines, the last FB_HEIGHT of which form the screen. Scrolling advances the index of the first screen line in the
+ * ring and clears one line, its cost does not depend on the depth of the history. The window shown on the screen is
+ * either the screen itself or, while scrolled back, FB_HEIGHT older lines.
+ *
+ * The rows of the window changed since the last flush are marked dirty. fb_flush copies the dirty rows to the video
+ * memory with 32-bit stores and moves the hardware cursor; the writers flush once per call, so a whole string costs
+ * one pass over the uncached video memory and four port writes, whatever its length.
+ *
+ * The shadow buffer, the ring indices, the dirty rows and the cursor are protected by fb_lock, taken with the
+ * interrupts disabled by every public function: the keyboard interrupt echoes and scrolls on whichever processor it
+ * arrives, next to the console writers of the other processors. The static helpers expect the lock held. */
+
+#define FB_BLANK_CELL   ((FB_BLACK << 12) | (FB_WHITE << 8) | ' ')
+
+static volatile uint32_t *vram = (volatile uint32_t *) FRAME_BUFFER_ADDRESS;
+static uint16_t lines[FB_SCROLLBACK_LINES][FB_WIDTH];
+static unsigned int top;                // ring index of the first screen line
+static unsigned int history;            // lines above the screen which can be scrolled back to
+static unsigned int view;               // lines the window is scrolled back by, 0 shows the screen
+static uint32_t dirty_rows;             // bit n is set when row n of the window changed
+static uint16_t cursor;                 // cell of the cursor on the screen
+static uint16_t hw_cursor = 0xFFFF;     // cell the hardware cursor was last moved to
+static struct spinlock fb_lock = SPINLOCK_INIT;
+
+/** fb_line:
+ *  Returns the line shown in a row of the window scrolled back by the given number of lines, 0 for the screen.
+ */
+static inline uint16_t *fb_line(unsigned int row, unsigned int back) {
+    return lines[(top + FB_SCROLLBACK_LINES - back + row) % FB_SCROLLBACK_LINES];
+}
+
+/** fb_show_screen:
+ *  Scrolls the window back down to the screen, so that output becomes visible.
+ */
+static inline void fb_show_screen() {
+    if (view) {
+        view = 0;
+        dirty_rows = (1u << FB_HEIGHT) - 1;
+    }
+}
+
+/** fb_set_cell:
+ *  Stores a character in the shadow buffer at position i, see fb_write_cell.
+ */
+static void fb_set_cell(unsigned int i, char c, unsigned char fg, unsigned char bg) {
+    unsigned int row = i / 2 / FB_WIDTH;
+
+    fb_show_screen();
+    fb_line(row, 0)[i / 2 % FB_WIDTH] = (((bg & 0x0F) << 4 | (fg & 0x0F)) << 8) | (unsigned char) c;
+    dirty_rows |= 1u << row;
+}
 
 /** fb_write_cell:
  *  Writes a character with the given foreground and background to position i in the frame buffer.
@@ -18,8 +69,10 @@ static char *fb = (char *) FRAME_BUFFER_ADDRESS;
  *  Content: |      BG     |     FG    |      ASCII      |
  */
 void fb_write_cell(unsigned int i, char c, unsigned char fg, unsigned char bg) {
-    fb[i] = c;
-    fb[i + 1] = ((bg & 0x0F) << 4) | (fg & 0x0F);
+    uint32_t flags = spin_lock_irqsave(&fb_lock);
+
+    fb_set_cell(i, c, fg, bg);
+    spin_unlock_irqrestore(&fb_lock, flags);
 }
 
 /** fb_move_cursor:
@@ -32,50 +85,137 @@ void fb_move_cursor(unsigned short pos) {
      * with a 16 bits integer: 0 means row zero, column zero; 1 means row zero, column one; 80 means row one,column zero
      * and so on.
      *
-     * Since the position is 16 bits large,and the out assembly code instruction argument is 8 bits, the position must
-     * be sent in two turns, first 8 bits then the next 8 bits. The framebuffer has two I/O ports, one for accepting
-     * the data,and one for describing the data being received. FB_COMMAND_PORT is the port that describes the data and
-     * port FB_DATA_PORT is for the data itself */
-    outb(FB_COMMAND_PORT, FB_HIGH_BYTE_COMMAND);
-    outb(FB_DATA_PORT, ((pos >> 8) & 0x00FF));
-    outb(FB_COMMAND_PORT, FB_LOW_BYTE_COMMAND);
-    outb(FB_DATA_PORT, pos & 0x00FF);
+     * The position is sent in two registers of the CRT controller, first the high 8 bits then the low 8 bits. The
+     * controller has two I/O ports, FB_COMMAND_PORT selects the register and FB_DATA_PORT, the next port, takes its
+     * value; a 16-bit write to FB_COMMAND_PORT sends the register index and the value in one instruction. */
+    outw(FB_COMMAND_PORT, FB_HIGH_BYTE_COMMAND | (pos & 0xFF00));
+    outw(FB_COMMAND_PORT, FB_LOW_BYTE_COMMAND | ((pos & 0x00FF) << 8));
+}
+
+/** fb_update:
+ *  Copies the dirty rows of the window to the video memory and moves the hardware cursor if the cursor moved. The
+ *  cursor is hidden while the window is scrolled back.
+ */
+static void fb_update() {
+    while (dirty_rows) {
+        unsigned int row = __builtin_ctz(dirty_rows);
+        const uint32_t *src = (const uint32_t *) fb_line(row, view);
+        volatile uint32_t *dst = vram + row * (FB_WIDTH / 2);
+
+        // Two cells per store.
+        for (int i = 0; i < FB_WIDTH / 2; i++) {
+            dst[i] = src[i];
+        }
+        dirty_rows &= ~(1u << row);
+    }
+
+    // A position past the end of the screen hides the cursor.
+    uint16_t position = view ? FB_WIDTH * FB_HEIGHT : cursor;
+    if (position != hw_cursor) {
+        fb_move_cursor(position);
+        hw_cursor = position;
+    }
+}
+
+/** fb_flush:
+ *  Writes the changes of the shadow buffer to the screen, see fb_update.
+ */
+void fb_flush() {
+    uint32_t flags = spin_lock_irqsave(&fb_lock);
+
+    fb_update();
+    spin_unlock_irqrestore(&fb_lock, flags);
 }
 
 /** fb_clear:
  *  Clears the frame buffer
  */
 void fb_clear() {
+    uint32_t flags = spin_lock_irqsave(&fb_lock);
+
     for(int i=0; i < FB_WIDTH * FB_HEIGHT; i++) {
-        fb_write_cell(i * 2, ' ', FB_BLACK, FB_BLACK);
+        fb_set_cell(i * 2, ' ', FB_BLACK, FB_BLACK);
     }
-    fb_move_cursor(0);
+    history = 0;
+    cursor = 0;
+    fb_update();
+    spin_unlock_irqrestore(&fb_lock, flags);
 }
 
-/** get_cursor_loc:
- *  Returns the cursor position.
+/** fb_scroll_down:
+ *  Scrolls the screen by one line: the first screen line moves into the history and a blank line is added at the
+ *  bottom.
+ */
+static void fb_scroll_down() {
+    uint16_t *line;
+
+    fb_show_screen();
+    top = (top + 1) % FB_SCROLLBACK_LINES;
+    if (history < FB_SCROLLBACK_LINES - FB_HEIGHT) {
+        history++;
+    }
+
+    // The new last line reuses the oldest line of the ring.
+    line = fb_line(FB_HEIGHT - 1, 0);
+    for (int i = 0; i < FB_WIDTH; i++) {
+        line[i] = FB_BLANK_CELL;
+    }
+    dirty_rows = (1u << FB_HEIGHT) - 1;
+}
+
+/** fb_scrollback:
+ *  Scrolls the window through the history, e.g. on Shift+PgUp/PgDn.
  *
- *  @return cursor position
+ *  @param delta Number of lines to scroll back, negative to scroll towards the screen
  */
-uint16_t get_cursor_loc() {
-    uint16_t pos = 0;
+void fb_scrollback(int delta) {
+    uint32_t flags = spin_lock_irqsave(&fb_lock);
+    int target = (int) view + delta;
+
+    if (target < 0) {
+        target = 0;
+    }
+    if (target > (int) history) {
+        target = history;
+    }
+    if ((unsigned int) target != view) {
+        view = target;
+        dirty_rows = (1u << FB_HEIGHT) - 1;
+        fb_update();
+    }
+    spin_unlock_irqrestore(&fb_lock, flags);
+}
 
-    outb(FB_COMMAND_PORT, CURSOR_LOCATION_LOW);
-    pos |= inb(FB_DATA_PORT);
-    outb(FB_COMMAND_PORT, CURSOR_LOCATION_HIGH);
-    pos |= inb(FB_DATA_PORT) << 8;
+/** fb_put_char:
+ *  Writes a character to the shadow buffer at the cursor and advances the cursor, without flushing.
+ *
+ *  @param c Character
+ */
+static void fb_put_char(char c) {
+    fb_show_screen();
+    if (cursor >= FB_WIDTH * FB_HEIGHT) {
+        fb_scroll_down();
+        cursor -= FB_WIDTH;
+    }
 
-    return pos;
+    if (c == '\n') {
+        cursor = (cursor + FB_WIDTH) - (cursor % FB_WIDTH);
+    }
+    else {
+        fb_set_cell(cursor * 2, c, FB_WHITE, FB_BLACK);
+        cursor++;
+    }
 }
 
-/** fb_scroll_down:
- *  Shifts one row the framebuffer
+/** fb_put_str:
+ *  Writes a character array to the shadow buffer, without flushing.
+ *
+ *  @param buf Character array
  */
-void fb_scroll_down() {
-    // Each cell has 16 bits.
-    uint16_t *fb = (uint16_t *) FRAME_BUFFER_ADDRESS;
-    // One row can contain 80(FB_WIDTH) cell, shift one row framebuffer to add new line.
-    memmove(fb, fb + FB_WIDTH, (FB_WIDTH * 2) * (FB_HEIGHT * 2));
+static void fb_put_str(const char *buf) {
+    while (*buf) {
+        fb_put_char(*buf++);
+    }
 }
 
 /** fb_write_str:
@@ -84,24 +224,11 @@ void fb_scroll_down() {
  *  @param buf Character array
  */
 void fb_write_str(char *buf) {
-    uint16_t cursor_position = get_cursor_loc() * 2;
+    uint32_t flags = spin_lock_irqsave(&fb_lock);
 
-    for(size_t i=0; i < strlen(buf); i++) {
-        if(cursor_position >= FB_WIDTH * FB_HEIGHT * 2){
-            fb_scroll_down();
-            cursor_position -= FB_WIDTH * 2;
-        }
-
-        if (buf[i] == '\n') {
-            cursor_position = (cursor_position + FB_WIDTH * 2) - (cursor_position % (FB_WIDTH * 2));
-        }
-        else {
-            fb_write_cell(cursor_position, buf[i], FB_WHITE, FB_BLACK);
-            cursor_position += 2;
-        }
-    }
-
-    fb_move_cursor(cursor_position / 2);
+    fb_put_str(buf);
+    fb_update();
+    spin_unlock_irqrestore(&fb_lock, flags);
 }
 
 /** fb_write_char:
@@ -109,42 +236,25 @@ void fb_write_str(char *buf) {
  *  @param c Character
  */
 void fb_write_char(unsigned char c) {
-    char buf[] = {c, '\0'};
-    fb_write_str(buf);
+    uint32_t flags = spin_lock_irqsave(&fb_lock);
+
+    fb_put_char(c);
+    fb_update();
+    spin_unlock_irqrestore(&fb_lock, flags);
 }
 
-/** os_printf:
- *  Writes the string pointed by format to frame buffer. If format includes format specifiers
- *  (subsequences beginning with %), the additional arguments following format are formatted and inserted in the
- *  resulting string replacing their respective specifiers.
+/** fb_write:
+ *  Writes characters to the frame buffer.
  *
- * @param format C string that contains the text to be written to frame buffer.
+ *  @param buf The characters
+ *  @param len Number of characters
  */
-void os_printf(const char *format, ...) {
-    char buf[20];
-    va_list ap;
-    va_start(ap, format);
-
-    for(size_t i=0; i < strlen(format); i++) {
-        if(format[i] == '%') {
-            char *arg = '\0';
-
-            switch(format[++i]) {
-                case 'd':
-                    arg = itoa(va_arg(ap, int), buf, 10);
-                    break;
-                case 'x':
-                    arg = itoa(va_arg(ap, int), buf, 16);
-                    break;
-                default:
-                    break;
-            }
-            fb_write_str(arg);
-        }
-        else {
-            fb_write_char(format[i]);
-        }
-    }
+void fb_write(const char *buf, size_t len) {
+    uint32_t flags = spin_lock_irqsave(&fb_lock);
 
-    va_end(ap);
+    for (size_t i = 0; i < len; i++) {
+        fb_put_char(buf[i]);
+    }
+    fb_update();
+    spin_unlock_irqrestore(&fb_lock, flags);
 }
\ No newline at end of file
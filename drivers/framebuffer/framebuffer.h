@@ -1,6 +1,8 @@
 #ifndef __FRAMEBUFFER_H__
 #define __FRAMEBUFFER_H__
 
+#include "../../include/stddef.h"
+
 // Color codes for the frame buffer
 #define FB_BLACK          0
 #define FB_BLUE           1
@@ -19,11 +21,14 @@
 #define FB_LIGHT_BROWN    14
 #define FB_WHITE          15
 
-// 0x000B8000 is the starting address for the frame buffer
-#define FRAME_BUFFER_ADDRESS 0x000B8000
+// 0x000B8000 is the starting physical address for the frame buffer, it is reached through the direct map of the kernel.
+#define FRAME_BUFFER_ADDRESS 0xC00B8000
 #define FB_WIDTH 80
 #define FB_HEIGHT 25
 
+// Number of lines kept by the console, including the screen. Older lines can be scrolled back to.
+#define FB_SCROLLBACK_LINES 1000
+
 // The Framebuffer I/O ports
 #define FB_COMMAND_PORT         0x3D4
 #define FB_DATA_PORT            0x3D5
@@ -39,7 +44,9 @@
 void fb_write_cell(unsigned int i, char c, unsigned char fg, unsigned char bg);
 void fb_write_str(char *buf);
 void fb_clear();
-void os_printf(const char *format, ...);
 void fb_write_char(unsigned char c);
+void fb_write(const char *buf, size_t len);
+void fb_flush();
+void fb_scrollback(int delta);
 
 #endif
\ No newline at end of file
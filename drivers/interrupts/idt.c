@@ -1,7 +1,9 @@
 #include "idt.h"
 #include "isr.h"
+#include "irq.h"
 #include "../../include/string.h"
 #include "../pic/pic.h"
+#include "../../mm/segmentation/gdt.h"
 
 /* To aid in handling exceptions and interrupts, each architecturally defined exception and each interrupt condition
  * requiring special handling by the processor is assigned a unique identification number, called a vector number. The
@@ -39,6 +41,27 @@ void idt_set_gate(int32_t num, void(*base), uint16_t selector, unsigned g_type)
     idt_entries[num].offset_high = ((uint32_t)base >> 16) & 0xFFFF;
 }
 
+/** idt_set_dpl:
+ * Sets the privilege level a software interrupt needs to raise the given vector with the INT instruction. Gates are
+ * created with DPL 0, user code raising them gets a general protection fault.
+ *
+ * @param num The vector
+ * @param dpl The least privileged ring allowed to use the gate, 3 for user code
+ */
+void idt_set_dpl(int32_t num, unsigned dpl) {
+    idt_entries[num].dpl = dpl;
+}
+
+/** idt_set_trap:
+ * Turns the gate of the given vector into a 32-bit trap gate. The processor leaves the interrupts enabled when it
+ * enters the handler through a trap gate, an interrupt gate disables them.
+ *
+ * @param num The vector
+ */
+void idt_set_trap(int32_t num) {
+    idt_entries[num].gate_type = 0b1111;
+}
+
 /** init_idt:
  * This function will set up the special IDT pointer, set up the entries in our IDT, and then finally call
  * load_idt() to load IDT.
@@ -51,64 +74,28 @@ void init_idt() {
     // Clear out the entire IDT, initializing it to zeros.
     memset(&idt_entries, 0, sizeof(struct idt_entry) * 256);
 
-    /* Add the interrupts to the Interrupt Descriptor Table.
-     *
-     * base = The base address of the Interrupt Service Routine.
-     * selector = 0x08 is points to code segment in our GDT.
-     * gate type = 1110 (32-bit Interrupt Gate) */
-    idt_set_gate(0, interrupt_handler_0, 0x08, 0b1110);
-    idt_set_gate(1, interrupt_handler_1, 0x08, 0b1110);
-    idt_set_gate(2, interrupt_handler_2, 0x08, 0b1110);
-    idt_set_gate(3, interrupt_handler_3, 0x08, 0b1110);
-    idt_set_gate(4, interrupt_handler_4, 0x08, 0b1110);
-    idt_set_gate(5, interrupt_handler_5, 0x08, 0b1110);
-    idt_set_gate(6, interrupt_handler_6, 0x08, 0b1110);
-    idt_set_gate(7, interrupt_handler_7, 0x08, 0b1110);
-    idt_set_gate(8, interrupt_handler_8, 0x08, 0b1110);
-    idt_set_gate(9, interrupt_handler_9, 0x08, 0b1110);
-    idt_set_gate(10, interrupt_handler_10, 0x08, 0b1110);
-    idt_set_gate(11, interrupt_handler_11, 0x08, 0b1110);
-    idt_set_gate(12, interrupt_handler_12, 0x08, 0b1110);
-    idt_set_gate(13, interrupt_handler_13, 0x08, 0b1110);
-    idt_set_gate(14, interrupt_handler_14, 0x08, 0b1110);
-    idt_set_gate(15, interrupt_handler_15, 0x08, 0b1110);
-    idt_set_gate(16, interrupt_handler_16, 0x08, 0b1110);
-    idt_set_gate(17, interrupt_handler_17, 0x08, 0b1110);
-    idt_set_gate(18, interrupt_handler_18, 0x08, 0b1110);
-    idt_set_gate(19, interrupt_handler_19, 0x08, 0b1110);
-    idt_set_gate(20, interrupt_handler_20, 0x08, 0b1110);
-    idt_set_gate(21, interrupt_handler_21, 0x08, 0b1110);
-    idt_set_gate(22, interrupt_handler_22, 0x08, 0b1110);
-    idt_set_gate(23, interrupt_handler_23, 0x08, 0b1110);
-    idt_set_gate(24, interrupt_handler_24, 0x08, 0b1110);
-    idt_set_gate(25, interrupt_handler_25, 0x08, 0b1110);
-    idt_set_gate(26, interrupt_handler_26, 0x08, 0b1110);
-    idt_set_gate(27, interrupt_handler_27, 0x08, 0b1110);
-    idt_set_gate(28, interrupt_handler_28, 0x08, 0b1110);
-    idt_set_gate(29, interrupt_handler_29, 0x08, 0b1110);
-    idt_set_gate(30, interrupt_handler_30, 0x08, 0b1110);
-    idt_set_gate(31, interrupt_handler_31, 0x08, 0b1110);
-
     // Remap PIC to 0x20 and 0x28
     pic_remap(PIC1_START_INTERRUPT, PIC2_START_INTERRUPT);
+    init_irq();
 
-    idt_set_gate(32, interrupt_handler_32, 0x08, 0b1110);
-    idt_set_gate(33, interrupt_handler_33, 0x08, 0b1110);
-    idt_set_gate(34, interrupt_handler_34, 0x08, 0b1110);
-    idt_set_gate(35, interrupt_handler_35, 0x08, 0b1110);
-    idt_set_gate(36, interrupt_handler_36, 0x08, 0b1110);
-    idt_set_gate(37, interrupt_handler_37, 0x08, 0b1110);
-    idt_set_gate(38, interrupt_handler_38, 0x08, 0b1110);
-    idt_set_gate(39, interrupt_handler_39, 0x08, 0b1110);
-    idt_set_gate(40, interrupt_handler_40, 0x08, 0b1110);
-    idt_set_gate(41, interrupt_handler_41, 0x08, 0b1110);
-    idt_set_gate(42, interrupt_handler_42, 0x08, 0b1110);
-    idt_set_gate(43, interrupt_handler_43, 0x08, 0b1110);
-    idt_set_gate(44, interrupt_handler_44, 0x08, 0b1110);
-    idt_set_gate(45, interrupt_handler_45, 0x08, 0b1110);
-    idt_set_gate(46, interrupt_handler_46, 0x08, 0b1110);
-    idt_set_gate(47, interrupt_handler_47, 0x08, 0b1110);
+    /* Add the interrupts to the Interrupt Descriptor Table, every vector gets the stub generated for it in
+     * interrupt_handler.s.
+     *
+     * base = The base address of the Interrupt Service Routine.
+     * selector = The kernel code segment in our GDT.
+     * gate type = 1110 (32-bit Interrupt Gate) */
+    for (int vector = 0; vector < INTERRUPT_VECTORS; vector++) {
+        idt_set_gate(vector, interrupt_stub_table[vector], KERNEL_CODE_SELECTOR, 0b1110);
+    }
 
     // Points the processor's internal register to the new IDT.
     load_idt(&idt_ptr);
+}
+
+/** idt_load:
+ * Loads the IDT on the running processor. The processors share the IDT, init_idt builds it and loads it on the
+ * bootstrap processor.
+ */
+void idt_load() {
+    load_idt(&idt_ptr);
 }
\ No newline at end of file
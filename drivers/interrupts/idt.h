@@ -44,5 +44,8 @@ struct idt {
 } __attribute__((packed));
 
 void init_idt();
+void idt_set_dpl(int32_t num, unsigned dpl);
+void idt_set_trap(int32_t num);
+void idt_load();
 
 #endif
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include "irq.h"
+#include "../pic/pic.h"
+#include "../../kernel/cpu/cpu.h"
+#include "../../kernel/console/console.h"
+#include "../../mm/slab/slab.h"
+#include "../../include/div64.h"
+
+/* IRQ dispatch
+ *
+ * Each IRQ line has a chain of handlers, so several devices can share a line; every handler of the chain is called and
+ * reports whether its device raised the interrupt. The drivers do not talk to the interrupt controller: the line is
+ * unmasked when its first handler is requested, and the EOI is sent once the chain has run, through the irq_chip of
+ * the line. Spurious interrupts (IRQ 7 and IRQ 15 of the 8259) are detected through the chip and never reach the
+ * handlers. When the machine has an IO APIC, init_apic moves the lines to its chip.
+ *
+ * interrupt_handler measures every interrupt with the time stamp counter; the count, the cycles and a histogram of
+ * the cycles are kept per vector and printed by irq_print_stats. */
+
+static struct irq_desc irq_descs[IRQ_LINES];
+static struct interrupt_stats vector_stats[INTERRUPT_VECTORS];
+
+/** init_irq:
+ *  Puts all IRQ lines on the 8259 PIC. Called by init_idt once the PIC is remapped.
+ */
+void init_irq() {
+    for (int i = 0; i < IRQ_LINES; i++) {
+        irq_descs[i].chip = &pic_chip;
+    }
+}
+
+/** irq_set_chip:
+ *  Moves an IRQ line to another interrupt controller. A line with handlers is masked on the old controller and
+ *  unmasked on the new one.
+ */
+void irq_set_chip(unsigned int irq, struct irq_chip *chip) {
+    struct irq_desc *desc;
+    uint32_t flags;
+
+    if (irq >= IRQ_LINES) {
+        return;
+    }
+    desc = &irq_descs[irq];
+
+    flags = irq_save();
+    if (desc->actions && desc->chip) {
+        desc->chip->mask(irq);
+    }
+    desc->chip = chip;
+    if (desc->actions && chip) {
+        chip->unmask(irq);
+    }
+    irq_restore(flags);
+}
+
+/** request_irq:
+ *  Adds a handler to an IRQ line and unmasks the line.
+ *
+ *  @param irq     The IRQ line
+ *  @param handler Called for each interrupt of the line, returns IRQ_HANDLED if its device raised it
+ *  @param name    Name shown in the statistics. The string is not copied.
+ *  @param dev     Passed to the handler, and identifies the handler for free_irq
+ *  @return        0 on success, -1 if the line is invalid or the memory is exhausted
+ */
+int request_irq(unsigned int irq, irq_handler_t handler, const char *name, void *dev) {
+    struct irq_action *action;
+    struct irq_action **link;
+    uint32_t flags;
+
+    if (irq >= IRQ_LINES || handler == 0) {
+        return -1;
+    }
+    action = kmalloc(sizeof(struct irq_action));
+    if (action == 0) {
+        return -1;
+    }
+    action->handler = handler;
+    action->dev = dev;
+    action->name = name;
+    action->next = 0;
+
+    flags = irq_save();
+    for (link = &irq_descs[irq].actions; *link; link = &(*link)->next);
+    *link = action;
+    if (irq_descs[irq].chip) {
+        irq_descs[irq].chip->unmask(irq);
+    }
+    irq_restore(flags);
+
+    return 0;
+}
+
+/** free_irq:
+ *  Removes the handler of a device from an IRQ line. The line is masked when its last handler is removed.
+ *
+ *  @param irq The IRQ line
+ *  @param dev The dev passed to request_irq
+ */
+void free_irq(unsigned int irq, void *dev) {
+    struct irq_action *action = 0;
+    struct irq_action **link;
+    uint32_t flags;
+
+    if (irq >= IRQ_LINES) {
+        return;
+    }
+
+    flags = irq_save();
+    for (link = &irq_descs[irq].actions; *link; link = &(*link)->next) {
+        if ((*link)->dev == dev) {
+            action = *link;
+            *link = action->next;
+            break;
+        }
+    }
+    if (irq_descs[irq].actions == 0 && irq_descs[irq].chip) {
+        irq_descs[irq].chip->mask(irq);
+    }
+    irq_restore(flags);
+
+    kfree(action);
+}
+
+/** irq_dispatch:
+ *  Runs the handlers of an IRQ line and sends the EOI. Called by interrupt_handler with the interrupts disabled.
+ *
+ *  @param irq The IRQ line
+ */
+void irq_dispatch(unsigned int irq) {
+    struct irq_desc *desc = &irq_descs[irq];
+    int handled = IRQ_NONE;
+
+    if (desc->chip && desc->chip->is_spurious && desc->chip->is_spurious(irq)) {
+        desc->spurious++;
+        return;
+    }
+
+    for (struct irq_action *action = desc->actions; action; action = action->next) {
+        handled |= action->handler(irq, action->dev);
+    }
+    if (handled == IRQ_NONE) {
+        desc->unhandled++;
+    }
+
+    if (desc->chip) {
+        desc->chip->eoi(irq);
+    }
+}
+
+/** interrupt_account:
+ *  Adds an interrupt to the statistics of its vector.
+ *
+ *  @param vector The interrupt vector
+ *  @param cycles Cycles spent handling the interrupt
+ */
+void interrupt_account(unsigned int vector, uint32_t cycles) {
+    struct interrupt_stats *stats = &vector_stats[vector & (INTERRUPT_VECTORS - 1)];
+    int bucket = 0;
+
+    if (cycles >> IRQ_HISTOGRAM_SHIFT) {
+        bucket = 31 - __builtin_clz(cycles) - IRQ_HISTOGRAM_SHIFT;
+        if (bucket >= IRQ_HISTOGRAM_BUCKETS) {
+            bucket = IRQ_HISTOGRAM_BUCKETS - 1;
+        }
+    }
+
+    stats->count++;
+    stats->cycles += cycles;
+    if (cycles > stats->max_cycles) {
+        stats->max_cycles = cycles;
+    }
+    stats->histogram[bucket]++;
+}
+
+/** interrupt_get_stats:
+ *  Returns the statistics of an interrupt vector.
+ */
+const struct interrupt_stats *interrupt_get_stats(unsigned int vector) {
+    return &vector_stats[vector & (INTERRUPT_VECTORS - 1)];
+}
+
+/** irq_print_stats:
+ *  Writes the statistics of every vector which was hit, and the handlers of the IRQ lines, to the console.
+ */
+void irq_print_stats() {
+    os_printf("vec irq      count  avg cycles  max cycles spurious unhandled handlers\n");
+
+    for (unsigned int vector = 0; vector < INTERRUPT_VECTORS; vector++) {
+        const struct interrupt_stats *stats = &vector_stats[vector];
+        unsigned int irq = vector - IRQ_BASE_VECTOR;
+        uint64_t average = stats->cycles;
+
+        if (stats->count == 0) {
+            continue;
+        }
+        div64_u32(&average, stats->count);
+
+        if (irq < IRQ_LINES) {
+            struct irq_desc *desc = &irq_descs[irq];
+
+            os_printf("%3u %3u %10u %11u %11u %8u %9u", vector, irq, stats->count, (uint32_t) average,
+                      stats->max_cycles, desc->spurious, desc->unhandled);
+            for (struct irq_action *action = desc->actions; action; action = action->next) {
+                os_printf(" %s", action->name);
+            }
+            os_printf("\n");
+        }
+        else {
+            os_printf("%3u   - %10u %11u %11u\n", vector, stats->count, (uint32_t) average, stats->max_cycles);
+        }
+
+        os_printf("    cycles:");
+        for (int i = 0; i < IRQ_HISTOGRAM_BUCKETS; i++) {
+            if (stats->histogram[i]) {
+                os_printf(" %s2^%u:%u", i == 0 ? "<" : "", i + IRQ_HISTOGRAM_SHIFT + (i == 0), stats->histogram[i]);
+            }
+        }
+        os_printf("\n");
+    }
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef __IRQ_H__
+#define __IRQ_H__
+
+#include "../../include/stdint.h"
+
+// The IRQ lines are delivered on the vectors from IRQ_BASE_VECTOR on.
+#define IRQ_BASE_VECTOR         32
+#define IRQ_LINES               16
+#define INTERRUPT_VECTORS       256
+
+// Return values of an IRQ handler
+#define IRQ_NONE                0       /* The interrupt did not come from the device of the handler */
+#define IRQ_HANDLED             1
+
+// Histogram of the cycles spent per interrupt: bucket n counts the interrupts which took 2^(n + 6) to 2^(n + 7) - 1
+// cycles, the first and the last bucket also take the shorter and the longer ones.
+#define IRQ_HISTOGRAM_BUCKETS   16
+#define IRQ_HISTOGRAM_SHIFT     6
+
+typedef int (*irq_handler_t)(unsigned int irq, void *dev);
+
+// A handler on an IRQ line. The handlers of a shared line are chained and all called for each interrupt.
+struct irq_action {
+    irq_handler_t handler;
+    void *dev;                  // passed to the handler, identifies the device on a shared line
+    const char *name;
+    struct irq_action *next;
+};
+
+// Interrupt controller operations on the IRQ lines
+struct irq_chip {
+    const char *name;
+    void (*mask)(unsigned int irq);
+    void (*unmask)(unsigned int irq);
+    void (*eoi)(unsigned int irq);
+    int (*is_spurious)(unsigned int irq);   // may be 0, must do the EOI a spurious interrupt still needs
+};
+
+struct irq_desc {
+    struct irq_action *actions;
+    struct irq_chip *chip;
+    uint32_t spurious;          // spurious interrupts reported on the line
+    uint32_t unhandled;         // interrupts no handler claimed
+};
+
+// Statistics of an interrupt vector
+struct interrupt_stats {
+    uint32_t count;
+    uint64_t cycles;            // total cycles spent in the handlers
+    uint32_t max_cycles;
+    uint32_t histogram[IRQ_HISTOGRAM_BUCKETS];
+};
+
+void init_irq();
+int request_irq(unsigned int irq, irq_handler_t handler, const char *name, void *dev);
+void free_irq(unsigned int irq, void *dev);
+void irq_set_chip(unsigned int irq, struct irq_chip *chip);
+void irq_dispatch(unsigned int irq);
+void interrupt_account(unsigned int vector, uint32_t cycles);
+const struct interrupt_stats *interrupt_get_stats(unsigned int vector);
+void irq_print_stats();
+
+#endif
\ No newline at end of file
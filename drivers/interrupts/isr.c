@@ -1,45 +1,99 @@
 #include "isr.h"
-#include "../framebuffer/framebuffer.h"
+#include "irq.h"
+#include "../serial/serial.h"
+#include "../../include/stdio.h"
+#include "../../kernel/cpu/cpu.h"
+#include "../../kernel/log/log.h"
+#include "../../kernel/sched/sched.h"
+#include "../../kernel/syscall/syscall.h"
+#include "../../mm/segmentation/gdt.h"
 
-// Array of function pointers to store 256 function pointers
-void (*interrupt_handlers[256]) ();
+// Handlers of the interrupt vectors which are not IRQ lines, indexed by vector number.
+static void (*interrupt_handlers[INTERRUPT_VECTORS]) (struct interrupt_frame *frame);
+
+/** exception_halt:
+ *  Writes the interrupt number and the registers of an exception the kernel can not recover from to COM1, by polling
+ *  the UART, and halts. The console is left alone: the exception may have been raised while console_lock was held,
+ *  e.g. inside a sink, and taking it again would deadlock instead of writing the dump.
+ *
+ * @param frame The frame built by common_interrupt_handler
+ */
+void exception_halt(struct interrupt_frame *frame) {
+    char dump[512];
+    int length;
+
+    length = snprintf(dump, sizeof(dump),
+                      "Exception! System Halted!\n"
+                      "Interrupt No: %d\n"
+                      "Error Code: 0x%x\n"
+                      "EIP: 0x%x\n"
+                      "CS: 0x%x\n"
+                      "EFLAGS: 0x%x\n"
+                      "EAX: 0x%x\n"
+                      "EBX: 0x%x\n"
+                      "ECX: 0x%x\n"
+                      "EDX: 0x%x\n"
+                      "ESP: 0x%x\n"
+                      "EBP: 0x%x\n"
+                      "ESI: 0x%x\n"
+                      "EDI: 0x%x\n"
+                      "DS: 0x%x\n"
+                      "CR2: 0x%x\n",
+                      frame->interrupt, frame->error_code, frame->eip, frame->cs, frame->eflags, frame->eax,
+                      frame->ebx, frame->ecx, frame->edx, frame->esp, frame->ebp, frame->esi, frame->edi, frame->ds,
+                      read_cr2());
+    if (length >= (int) sizeof(dump)) {
+        length = sizeof(dump) - 1;
+    }
+    serial_write_polled(SERIAL_COM1, dump, length);
+    asm volatile ("hlt");
+}
 
 /** interrupt_handler:
- *  Calls the function pointed to by the function pointer stored in the interrupt_handlers array at the index
- *  corresponding to the given interrupt number. If the interrupt number is less than 32, it writes the interrupt
- *  number, cpu_state and stack_state and enters an endless loop.
+ *  Dispatches an interrupt: the IRQ lines go to irq_dispatch, the other vectors to the handler registered with
+ *  register_interrupt_handler. An exception without a handler ends the user code that raised it, like the exit system
+ *  call with USER_FAULT_EXIT_STATUS; raised by the kernel, it writes the frame and halts. The time spent is added to
+ *  the statistics of the vector.
  *
- * @param cpu  Popped registers from the stack by common_interrupt_handler(defined in interrupt_handler.s)
- * @param interrupt Occured Interrupt number
- * @param stack Stack at the time of the interrupt
+ * @param frame The frame built by common_interrupt_handler(defined in interrupt_handler.s)
  */
-void interrupt_handler(struct cpu_state cpu, int interrupt, struct stack_state stack) {
-    if (interrupt < 32) {
-        os_printf("Exception! System Halted!\n");
-        os_printf("Interrupt No: %d\n", interrupt);
-        os_printf("EIP: 0x%x\n", stack.eip);
-        os_printf("CS: 0x%x\n", stack.cs);
-        os_printf("EFLAGS: 0x%x\n", stack.eflags);
-        os_printf("EAX: 0x%x\n", cpu.eax);
-        os_printf("EBX: 0x%x\n", cpu.ebx);
-        os_printf("ECX: 0x%x\n", cpu.ecx);
-        os_printf("EDX: 0x%x\n", cpu.edx);
-        os_printf("ESP: 0x%x\n", cpu.esp);
-        os_printf("EBP: 0x%x\n", cpu.ebp);
-        os_printf("ESI: 0x%x\n", cpu.esi);
-        os_printf("EDI: 0x%x\n", cpu.edi);
-        asm volatile ("hlt");
+void interrupt_handler(struct interrupt_frame *frame) {
+    unsigned int interrupt = frame->interrupt;
+    uint64_t start = rdtsc();
+
+    if (interrupt >= IRQ_BASE_VECTOR && interrupt < IRQ_BASE_VECTOR + IRQ_LINES) {
+        irq_dispatch(interrupt - IRQ_BASE_VECTOR);
+    }
+    else if (interrupt < INTERRUPT_VECTORS && interrupt_handlers[interrupt]) {
+        interrupt_handlers[interrupt](frame);
+    }
+    else if (interrupt < 32 && (frame->cs & GDT_RPL_USER) == GDT_RPL_USER) {
+        // The user code caused the exception, e.g. with a privileged instruction or an invalid opcode; only it ends.
+        log_warning("%s: exception %u at eip 0x%x (error 0x%x)", thread_current()->name, interrupt, frame->eip,
+                    frame->error_code);
+        user_exit(USER_FAULT_EXIT_STATUS);
+    }
+    else if (interrupt < 32) {
+        exception_halt(frame);
+    }
+    interrupt_account(interrupt, (uint32_t) (rdtsc() - start));
+
+    /* The interrupt is acknowledged by now, switch threads if the handler asked for it. Not when the interrupted code
+     * ran with the interrupts disabled: an exception inside a spinlock or a kernel_fpu section must return to it. */
+    if (frame->eflags & EFLAGS_IF) {
+        sched_preempt();
     }
-    // Call the interrupt handler
-    interrupt_handlers[interrupt - 32](interrupt);
 }
 
 /** register_interrupt_handler:
  * Stores the function pointer in the interrupt_handlers array at the index corresponding to the given interrupt number.
+ * For exceptions and software interrupts; the IRQ lines are requested with request_irq.
  *
  * @param interrupt An interrupt number stored in the Interrupt Descriptor Table
  * @param handler   function to handle the given interrupt.
  */
-void register_interrupt_handler(int interrupt, void (*handler)()) {
-    interrupt_handlers[interrupt] = handler;
+void register_interrupt_handler(int interrupt, void (*handler)(struct interrupt_frame *frame)) {
+    if (interrupt >= 0 && interrupt < INTERRUPT_VECTORS) {
+        interrupt_handlers[interrupt] = handler;
+    }
 }
\ No newline at end of file
@@ -3,88 +3,42 @@
 
 #include "../../include/stdint.h"
 
-// Popped registers from the stack by common_interrupt_handler(defined in interrupt_handler.s)
-struct cpu_state {
-    uint32_t eax;
+/* The frame common_interrupt_handler (defined in interrupt_handler.s) builds on the stack, from the lowest address up:
+ * the data segments it saves, the registers saved by pushad, the interrupt number and error code pushed by the stub
+ * of the vector, and what the CPU pushed when the interrupt occurred.
+ *
+ * The CPU pushes eflags, cs and eip, and for some exceptions an error code. The exceptions that push an error code are
+ * 8, 10, 11, 12, 13, 14, 17, 21, 29 and 30; the stubs of the other vectors push 0 in its place so every frame has the
+ * same layout. When the interrupt comes from a less privileged ring the CPU switches to the kernel stack first and also
+ * pushes the stack pointer and stack segment of the interrupted code, user_esp and user_ss are only valid then.
+ *
+ * Handlers may change the frame, the registers are restored from it when the interrupt returns. */
+struct interrupt_frame {
+    uint32_t gs;
+    uint32_t fs;
+    uint32_t es;
+    uint32_t ds;
+    uint32_t edi;
+    uint32_t esi;
+    uint32_t ebp;
+    uint32_t esp;               // value of esp inside the handler, ignored by popad
     uint32_t ebx;
-    uint32_t ecx;
     uint32_t edx;
-    uint32_t esp;
-    uint32_t ebp;
-    uint32_t esi;
-    uint32_t edi;
-} __attribute__ ((packed));
-
-/* When an interrupt occurs the CPU will push some information about the interrupt onto the stack.
- * The stack at the time of the interrupt will look like the following:
- *  [esp + 12] eflags
- *  [esp + 8]  cs
- *  [esp + 4]  eip
- *  [esp]      error code?
- *
- *  The reason for the question mark behind error code is that not all interrupts create an error code. The specific
- *  CPU interrupts that put an error code on the stack are 8, 10, 11, 12, 13, 14 and 17. The error code can be used by
- *  the interrupt handler to get more information on what has happened. Also, note that the interrupt number is not
- *  pushed onto the stack. We can only determine what interrupt has occurred by knowing what code is executing - if the
- *  handler registered for interrupt 17 is executing, then interrupt 17 has occurred.
-*/
-struct stack_state {
+    uint32_t ecx;
+    uint32_t eax;
+    uint32_t interrupt;
     uint32_t error_code;
     uint32_t eip;
     uint32_t cs;
     uint32_t eflags;
+    uint32_t user_esp;
+    uint32_t user_ss;
 } __attribute__ ((packed));
 
-extern void register_interrupt_handler(int interrupt, void (*handler)());
-void register_interrupt_handler(int interrupt, void (*handler)());
+void register_interrupt_handler(int interrupt, void (*handler)(struct interrupt_frame *frame));
+void exception_halt(struct interrupt_frame *frame);
 
-extern void interrupt_handler_0(void);
-extern void interrupt_handler_1(void);
-extern void interrupt_handler_2(void);
-extern void interrupt_handler_3(void);
-extern void interrupt_handler_4(void);
-extern void interrupt_handler_5(void);
-extern void interrupt_handler_6(void);
-extern void interrupt_handler_7(void);
-extern void interrupt_handler_8(void);
-extern void interrupt_handler_9(void);
-extern void interrupt_handler_10(void);
-extern void interrupt_handler_11(void);
-extern void interrupt_handler_12(void);
-extern void interrupt_handler_13(void);
-extern void interrupt_handler_14(void);
-extern void interrupt_handler_15(void);
-extern void interrupt_handler_16(void);
-extern void interrupt_handler_17(void);
-extern void interrupt_handler_18(void);
-extern void interrupt_handler_19(void);
-extern void interrupt_handler_20(void);
-extern void interrupt_handler_21(void);
-extern void interrupt_handler_22(void);
-extern void interrupt_handler_23(void);
-extern void interrupt_handler_24(void);
-extern void interrupt_handler_25(void);
-extern void interrupt_handler_26(void);
-extern void interrupt_handler_27(void);
-extern void interrupt_handler_28(void);
-extern void interrupt_handler_29(void);
-extern void interrupt_handler_30(void);
-extern void interrupt_handler_31(void);
-extern void interrupt_handler_32(void);
-extern void interrupt_handler_33(void);
-extern void interrupt_handler_34(void);
-extern void interrupt_handler_35(void);
-extern void interrupt_handler_36(void);
-extern void interrupt_handler_37(void);
-extern void interrupt_handler_38(void);
-extern void interrupt_handler_39(void);
-extern void interrupt_handler_40(void);
-extern void interrupt_handler_41(void);
-extern void interrupt_handler_42(void);
-extern void interrupt_handler_43(void);
-extern void interrupt_handler_44(void);
-extern void interrupt_handler_45(void);
-extern void interrupt_handler_46(void);
-extern void interrupt_handler_47(void);
+// Entry points of the vectors, indexed by vector number. Defined in interrupt_handler.s.
+extern void *interrupt_stub_table[];
 
 #endif
\ No newline at end of file
@@ -1,20 +1,113 @@
 #ifndef __IO_H__
 #define __IO_H__
 
+#include "../../include/stdint.h"
+#include "../../include/stddef.h"
+
+/* Port I/O
+ *
+ * The in and out instructions, inline so that a port access costs the instruction itself and not a call. The "Nd"
+ * constraint lets the compiler encode a constant port below 256 in the instruction, other ports go through dx.
+ *
+ * The string variants transfer a whole buffer with one rep ins/outs, for devices with a data port which takes or
+ * delivers a block (disk controllers, the FIFO of a UART). */
+
+// Unused port, written to give the slow ISA devices time between two accesses.
+#define IO_WAIT_PORT    0x80
+
 /** outb:
- *  Sends the given data to the given I/O port. Defined in io.s
+ *  Sends the given data to the given I/O port.
  *
  *  @param port The I/O port to send the data to
  *  @param data The data to send to the I/O port
  */
-void outb(unsigned short port, unsigned char data);
+static inline void outb(uint16_t port, uint8_t data) {
+    asm volatile("outb %0, %1" : : "a"(data), "Nd"(port));
+}
 
 /** inb:
- * Read a byte from an I/O port. Defined in io.s
+ *  Read a byte from an I/O port.
  *
  *  @param  port The address of the I/O port
  *  @return      The read byte
  */
-unsigned char inb(unsigned short port);
+static inline uint8_t inb(uint16_t port) {
+    uint8_t data;
+
+    asm volatile("inb %1, %0" : "=a"(data) : "Nd"(port));
+    return data;
+}
+
+static inline void outw(uint16_t port, uint16_t data) {
+    asm volatile("outw %0, %1" : : "a"(data), "Nd"(port));
+}
+
+static inline uint16_t inw(uint16_t port) {
+    uint16_t data;
+
+    asm volatile("inw %1, %0" : "=a"(data) : "Nd"(port));
+    return data;
+}
+
+static inline void outl(uint16_t port, uint32_t data) {
+    asm volatile("outl %0, %1" : : "a"(data), "Nd"(port));
+}
+
+static inline uint32_t inl(uint16_t port) {
+    uint32_t data;
+
+    asm volatile("inl %1, %0" : "=a"(data) : "Nd"(port));
+    return data;
+}
+
+/** outsb:
+ *  Writes count bytes from a buffer to an I/O port.
+ */
+static inline void outsb(uint16_t port, const void *buffer, size_t count) {
+    asm volatile("rep outsb" : "+S"(buffer), "+c"(count) : "d"(port) : "memory");
+}
+
+/** insb:
+ *  Reads count bytes from an I/O port into a buffer.
+ */
+static inline void insb(uint16_t port, void *buffer, size_t count) {
+    asm volatile("rep insb" : "+D"(buffer), "+c"(count) : "d"(port) : "memory");
+}
+
+/** outsw:
+ *  Writes count 16-bit words from a buffer to an I/O port.
+ */
+static inline void outsw(uint16_t port, const void *buffer, size_t count) {
+    asm volatile("rep outsw" : "+S"(buffer), "+c"(count) : "d"(port) : "memory");
+}
+
+/** insw:
+ *  Reads count 16-bit words from an I/O port into a buffer, e.g. a sector from the data port of an ATA controller.
+ */
+static inline void insw(uint16_t port, void *buffer, size_t count) {
+    asm volatile("rep insw" : "+D"(buffer), "+c"(count) : "d"(port) : "memory");
+}
+
+/** outsl:
+ *  Writes count 32-bit words from a buffer to an I/O port.
+ */
+static inline void outsl(uint16_t port, const void *buffer, size_t count) {
+    asm volatile("rep outsl" : "+S"(buffer), "+c"(count) : "d"(port) : "memory");
+}
+
+/** insl:
+ *  Reads count 32-bit words from an I/O port into a buffer.
+ */
+static inline void insl(uint16_t port, void *buffer, size_t count) {
+    asm volatile("rep insl" : "+D"(buffer), "+c"(count) : "d"(port) : "memory");
+}
+
+/** io_wait:
+ *  Waits about a microsecond, the time of an access to an unused port. For devices which need a pause between
+ *  commands, like the 8259 during its initialization.
+ */
+static inline void io_wait() {
+    outb(IO_WAIT_PORT, 0);
+}
 
 #endif
\ No newline at end of file
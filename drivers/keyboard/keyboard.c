@@ -1,7 +1,8 @@
+#include "keyboard.h"
 #include "../framebuffer/framebuffer.h"
 #include "../io/io.h"
-#include "../pic/pic.h"
-#include "../interrupts/isr.h"
+#include "../interrupts/irq.h"
+#include "../../kernel/debug/debug.h"
 
 /* KBDUS means US Keyboard Layout. This is a scancode table used to layout a standard US keyboard.
  * Based on http://www.osdever.net/bkerndev/Docs/keyboard.htm */
@@ -44,24 +45,63 @@ unsigned char kbdus[128] = {
     0,	/* All other keys are undefined */
 };
 
+static int shift_pressed;
+static int extended;
+
 /** keyboard_handler:
- *  Handles the keyboard interrupt
- *  @param num The number of the interrupt
+ *  Handles the keyboard interrupt (IRQ 1).
  */
-void keyboard_handler(int num) {
-    // Acknowledges the interrupt
-    pic_acknowledge(num);
+static int keyboard_handler(unsigned int irq, void *dev) {
+    (void) irq;
+    (void) dev;
 
     // Read from the keyboard's data buffer
-    unsigned char scancode = inb(0x60);
+    unsigned char scancode = inb(KBD_DATA_PORT);
+
+    if (scancode == KBD_EXTENDED) {
+        extended = 1;
+        return IRQ_HANDLED;
+    }
+
+    int released = scancode & KBD_RELEASED;
+    int is_extended = extended;
+    scancode &= ~KBD_RELEASED;
+    extended = 0;
+
+    if (scancode == KBD_LEFT_SHIFT || scancode == KBD_RIGHT_SHIFT) {
+        // The enhanced keyboard sends fake shifts around some extended keys, they do not change the shift state.
+        if (!is_extended) {
+            shift_pressed = !released;
+        }
+        return IRQ_HANDLED;
+    }
+    if (released) {
+        return IRQ_HANDLED;
+    }
+
+    // Shift+PgUp/PgDn scroll the console by a page. The keypad keys send the same scancodes without the prefix.
+    if (shift_pressed && (scancode == KBD_PAGE_UP || scancode == KBD_PAGE_DOWN)) {
+        fb_scrollback(scancode == KBD_PAGE_UP ? FB_HEIGHT - 1 : -(FB_HEIGHT - 1));
+        return IRQ_HANDLED;
+    }
+
+    // The function keys dump the kernel statistics.
+    if (!is_extended && scancode >= KBD_F1 && scancode < KBD_F1 + DEBUG_KEY_COUNT) {
+        debug_key(scancode - KBD_F1);
+        return IRQ_HANDLED;
+    }
 
     // Translate the keyboard scancode into an ASCII value, and then display it to the screen.
-    fb_write_char(kbdus[scancode]);
+    if (!is_extended && kbdus[scancode]) {
+        fb_write_char(kbdus[scancode]);
+    }
+
+    return IRQ_HANDLED;
 }
 
 /** init_keyboard:
  *  Initialize the keyboard.
  */
 void init_keyboard() {
-    register_interrupt_handler(1, keyboard_handler);
+    request_irq(KBD_IRQ, keyboard_handler, "keyboard", 0);
 }
\ No newline at end of file
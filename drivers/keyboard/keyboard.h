@@ -4,6 +4,16 @@
 #include "../../include/stdint.h"
 
 #define KBD_DATA_PORT           0x60
+#define KBD_IRQ                 1
+
+// Scancodes of set 1. A key release sends the scancode of the key with the highest bit set.
+#define KBD_RELEASED            0x80
+#define KBD_EXTENDED            0xE0        /* Prefix of the keys added by the enhanced keyboard */
+#define KBD_LEFT_SHIFT          0x2A
+#define KBD_RIGHT_SHIFT         0x36
+#define KBD_PAGE_UP             0x49
+#define KBD_PAGE_DOWN           0x51
+#define KBD_F1                  0x3B        /* F1 to F10 are consecutive */
 
 void init_keyboard();
 
@@ -21,21 +21,29 @@ void pic_remap(unsigned char offset1, unsigned char offset2) {
 
     // Starts the initialization sequence (in cascade mode)
     outb(PIC1_COMMAND, ICW1_INIT | ICW1_ICW4);
+    io_wait();
     outb(PIC2_COMMAND, ICW1_INIT | ICW1_ICW4);
+    io_wait();
 
     // ICW2: Master PIC vector offset
     outb(PIC1_DATA, offset1);
+    io_wait();
     // ICW2: Slave PIC vector offset
     outb(PIC2_DATA, offset2);
+    io_wait();
 
     // ICW3: tell Master PIC that there is a slave PIC at IRQ2 (0000 0100)
     outb(PIC1_DATA, 4);
+    io_wait();
     // ICW3: tell Slave PIC its cascade identity (0000 0010)
     outb(PIC2_DATA, 2);
+    io_wait();
 
     // ICW4: have the PICs use 8086 mode (and not 8080 mode)
     outb(PIC1_DATA, ICW4_8086);
+    io_wait();
     outb(PIC2_DATA, ICW4_8086);
+    io_wait();
 
     // restore saved masks
     outb(PIC1_DATA, a1);
@@ -64,6 +72,14 @@ void pic_remap(unsigned char offset1, unsigned char offset2) {
     asm volatile("sti");
 }
 
+/** pic_disable:
+ *  Masks all lines of both PICs, when the IO APIC takes over the IRQs.
+ */
+void pic_disable() {
+    outb(PIC1_DATA, 0xFF);
+    outb(PIC2_DATA, 0xFF);
+}
+
 /** pic_acknowledge:
  *  Acknowledges an interrupt from either PIC 1 or PIC 2.
  *
@@ -85,4 +101,96 @@ void pic_acknowledge(unsigned int interrupt) {
         outb(PIC1_COMMAND, PIC_EOI);
     }
 
-}
\ No newline at end of file
+}
+
+/** pic_mask_irq:
+ *  Stops the PIC from raising the given IRQ line.
+ *
+ *  @param irq The IRQ line (0 - 15)
+ */
+void pic_mask_irq(unsigned char irq) {
+    if (irq < 8) {
+        outb(PIC1_DATA, inb(PIC1_DATA) | (1 << irq));
+    }
+    else {
+        outb(PIC2_DATA, inb(PIC2_DATA) | (1 << (irq - 8)));
+    }
+}
+
+/** pic_unmask_irq:
+ *  Lets the PIC raise the given IRQ line. Lines of the slave PIC also need the cascade line (IRQ 2) of the master.
+ *
+ *  @param irq The IRQ line (0 - 15)
+ */
+void pic_unmask_irq(unsigned char irq) {
+    if (irq < 8) {
+        outb(PIC1_DATA, inb(PIC1_DATA) & ~(1 << irq));
+    }
+    else {
+        outb(PIC2_DATA, inb(PIC2_DATA) & ~(1 << (irq - 8)));
+        outb(PIC1_DATA, inb(PIC1_DATA) & ~(1 << 2));
+    }
+}
+
+/** pic_send_eoi:
+ *  Signals the end of the interrupt of an IRQ line. Lines of the slave PIC need an EOI on both PICs.
+ *
+ *  @param irq The IRQ line (0 - 15)
+ */
+void pic_send_eoi(unsigned int irq) {
+    if (irq >= 8) {
+        outb(PIC2_COMMAND, PIC_EOI);
+    }
+    outb(PIC1_COMMAND, PIC_EOI);
+}
+
+/** pic_read_isr:
+ *  Returns the In-Service Registers of both PICs, the master in the low byte. A bit is set while the interrupt of the
+ *  line is being serviced, i.e. from its delivery to its EOI.
+ */
+uint16_t pic_read_isr() {
+    outb(PIC1_COMMAND, PIC_READ_ISR);
+    outb(PIC2_COMMAND, PIC_READ_ISR);
+
+    return (inb(PIC2_COMMAND) << 8) | inb(PIC1_COMMAND);
+}
+
+/** pic_is_spurious:
+ *  Checks whether an interrupt of IRQ 7 or IRQ 15 is spurious. When a request goes away before the PIC delivers it,
+ *  the PIC raises the lowest priority line of its own instead, without setting its bit in the In-Service Register.
+ *  A spurious interrupt must not be acknowledged on its PIC; one from the slave still needs an EOI on the master,
+ *  which did see a real request on the cascade line.
+ *
+ *  @param irq The IRQ line (0 - 15)
+ *  @return    Non-zero if the interrupt is spurious, the caller must not send the EOI
+ */
+int pic_is_spurious(unsigned int irq) {
+    if (irq != PIC1_SPURIOUS_IRQ && irq != PIC2_SPURIOUS_IRQ) {
+        return 0;
+    }
+    if (pic_read_isr() & (1 << irq)) {
+        return 0;
+    }
+
+    if (irq == PIC2_SPURIOUS_IRQ) {
+        outb(PIC1_COMMAND, PIC_EOI);
+    }
+    return 1;
+}
+
+static void pic_chip_mask(unsigned int irq) {
+    pic_mask_irq(irq);
+}
+
+static void pic_chip_unmask(unsigned int irq) {
+    pic_unmask_irq(irq);
+}
+
+// The 8259 PICs as the controller of the IRQ lines 0 - 15
+struct irq_chip pic_chip = {
+    .name = "8259",
+    .mask = pic_chip_mask,
+    .unmask = pic_chip_unmask,
+    .eoi = pic_send_eoi,
+    .is_spurious = pic_is_spurious,
+};
\ No newline at end of file
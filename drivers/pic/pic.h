@@ -1,6 +1,9 @@
 #ifndef __PIC_H__
 #define __PIC_H__
 
+#include "../../include/stdint.h"
+#include "../interrupts/irq.h"
+
 #define ICW1_ICW4	    0x01		/* Indicates that ICW4 will be present */
 #define ICW1_INIT	    0x10		/* Initialization - required! */
 #define ICW4_8086	    0x01		/* 8086/88 (MCS-80/85) mode */
@@ -17,8 +20,21 @@
 #define PIC2_START_INTERRUPT    0x28
 #define PIC2_END_INTERRUPT      PIC2_START_INTERRUPT + 7
 #define PIC_EOI		            0x20		/* End-of-interrupt command code */
+#define PIC_READ_ISR            0x0B        /* OCW3: the next read of the command port returns the ISR */
+
+// The IRQ lines on which the PICs report spurious interrupts.
+#define PIC1_SPURIOUS_IRQ       7
+#define PIC2_SPURIOUS_IRQ       15
 
 void pic_remap(unsigned char offset1, unsigned char offset2);
+void pic_disable();
 void pic_acknowledge(unsigned int interrupt);
+void pic_mask_irq(unsigned char irq);
+void pic_unmask_irq(unsigned char irq);
+void pic_send_eoi(unsigned int irq);
+uint16_t pic_read_isr();
+int pic_is_spurious(unsigned int irq);
+
+extern struct irq_chip pic_chip;
 
 #endif
\ No newline at end of file
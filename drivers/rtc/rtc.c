@@ -0,0 +1,99 @@
+#include "rtc.h"
+#include "../io/io.h"
+
+/* Real-time clock
+ *
+ * The RTC of the CMOS keeps the calendar time while the machine is off, with a resolution of one second. It is read
+ * once at boot to give the monotonic clock a wall time origin (ktime_get_real_ns). The firmware usually keeps it in
+ * local time (bochs with time0=local), the kernel has no time zone and takes it as UTC. */
+
+/** cmos_read:
+ *  Reads a register of the CMOS RAM.
+ */
+static uint8_t cmos_read(uint8_t reg) {
+    outb(CMOS_INDEX_PORT, reg);
+    return inb(CMOS_DATA_PORT);
+}
+
+/** bcd_to_binary:
+ *  Converts a two digit BCD value.
+ */
+static uint8_t bcd_to_binary(uint8_t value) {
+    return (value >> 4) * 10 + (value & 0x0F);
+}
+
+/** rtc_read_raw:
+ *  Reads the time registers once an update is over. The values are in the format of the RTC.
+ */
+static void rtc_read_raw(struct rtc_time *time) {
+    while (cmos_read(RTC_STATUS_A) & RTC_STATUS_A_UIP);
+
+    time->second = cmos_read(RTC_SECONDS);
+    time->minute = cmos_read(RTC_MINUTES);
+    time->hour = cmos_read(RTC_HOURS);
+    time->day = cmos_read(RTC_DAY);
+    time->month = cmos_read(RTC_MONTH);
+    time->year = cmos_read(RTC_YEAR);
+}
+
+/** rtc_read:
+ *  Reads the calendar time from the RTC.
+ *
+ *  @param time Set to the time
+ */
+void rtc_read(struct rtc_time *time) {
+    struct rtc_time check;
+    uint8_t status;
+    int pm;
+
+    // An update may start between the check of the UIP flag and the reads, two equal reads in a row are consistent.
+    rtc_read_raw(time);
+    for (;;) {
+        rtc_read_raw(&check);
+        if (check.second == time->second && check.minute == time->minute && check.hour == time->hour &&
+            check.day == time->day && check.month == time->month && check.year == time->year) {
+            break;
+        }
+        *time = check;
+    }
+
+    status = cmos_read(RTC_STATUS_B);
+    pm = !(status & RTC_STATUS_B_24H) && (time->hour & RTC_HOURS_PM);
+    time->hour &= ~RTC_HOURS_PM;
+
+    if (!(status & RTC_STATUS_B_BINARY)) {
+        time->second = bcd_to_binary(time->second);
+        time->minute = bcd_to_binary(time->minute);
+        time->hour = bcd_to_binary(time->hour);
+        time->day = bcd_to_binary(time->day);
+        time->month = bcd_to_binary(time->month);
+        time->year = bcd_to_binary(time->year);
+    }
+
+    // 12 hour mode counts 12, 1, ..., 11.
+    if (!(status & RTC_STATUS_B_24H)) {
+        time->hour %= 12;
+        if (pm) {
+            time->hour += 12;
+        }
+    }
+    time->year += RTC_CENTURY_BASE;
+}
+
+/** rtc_to_unix:
+ *  Converts a calendar time to seconds since 1970-01-01 00:00:00 UTC.
+ *
+ *  @param time The calendar time, UTC
+ *  @return     The seconds
+ */
+uint64_t rtc_to_unix(const struct rtc_time *time) {
+    // Count the years from March, so that the leap day is the last day of the year.
+    uint32_t year = time->year - (time->month <= 2);
+    uint32_t era_year = year - 1600;
+    uint32_t month = time->month > 2 ? time->month - 3 : time->month + 9;
+    uint32_t day_of_year = (153 * month + 2) / 5 + time->day - 1;
+    // Days since 1600-03-01, then shifted to 1970-01-01.
+    uint32_t days = era_year * 365 + era_year / 4 - era_year / 100 + era_year / 400 + day_of_year - 135080;
+
+    return (uint64_t) days * 86400 + time->hour * 3600 + time->minute * 60 + time->second;
+}
\ No newline at end of file
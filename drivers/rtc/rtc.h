@@ -0,0 +1,41 @@
+#ifndef __RTC_H__
+#define __RTC_H__
+
+#include "../../include/stdint.h"
+
+// The CMOS RAM is accessed through an index and a data port.
+#define CMOS_INDEX_PORT         0x70
+#define CMOS_DATA_PORT          0x71
+
+// Registers of the real-time clock in the CMOS RAM
+#define RTC_SECONDS             0x00
+#define RTC_MINUTES             0x02
+#define RTC_HOURS               0x04
+#define RTC_DAY                 0x07
+#define RTC_MONTH               0x08
+#define RTC_YEAR                0x09
+#define RTC_STATUS_A            0x0A
+#define RTC_STATUS_B            0x0B
+
+#define RTC_STATUS_A_UIP        0x80        /* update in progress, the time registers are not stable */
+#define RTC_STATUS_B_24H        0x02        /* 24 hour mode, else the top bit of the hour register marks PM */
+#define RTC_STATUS_B_BINARY     0x04        /* binary values, else BCD */
+#define RTC_HOURS_PM            0x80
+
+// The RTC keeps two year digits, the century register is not standard.
+#define RTC_CENTURY_BASE        2000
+
+// Calendar time, as read from the RTC
+struct rtc_time {
+    uint16_t year;
+    uint8_t month;              // 1 - 12
+    uint8_t day;                // 1 - 31
+    uint8_t hour;               // 0 - 23
+    uint8_t minute;
+    uint8_t second;
+};
+
+void rtc_read(struct rtc_time *time);
+uint64_t rtc_to_unix(const struct rtc_time *time);
+
+#endif
\ No newline at end of file
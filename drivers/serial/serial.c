@@ -1,23 +1,65 @@
 #include "serial.h"
 #include "../io/io.h"
+#include "../interrupts/irq.h"
 #include "../../include/string.h"
+#include "../../kernel/cpu/cpu.h"
+
+/* Serial port driver
+ *
+ * Every COM port is described by a struct serial_port and opened separately with its own speed and receive trigger
+ * level, so e.g. one port can carry a high-rate trace stream while another one serves as the console.
+ *
+ * Output is not written to a port directly: serial_write copies it to the transmit ring of the port and returns, the
+ * interrupt handler moves it from the ring to the transmit FIFO of the UART, a FIFO full at a time whenever the FIFO
+ * runs empty. Received bytes are moved to the receive ring by the same handler. The kernel therefore never waits for
+ * the wire; when a transmit ring is full the bytes which do not fit are dropped and counted.
+ *
+ * The transmitter interrupt is only enabled while the transmit ring holds data. Enabling it while the FIFO is empty
+ * raises an interrupt right away, which is how a write starts the transmission.
+ *
+ * The lock of a port makes the writers of all processors a single producer of the transmit ring, and keeps the
+ * interrupt handler, serial_flush and the configuration from racing on the UART and on the shadow of its interrupt
+ * enable register. */
+
+static uint8_t tx_buffers[SERIAL_PORT_COUNT][SERIAL_TX_BUFFER_SIZE];
+static uint8_t rx_buffers[SERIAL_PORT_COUNT][SERIAL_RX_BUFFER_SIZE];
+
+#define SERIAL_PORT(n, base_port, irq_line) { \
+    .base = base_port, \
+    .irq = irq_line, \
+    .tx = {0, 0, SERIAL_TX_BUFFER_SIZE - 1, tx_buffers[n]}, \
+    .rx = {0, 0, SERIAL_RX_BUFFER_SIZE - 1, rx_buffers[n]}, \
+    .lock = SPINLOCK_INIT, \
+}
+
+static struct serial_port ports[SERIAL_PORT_COUNT] = {
+    SERIAL_PORT(SERIAL_COM1, SERIAL_COM1_BASE, SERIAL_COM1_IRQ),
+    SERIAL_PORT(SERIAL_COM2, SERIAL_COM2_BASE, SERIAL_COM2_IRQ),
+    SERIAL_PORT(SERIAL_COM3, SERIAL_COM3_BASE, SERIAL_COM1_IRQ),
+    SERIAL_PORT(SERIAL_COM4, SERIAL_COM4_BASE, SERIAL_COM2_IRQ),
+};
+
+// Port written by serial_write_str
+static int console = SERIAL_COM1;
 
 /** serial_configure_baud_rate:
  *  Sets the speed of the data being sent. The default speed of a serial
  *  port is 115200 bits/s. The argument is a divisor of that number, hence
- *  the resulting speed becomes (115200 / divisor) bits/s.
+ *  the resulting speed becomes (115200 / divisor) bits/s. Leaves DLAB set,
+ *  serial_configure_line clears it.
  *
  *  @param com      The COM port to configure
  *  @param divisor  The divisor
  */
-void serial_configure_baud_rate(unsigned short com, unsigned short divisor) {
-    /* The divisor is a 16-bit number, but we can only send 8 bits at a time.
-     * We must therefore send an instruction telling the serial port to first
-     * expect the highest 8 bits, then the lowest 8 bits. This is done by sending
-     * 0x80 to the line command port. */
+static void serial_configure_baud_rate(unsigned short com, unsigned short divisor) {
+    /* The divisor is a 16-bit number held by two registers, which share their
+     * ports with the data and the interrupt enable registers. Sending 0x80 to
+     * the line command port sets DLAB, which switches both ports over to the
+     * divisor: the lowest 8 bits go to the data port, the highest 8 bits to
+     * the port after it. */
     outb(SERIAL_LINE_COMMAND_PORT(com), SERIAL_LINE_ENABLE_DLAB);
-    outb(SERIAL_DATA_PORT(com), (divisor >> 8) & 0x00FF);
     outb(SERIAL_DATA_PORT(com), divisor & 0x00FF);
+    outb(SERIAL_DIVISOR_HIGH_PORT(com), (divisor >> 8) & 0x00FF);
 }
 
 /** serial_configure_line:
@@ -25,7 +67,7 @@ void serial_configure_baud_rate(unsigned short com, unsigned short divisor) {
  *
  *  @param com  The serial port to configure
  */
-void serial_configure_line(unsigned short com) {
+static void serial_configure_line(unsigned short com) {
     /*  Name   | Description
      *    d    | Enables (d = 1) or disables (d = 0) DLAB(Divisor Latch Access Bit)
      *    b    | If break control is enabled (b = 1) or disabled (b = 0)
@@ -43,12 +85,13 @@ void serial_configure_line(unsigned short com) {
     outb(SERIAL_LINE_COMMAND_PORT(com), 0x03);
 }
 
-/** serial_configure_fifo:
- *  Configures the fifo of the given serial port.
+/** serial_fifo_command:
+ *  Returns the FIFO command for a port.
  *
- *  @param com  The serial port to configure
+ *  @param port  The port
+ *  @param clear Whether the FIFOs are to be cleared
  */
-void serial_configure_fifo(unsigned short com) {
+static uint8_t serial_fifo_command(struct serial_port *port, int clear) {
     /*  Name | Description
      *   lvl | How many bytes should be stored in the FIFO buffers
      *   bs  | If the buffers should be 16 or 64 bytes large
@@ -56,18 +99,28 @@ void serial_configure_fifo(unsigned short com) {
      *   dma | How the serial port data should be accessed
      *   clt | Clear the transmission FIFO buffer
      *   clr | Clear the receiver FIFO buffer
-     *    e  | If the FIFO buffer should be enabled or not */
-
-    /*  We use the value 0xC7 = 11000111 that:
-     *  Enables FIFO
-     *  Clear both receiver and transmission FIFO queues
-     *  Use 14 bytes as size of queue
+     *    e  | If the FIFO buffer should be enabled or not
      *
      * Bit:     | 7 6 | 5  | 4 | 3   | 2   | 1   | 0 |
      * Content: | lvl | bs | r | dma | clt | clr | e |
-     * Value:   | 1 1 | 0  | 0  | 0  |  1  |  1  | 1 | = 0xC7 */
+     *
+     * lvl is the receive trigger level of the port, bs is set on a 16750. The
+     * FIFOs stay disabled on UARTs without a working FIFO. */
+    uint8_t command;
+
+    if (port->type < SERIAL_UART_16550A) {
+        return 0;
+    }
 
-    outb(SERIAL_FIFO_COMMAND_PORT(com), 0xC7);
+    command = SERIAL_FCR_ENABLE | port->rx_trigger;
+    if (port->type == SERIAL_UART_16750) {
+        command |= SERIAL_FCR_FIFO_64;
+    }
+    if (clear) {
+        command |= SERIAL_FCR_CLEAR_RX | SERIAL_FCR_CLEAR_TX;
+    }
+
+    return command;
 }
 
 /** serial_is_transmit_fifo_empty:
@@ -76,7 +129,7 @@ void serial_configure_fifo(unsigned short com) {
  *  @param  com The COM port
  *  @return 0 if the transmit FIFO queue is not empty 1 if the transmit FIFO queue is empty
  */
-int serial_is_transmit_fifo_empty(unsigned int com) {
+static int serial_is_transmit_fifo_empty(unsigned short com) {
     /* Bit | Description
      *  0  | Data Ready
      *  1  | Overrun Error
@@ -101,7 +154,7 @@ int serial_is_transmit_fifo_empty(unsigned int com) {
  *
  *  @param com  The serial port to configure
  */
-void serial_configure_modem(unsigned short com) {
+static void serial_configure_modem(unsigned short com) {
     /* Name | Description
      *   r  | Reserved
      *  af 	| Autoflow control enabled
@@ -111,36 +164,446 @@ void serial_configure_modem(unsigned short com) {
      *  rts | Ready To Transmit
      *  dtr | Data Terminal Ready */
 
-    /* We don’t need to enable interrupts, because we won’t handle any received data.
-     * Therefore, we use the configuration value 0x03 = 00000011 (RTS = 1 and DTS = 1).
+    /* The interrupt line of the UART is gated by auxiliary output 2, so it has to be set for the interrupts to reach
+     * the PIC. We use the configuration value 0x0B = 00001011 (AO2 = 1, RTS = 1 and DTR = 1).
      *
      * Bit:     | 7 | 6 | 5  | 4  |  3  |  2  |  1  |  0  |
      * Content: | r | r | af | lb | ao2 | ao1 | rts | dtr |
-     * Value:   | 0 | 0 | 0  | 0  |  0  |  0  |  1  |  1  | = 0x03 */
+     * Value:   | 0 | 0 | 0  | 0  |  1  |  0  |  1  |  1  | = 0x0B */
 
-    outb(SERIAL_MODEM_COMMAND_PORT(com), 0x03);
+    outb(SERIAL_MODEM_COMMAND_PORT(com), 0x0B);
 }
 
-// Initialize the serial
-void serial_init() {
-    serial_configure_baud_rate(SERIAL_COM1_BASE, 2);
-    serial_configure_line(SERIAL_COM1_BASE);
-    serial_configure_fifo(SERIAL_COM1_BASE);
-    serial_configure_modem(SERIAL_COM1_BASE);
+/** serial_probe:
+ *  Detects the UART of a port. The port is looped back and a byte is sent to check that a UART is there, then the
+ *  FIFOs are enabled, including the 64-byte mode, and the identification register tells which of them work.
+ *
+ *  @param base The data port
+ *  @return     SERIAL_UART_*
+ */
+static uint8_t serial_probe(uint16_t base) {
+    uint8_t id;
+
+    outb(SERIAL_INTERRUPT_ENABLE_PORT(base), 0);
+    outb(SERIAL_MODEM_COMMAND_PORT(base), SERIAL_MCR_LOOPBACK);
+    outb(SERIAL_DATA_PORT(base), 0xAE);
+    if (inb(SERIAL_DATA_PORT(base)) != 0xAE) {
+        return SERIAL_UART_NONE;
+    }
+
+    // The 64-byte bit of the FIFO command is only writable with DLAB set.
+    outb(SERIAL_LINE_COMMAND_PORT(base), SERIAL_LINE_ENABLE_DLAB);
+    outb(SERIAL_FIFO_COMMAND_PORT(base), SERIAL_FCR_ENABLE | SERIAL_FCR_CLEAR_RX | SERIAL_FCR_CLEAR_TX |
+                                         SERIAL_FCR_FIFO_64);
+    outb(SERIAL_LINE_COMMAND_PORT(base), 0);
+    id = inb(SERIAL_INTERRUPT_ID_PORT(base));
+    outb(SERIAL_FIFO_COMMAND_PORT(base), 0);
+
+    switch (id & SERIAL_IIR_FIFO_MASK) {
+        case SERIAL_IIR_FIFO_ENABLED:
+            return (id & SERIAL_IIR_FIFO_64) ? SERIAL_UART_16750 : SERIAL_UART_16550A;
+        case SERIAL_IIR_FIFO_UNUSABLE:
+            return SERIAL_UART_16550;
+        default:
+            return SERIAL_UART_8250;
+    }
+}
+
+/** ring_count:
+ *  Returns the number of bytes stored in a ring.
+ */
+static inline uint32_t ring_count(struct serial_ring *ring) {
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+/** ring_put:
+ *  Appends a byte to a ring. Producer side only.
+ *
+ *  @return 1 if the byte was stored, 0 if the ring is full
+ */
+static inline int ring_put(struct serial_ring *ring, uint8_t byte) {
+    uint32_t head = ring->head;
+
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) > ring->mask) {
+        return 0;
+    }
+    ring->data[head & ring->mask] = byte;
+    // Publish the byte before the new head.
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+    return 1;
+}
+
+/** ring_get:
+ *  Removes the oldest byte of a ring. Consumer side only.
+ *
+ *  @return 1 if a byte was removed, 0 if the ring is empty
+ */
+static inline int ring_get(struct serial_ring *ring, uint8_t *byte) {
+    uint32_t tail = ring->tail;
+
+    if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+    *byte = ring->data[tail & ring->mask];
+    // The slot may be reused once the new tail is visible.
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return 1;
+}
+
+/** serial_set_interrupts:
+ *  Writes the interrupt enable register of a port.
+ */
+static void serial_set_interrupts(struct serial_port *port, uint8_t mask) {
+    port->interrupt_enable = mask;
+    outb(SERIAL_INTERRUPT_ENABLE_PORT(port->base), mask);
+}
+
+/** serial_transmit:
+ *  Refills the empty transmit FIFO of a port from its transmit ring. Disables the transmitter interrupt when the ring
+ *  runs dry.
+ */
+static void serial_transmit(struct serial_port *port) {
+    struct serial_ring *ring = &port->tx;
+    uint32_t tail = ring->tail;
+    uint32_t count = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail;
+    uint32_t first;
+
+    if (count > port->fifo_size) {
+        count = port->fifo_size;
+    }
+
+    // A FIFO full in one rep outsb, or two when the bytes wrap around the end of the ring.
+    first = ring->mask + 1 - (tail & ring->mask);
+    if (first > count) {
+        first = count;
+    }
+    outsb(SERIAL_DATA_PORT(port->base), ring->data + (tail & ring->mask), first);
+    if (count > first) {
+        outsb(SERIAL_DATA_PORT(port->base), ring->data, count - first);
+    }
+    // The slots may be reused once the new tail is visible.
+    __atomic_store_n(&ring->tail, tail + count, __ATOMIC_RELEASE);
+
+    if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail + count) {
+        serial_set_interrupts(port, port->interrupt_enable & ~SERIAL_IER_THR_EMPTY);
+    }
+}
+
+/** serial_receive:
+ *  Moves the received bytes from the receive FIFO of a port to its receive ring. Bytes are dropped when the ring is
+ *  full.
+ */
+static void serial_receive(struct serial_port *port) {
+    while (inb(SERIAL_LINE_STATUS_PORT(port->base)) & SERIAL_LSR_DATA_READY) {
+        uint8_t byte = inb(SERIAL_DATA_PORT(port->base));
+
+        if (!ring_put(&port->rx, byte)) {
+            port->rx_dropped++;
+        }
+    }
+}
+
+/** serial_handler:
+ *  Handles the interrupts of a port on IRQ 3 or IRQ 4. The UART reports one cause at a time, so the identification
+ *  register is read until no cause is pending. Each IRQ is shared by two ports, the handler of each open port is
+ *  chained on it.
+ *
+ *  @param irq The IRQ line
+ *  @param dev The port
+ *  @return    IRQ_HANDLED if the port had an interrupt pending
+ */
+static int serial_handler(unsigned int irq, void *dev) {
+    struct serial_port *port = dev;
+    int handled = IRQ_NONE;
+    uint8_t id;
+
+    (void) irq;
+
+    spin_lock(&port->lock);
+    while (!((id = inb(SERIAL_INTERRUPT_ID_PORT(port->base))) & SERIAL_IIR_NO_INTERRUPT)) {
+        handled = IRQ_HANDLED;
+        switch (id & SERIAL_IIR_ID_MASK) {
+            case SERIAL_IIR_THR_EMPTY:
+                serial_transmit(port);
+                break;
+            case SERIAL_IIR_RX_DATA:
+            case SERIAL_IIR_RX_TIMEOUT:
+                serial_receive(port);
+                break;
+            case SERIAL_IIR_LINE_STATUS:
+                // Reading the line status register clears the error condition.
+                inb(SERIAL_LINE_STATUS_PORT(port->base));
+                break;
+            default:
+                inb(SERIAL_MODEM_STATUS_PORT(port->base));
+                break;
+        }
+    }
+    spin_unlock(&port->lock);
+
+    return handled;
+}
+
+/** serial_get_port:
+ *  Returns the descriptor of a port, 0 if the port number is invalid.
+ *
+ *  @param com SERIAL_COM1 to SERIAL_COM4
+ */
+struct serial_port *serial_get_port(int com) {
+    if (com < 0 || com >= SERIAL_PORT_COUNT) {
+        return 0;
+    }
+
+    return &ports[com];
+}
+
+/** serial_open:
+ *  Detects and initializes a port and enables its interrupts. Output written to the port before is kept in its
+ *  transmit ring and sent now. Requires the IDT and the PIC to be set up.
+ *
+ *  @param com        SERIAL_COM1 to SERIAL_COM4
+ *  @param divisor    Divisor of the maximum speed of 115200 bits/s
+ *  @param rx_trigger Receive FIFO trigger level, SERIAL_RX_TRIGGER_*
+ *  @return           0 on success, -1 if there is no UART at the port
+ */
+int serial_open(int com, uint16_t divisor, uint8_t rx_trigger) {
+    struct serial_port *port = serial_get_port(com);
+    uint32_t flags;
+
+    if (port == 0 || divisor == 0) {
+        return -1;
+    }
+
+    flags = spin_lock_irqsave(&port->lock);
+    port->type = serial_probe(port->base);
+    if (port->type == SERIAL_UART_NONE) {
+        spin_unlock_irqrestore(&port->lock, flags);
+        return -1;
+    }
+
+    port->divisor = divisor;
+    port->rx_trigger = rx_trigger;
+    if (port->type == SERIAL_UART_16750) {
+        port->fifo_size = 64;
+    }
+    else if (port->type == SERIAL_UART_16550A) {
+        port->fifo_size = 16;
+    }
+    else {
+        port->fifo_size = 1;
+    }
+
+    // Keep the UART quiet while it is programmed. The FIFO command goes in while DLAB is still set.
+    serial_set_interrupts(port, 0);
+    serial_configure_baud_rate(port->base, divisor);
+    outb(SERIAL_FIFO_COMMAND_PORT(port->base), serial_fifo_command(port, 1));
+    serial_configure_line(port->base);
+    serial_configure_modem(port->base);
+
+    if (!port->open) {
+        request_irq(port->irq, serial_handler, "serial", port);
+    }
+
+    port->open = 1;
+    serial_set_interrupts(port, SERIAL_IER_RX_DATA | SERIAL_IER_LINE_STATUS |
+                                (ring_count(&port->tx) ? SERIAL_IER_THR_EMPTY : 0));
+    spin_unlock_irqrestore(&port->lock, flags);
+
+    return 0;
+}
+
+/** serial_set_divisor:
+ *  Changes the speed of an open port to 115200 / divisor bits/s.
+ *
+ *  @return 0 on success, -1 if the port is not open
+ */
+int serial_set_divisor(int com, uint16_t divisor) {
+    struct serial_port *port = serial_get_port(com);
+    uint32_t flags;
+
+    if (port == 0 || !port->open || divisor == 0) {
+        return -1;
+    }
+
+    flags = spin_lock_irqsave(&port->lock);
+    port->divisor = divisor;
+    serial_configure_baud_rate(port->base, divisor);
+    serial_configure_line(port->base);
+    spin_unlock_irqrestore(&port->lock, flags);
+
+    return 0;
+}
+
+/** serial_set_rx_trigger:
+ *  Changes the receive FIFO trigger level of an open port. The content of the FIFOs is kept.
+ *
+ *  @param rx_trigger SERIAL_RX_TRIGGER_*
+ *  @return           0 on success, -1 if the port is not open
+ */
+int serial_set_rx_trigger(int com, uint8_t rx_trigger) {
+    struct serial_port *port = serial_get_port(com);
+    uint32_t flags;
+
+    if (port == 0 || !port->open) {
+        return -1;
+    }
+
+    flags = spin_lock_irqsave(&port->lock);
+    port->rx_trigger = rx_trigger;
+    outb(SERIAL_LINE_COMMAND_PORT(port->base), SERIAL_LINE_ENABLE_DLAB);
+    outb(SERIAL_FIFO_COMMAND_PORT(port->base), serial_fifo_command(port, 0));
+    serial_configure_line(port->base);
+    spin_unlock_irqrestore(&port->lock, flags);
+
+    return 0;
+}
+
+/** init_serial:
+ *  Opens COM1 as the console. Requires the IDT and the PIC to be set up.
+ */
+void init_serial() {
+    serial_open(SERIAL_COM1, SERIAL_DEFAULT_DIVISOR, SERIAL_RX_TRIGGER_14);
+}
+
+/** serial_set_console:
+ *  Selects the port written by serial_write_str.
+ */
+void serial_set_console(int com) {
+    if (serial_get_port(com)) {
+        console = com;
+    }
+}
+
+/** serial_write:
+ *  Queues bytes for transmission and returns without waiting. Can be called from interrupt handlers. Bytes written to
+ *  a port which is not open yet stay in its transmit ring until it is opened.
+ *
+ *  @param com  SERIAL_COM1 to SERIAL_COM4
+ *  @param buf  The bytes
+ *  @param len  Number of bytes
+ *  @return     Number of bytes queued, less than len if the transmit ring is full
+ */
+size_t serial_write(int com, const char *buf, size_t len) {
+    struct serial_port *port = serial_get_port(com);
+    uint32_t flags;
+    size_t i;
+
+    if (port == 0) {
+        return 0;
+    }
+
+    // The writers are serialized by the lock of the port, they form the single producer of the transmit ring.
+    flags = spin_lock_irqsave(&port->lock);
+    for (i = 0; i < len; i++) {
+        if (!ring_put(&port->tx, buf[i])) {
+            port->tx_dropped += len - i;
+            break;
+        }
+    }
+
+    if (i > 0 && port->open && !(port->interrupt_enable & SERIAL_IER_THR_EMPTY)) {
+        serial_set_interrupts(port, port->interrupt_enable | SERIAL_IER_THR_EMPTY);
+    }
+    spin_unlock_irqrestore(&port->lock, flags);
+
+    return i;
+}
+
+/** serial_write_console:
+ *  Queues bytes for transmission over the console port, see serial_write.
+ */
+size_t serial_write_console(const char *buf, size_t len) {
+    return serial_write(console, buf, len);
 }
 
 /** serial_write_str:
-*  Writes a character array to the serial.
-*
-*  @param buf  Character array
-*/
-void serial_write_str(char *buf) {
-    serial_init();
+ *  Writes a character array to the console port.
+ *
+ *  @param buf  Character array
+ */
+void serial_write_str(const char *buf) {
+    serial_write(console, buf, strlen(buf));
+}
+
+/** serial_read:
+ *  Reads received bytes without waiting.
+ *
+ *  @param com  SERIAL_COM1 to SERIAL_COM4
+ *  @param buf  Buffer for the bytes
+ *  @param len  Size of the buffer
+ *  @return     Number of bytes read, 0 if nothing was received
+ */
+size_t serial_read(int com, char *buf, size_t len) {
+    struct serial_port *port = serial_get_port(com);
+    size_t i;
+    uint8_t byte;
 
-    for(size_t i=0; i < strlen(buf); i++) {
-        char c = buf[i];
-        while (serial_is_transmit_fifo_empty(SERIAL_COM1_BASE) == 0);
-        outb(SERIAL_COM1_BASE, c);
+    if (port == 0) {
+        return 0;
     }
 
+    // The reader is the single consumer of the receive ring.
+    for (i = 0; i < len && ring_get(&port->rx, &byte); i++) {
+        buf[i] = byte;
+    }
+
+    return i;
+}
+
+/** serial_flush:
+ *  Sends the content of the transmit ring of a port by polling the UART, with the interrupts disabled. For the paths
+ *  which cannot rely on interrupts anymore, e.g. before halting on a fatal error.
+ */
+void serial_flush(int com) {
+    struct serial_port *port = serial_get_port(com);
+    uint32_t flags;
+    uint8_t byte;
+
+    if (port == 0 || !port->open) {
+        return;
+    }
+
+    flags = spin_lock_irqsave(&port->lock);
+    while (ring_get(&port->tx, &byte)) {
+        while (serial_is_transmit_fifo_empty(port->base) == 0);
+        outb(SERIAL_DATA_PORT(port->base), byte);
+    }
+    spin_unlock_irqrestore(&port->lock, flags);
+}
+
+/** serial_write_polled:
+ *  Writes bytes straight to the UART of a port by polling, behind the output still in its transmit ring. For the
+ *  fatal error paths, which must not wait for a lock: the lock of the port is only tried, and if it is busy the bytes
+ *  go out without it and the queued output is skipped.
+ *
+ *  @param com  SERIAL_COM1 to SERIAL_COM4
+ *  @param buf  The bytes
+ *  @param len  Number of bytes
+ */
+void serial_write_polled(int com, const char *buf, size_t len) {
+    struct serial_port *port = serial_get_port(com);
+    uint32_t flags;
+    int locked;
+    uint8_t byte;
+
+    if (port == 0 || !port->open) {
+        return;
+    }
+
+    flags = irq_save();
+    locked = spin_trylock(&port->lock);
+    while (locked && ring_get(&port->tx, &byte)) {
+        while (serial_is_transmit_fifo_empty(port->base) == 0);
+        outb(SERIAL_DATA_PORT(port->base), byte);
+    }
+    for (size_t i = 0; i < len; i++) {
+        while (serial_is_transmit_fifo_empty(port->base) == 0);
+        outb(SERIAL_DATA_PORT(port->base), buf[i]);
+    }
+    if (locked) {
+        spin_unlock(&port->lock);
+    }
+    irq_restore(flags);
 }
\ No newline at end of file
@@ -1,20 +1,134 @@
 #ifndef __SERIAL_H__
 #define __SERIAL_H__
 
+#include "../../include/stdint.h"
+#include "../../include/stddef.h"
+#include "../../kernel/sync/spinlock.h"
+
 /* All the I/O ports are calculated relative to the data port. This is because
  * all serial ports (COM1, COM2, COM3, COM4) have their ports in the same
  * order, but they start at different values. */
 #define SERIAL_COM1_BASE                0x3F8
+#define SERIAL_COM2_BASE                0x2F8
+#define SERIAL_COM3_BASE                0x3E8
+#define SERIAL_COM4_BASE                0x2E8
 #define SERIAL_DATA_PORT(base)          (base)
+#define SERIAL_INTERRUPT_ENABLE_PORT(base) (base + 1)
+#define SERIAL_DIVISOR_HIGH_PORT(base)  (base + 1)      /* With DLAB set */
 #define SERIAL_FIFO_COMMAND_PORT(base)  (base + 2)
+#define SERIAL_INTERRUPT_ID_PORT(base)  (base + 2)      /* Read side of the FIFO command port */
 #define SERIAL_LINE_COMMAND_PORT(base)  (base + 3)
 #define SERIAL_MODEM_COMMAND_PORT(base) (base + 4)
 #define SERIAL_LINE_STATUS_PORT(base)   (base + 5)
+#define SERIAL_MODEM_STATUS_PORT(base)  (base + 6)
+
+// COM1 and COM3 share IRQ 4, COM2 and COM4 share IRQ 3.
+#define SERIAL_COM1_IRQ                 4
+#define SERIAL_COM2_IRQ                 3
+
+// Port numbers used by the API
+#define SERIAL_COM1                     0
+#define SERIAL_COM2                     1
+#define SERIAL_COM3                     2
+#define SERIAL_COM4                     3
+#define SERIAL_PORT_COUNT               4
 
 /* Tells the serial port to expect first the highest 8 bits on the data port,
  * then the lowest 8 bits will follow */
 #define SERIAL_LINE_ENABLE_DLAB         0x80
 
-void serial_write_str(char *buf);
+// The UART clock gives 115200 bits/s with a divisor of 1.
+#define SERIAL_MAX_BAUD_RATE            115200
+#define SERIAL_DEFAULT_DIVISOR          2       /* 57600 bits/s */
+
+// Interrupt enable register
+#define SERIAL_IER_RX_DATA              0x01    /* Received data available */
+#define SERIAL_IER_THR_EMPTY            0x02    /* Transmitter holding register empty */
+#define SERIAL_IER_LINE_STATUS          0x04    /* Receiver line status */
+
+// Interrupt identification register, bits 1-3 tell the cause of the interrupt, bits 5-7 the FIFO state
+#define SERIAL_IIR_NO_INTERRUPT         0x01
+#define SERIAL_IIR_ID_MASK              0x0E
+#define SERIAL_IIR_MODEM_STATUS         0x00
+#define SERIAL_IIR_THR_EMPTY            0x02
+#define SERIAL_IIR_RX_DATA              0x04
+#define SERIAL_IIR_LINE_STATUS          0x06
+#define SERIAL_IIR_RX_TIMEOUT           0x0C    /* Data sits in the receive FIFO below the trigger level */
+#define SERIAL_IIR_FIFO_64              0x20    /* 64-byte FIFO enabled (16750) */
+#define SERIAL_IIR_FIFO_MASK            0xC0
+#define SERIAL_IIR_FIFO_ENABLED         0xC0    /* Working FIFO (16550A and later) */
+#define SERIAL_IIR_FIFO_UNUSABLE        0x80    /* FIFO of the original 16550, which is broken */
+
+// FIFO command register
+#define SERIAL_FCR_ENABLE               0x01
+#define SERIAL_FCR_CLEAR_RX             0x02
+#define SERIAL_FCR_CLEAR_TX             0x04
+#define SERIAL_FCR_FIFO_64              0x20    /* 16750 only, written with DLAB set */
+
+/* Receive FIFO trigger levels: the number of received bytes which raises an interrupt. A low level gives the lowest
+ * latency, a high level the fewest interrupts. The levels are 1/4/8/14 bytes with a 16-byte FIFO and 1/16/32/56 bytes
+ * with a 64-byte FIFO. */
+#define SERIAL_RX_TRIGGER_1             0x00
+#define SERIAL_RX_TRIGGER_4             0x40
+#define SERIAL_RX_TRIGGER_8             0x80
+#define SERIAL_RX_TRIGGER_14            0xC0
+
+// Line status register
+#define SERIAL_LSR_DATA_READY           0x01
+#define SERIAL_LSR_THR_EMPTY            0x20
+
+// Modem command register value which loops the transmitter back to the receiver, used to detect a port.
+#define SERIAL_MCR_LOOPBACK             0x1E
+
+// UART types, detected when a port is opened
+#define SERIAL_UART_NONE                0       /* No UART at the port */
+#define SERIAL_UART_8250                1       /* No FIFO (8250, 16450) */
+#define SERIAL_UART_16550               2       /* FIFO present but unusable */
+#define SERIAL_UART_16550A              3       /* 16-byte FIFOs */
+#define SERIAL_UART_16750               4       /* 64-byte FIFOs */
+
+// Sizes of the software buffers of a port, powers of two.
+#define SERIAL_TX_BUFFER_SIZE           4096
+#define SERIAL_RX_BUFFER_SIZE           1024
+
+/* Single-producer/single-consumer ring buffer. head is only written by the producer and tail only by the consumer, so
+ * the two sides need no lock: for the transmit ring the writers are the producer and the interrupt handler is the
+ * consumer, for the receive ring it is the other way round. The indices run freely and are masked on access, the ring
+ * is empty when they are equal and full when they differ by the size. */
+struct serial_ring {
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    uint32_t mask;              // size - 1
+    uint8_t *data;
+};
+
+struct serial_port {
+    uint16_t base;              // I/O port of the data register
+    uint8_t irq;
+    uint8_t type;               // SERIAL_UART_*
+    uint16_t divisor;
+    uint8_t rx_trigger;         // SERIAL_RX_TRIGGER_*
+    uint8_t interrupt_enable;   // shadow of the interrupt enable register
+    uint32_t fifo_size;         // bytes written to the transmit FIFO per THR empty interrupt
+    int open;
+    struct serial_ring tx;
+    struct serial_ring rx;
+    uint32_t tx_dropped;        // bytes not written because the transmit ring was full
+    uint32_t rx_dropped;        // bytes lost because the receive ring was full
+    struct spinlock lock;       // serializes the writers, the transmit side and the registers of the port
+};
+
+void init_serial();
+int serial_open(int com, uint16_t divisor, uint8_t rx_trigger);
+int serial_set_divisor(int com, uint16_t divisor);
+int serial_set_rx_trigger(int com, uint8_t rx_trigger);
+struct serial_port *serial_get_port(int com);
+void serial_set_console(int com);
+size_t serial_write(int com, const char *buf, size_t len);
+size_t serial_write_console(const char *buf, size_t len);
+void serial_write_str(const char *buf);
+size_t serial_read(int com, char *buf, size_t len);
+void serial_flush(int com);
+void serial_write_polled(int com, const char *buf, size_t len);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "pit.h"
+#include "../io/io.h"
+#include "../interrupts/irq.h"
+#include "../../include/div64.h"
+#include "../../kernel/time/ktime.h"
+#include "../../kernel/time/timer.h"
+
+/** pit_program:
+ *  Programs channel 0 of the Programmable Interval Timer to raise IRQ 0 once, after the given time.
+ *
+ *  @param delta Nanoseconds, at most PIT_MAX_DELTA
+ */
+static void pit_program(uint64_t delta) {
+    uint64_t count = delta * PIT_BASE_FREQUENCY;
+
+    div64_u32(&count, NSEC_PER_SEC);
+    // The reload value is 16 bits wide, 0 would stand for 65536.
+    if (count > 0xFFFF) {
+        count = 0xFFFF;
+    }
+    if (count == 0) {
+        count = 1;
+    }
+
+    /* Command byte
+     * Bit:     | 7 6 | 5 4 | 3 2 1 | 0 |
+     * Content: | ch  | acc | mode  | b |
+     * Value:   | 0 0 | 1 1 | 0 0 0 | 0 | = 0x30
+     *
+     * ch   = 0   | Channel 0, which is connected to IRQ 0
+     * acc  = 3   | Access mode lobyte/hibyte: the reload value is sent low byte first
+     * mode = 0   | Interrupt on terminal count: the output rises once when the counter reaches 0
+     * b    = 0   | 16-bit binary counter */
+    outb(PIT_COMMAND_PORT, 0x30);
+    outb(PIT_CHANNEL0_DATA_PORT, count & 0xFF);
+    outb(PIT_CHANNEL0_DATA_PORT, (count >> 8) & 0xFF);
+}
+
+/** pit_stop:
+ *  Stops channel 0. Writing the command byte drops the output, and the counter waits for a new reload value.
+ */
+static void pit_stop() {
+    outb(PIT_COMMAND_PORT, 0x30);
+}
+
+static struct clock_event pit_clock_event = {
+    .name = "pit",
+    .program = pit_program,
+    .stop = pit_stop,
+    .min_delta = PIT_MIN_DELTA,
+    .max_delta = PIT_MAX_DELTA,
+};
+
+/** pit_handler:
+ *  Handles the timer interrupt (IRQ 0).
+ */
+static int pit_handler(unsigned int irq, void *dev) {
+    (void) irq;
+    (void) dev;
+
+    timer_interrupt();
+
+    return IRQ_HANDLED;
+}
+
+/** init_pit:
+ *  Makes channel 0 of the PIT the clock event of the timers. The PIT raises its interrupt on the bootstrap processor
+ *  only, it is the fallback for machines without a local APIC timer.
+ */
+void init_pit() {
+    pit_stop();
+    request_irq(PIT_IRQ, pit_handler, "pit", 0);
+    timer_set_clock_event(&pit_clock_event);
+}
+
+/** pit_busy_wait:
+ *  Spins for the given time, counted by channel 2 of the PIT. Does not need interrupts, so it can calibrate other
+ *  timers during boot. Channel 2 drives the PC speaker, which stays off.
+ *
+ *  @param microseconds The time to wait, at most PIT_MAX_BUSY_WAIT
+ */
+void pit_busy_wait(uint32_t microseconds) {
+    uint32_t count;
+    uint8_t control;
+
+    if (microseconds > PIT_MAX_BUSY_WAIT) {
+        microseconds = PIT_MAX_BUSY_WAIT;
+    }
+    count = (PIT_BASE_FREQUENCY / 1000) * microseconds / 1000;
+    if (count == 0) {
+        count = 1;
+    }
+
+    // Speaker off, gate of channel 2 low while it is programmed.
+    control = inb(PIT_CONTROL_PORT) & ~(PIT_CONTROL_GATE2 | PIT_CONTROL_SPEAKER);
+    outb(PIT_CONTROL_PORT, control);
+
+    /* Command byte 0xB0: channel 2, lobyte/hibyte, mode 0 (interrupt on terminal count: OUT2 goes high once the
+     * counter reaches 0), binary. */
+    outb(PIT_COMMAND_PORT, 0xB0);
+    outb(PIT_CHANNEL2_DATA_PORT, count & 0xFF);
+    outb(PIT_CHANNEL2_DATA_PORT, (count >> 8) & 0xFF);
+
+    // The rising gate starts the count.
+    outb(PIT_CONTROL_PORT, control | PIT_CONTROL_GATE2);
+    while ((inb(PIT_CONTROL_PORT) & PIT_CONTROL_OUT2) == 0);
+
+    outb(PIT_CONTROL_PORT, control);
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef __PIT_H__
+#define __PIT_H__
+
+#include "../../include/stdint.h"
+
+// The PIT oscillator runs at 1.193182 MHz, the channels divide this frequency by a 16-bit reload value.
+#define PIT_BASE_FREQUENCY      1193182
+
+// The PIT I/O ports
+#define PIT_CHANNEL0_DATA_PORT  0x40
+#define PIT_CHANNEL2_DATA_PORT  0x42
+#define PIT_COMMAND_PORT        0x43
+
+// Port B of the keyboard controller holds the gate and the output of channel 2.
+#define PIT_CONTROL_PORT        0x61
+#define PIT_CONTROL_GATE2       0x01
+#define PIT_CONTROL_SPEAKER     0x02
+#define PIT_CONTROL_OUT2        0x20
+
+// The 16-bit counter of channel 2 runs out after 54.9 ms.
+#define PIT_MAX_BUSY_WAIT       50000       /* microseconds */
+
+// Range of the one-shot interrupt of channel 0: a few counts, up to the full 16-bit counter.
+#define PIT_MIN_DELTA           5000        /* nanoseconds */
+#define PIT_MAX_DELTA           54900000    /* nanoseconds */
+
+#define PIT_IRQ                 0
+
+void init_pit();
+void pit_busy_wait(uint32_t microseconds);
+
+#endif
\ No newline at end of file
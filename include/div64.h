@@ -0,0 +1,8 @@
+#ifndef __DIV64_H__
+#define __DIV64_H__
+
+#include "../include/stdint.h"
+
+uint32_t div64_u32(uint64_t *value, uint32_t divisor);
+
+#endif
\ No newline at end of file
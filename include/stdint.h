@@ -4,9 +4,14 @@
 typedef signed char     int8_t;
 typedef signed short    int16_t;
 typedef signed int      int32_t;
+typedef signed long long int64_t;
 
 typedef unsigned char   uint8_t;
 typedef unsigned short  uint16_t;
 typedef unsigned int    uint32_t;
+typedef unsigned long long uint64_t;
+
+// An integer as wide as a pointer, long is on both the i386 kernel and a 64-bit host build of lib/.
+typedef unsigned long   uintptr_t;
 
 #endif
\ No newline at end of file
@@ -0,0 +1,10 @@
+#ifndef __STDIO_H__
+#define __STDIO_H__
+
+#include "../include/stddef.h"
+#include "../include/stdarg.h"
+
+int vsnprintf(char *buf, size_t size, const char *format, va_list ap);
+int snprintf(char *buf, size_t size, const char *format, ...);
+
+#endif
\ No newline at end of file
@@ -3,9 +3,16 @@
 
 #include "../include/stddef.h"
 
+// Copies and fills of at least this many bytes go to the routines set by string_set_large_ops.
+#define STRING_LARGE_THRESHOLD  512
+
 size_t strlen(const char *s);
+size_t strnlen(const char *s, size_t maxlen);
+void *memcpy(void *dst, const void *src, size_t n);
 void *memmove(void *dst, const void *src, size_t n);
 void *memset(void *dest, int value, size_t n);
+int memcmp(const void *s1, const void *s2, size_t n);
 char* itoa(int value, char* str, int base);
+void string_set_large_ops(void *(*copy)(void *, const void *, size_t), void *(*fill)(void *, int, size_t));
 
 #endif
\ No newline at end of file
@@ -1,26 +1,66 @@
 global loader                   ; the entry symbol for ELF
+global boot_page_directory      ; also used by the application processors, see kernel/smp/trampoline.s
 extern os_main                  ; the C entrypoint
 
 ; GRUB will transfer control to the operating system by jumping to a position in memory. Before the jump,
 ; GRUB will look for a magic number to ensure that it is actually jumping to an OS and not some random code.
 ; This magic number is part of the multiboot specification which GRUB adheres to.
 MAGIC_NUMBER equ 0x1BADB002     ; define the magic number constant
-FLAGS        equ 0x0            ; multiboot flags(which indicates that no special features are enabled for the bootloader.)
-CHECKSUM     equ -MAGIC_NUMBER  ; calculate the checksum (magic number + checksum + flags should equal 0)
+MBOOT_PAGE_ALIGN equ 1 << 0     ; align loaded modules on page boundaries
+MBOOT_MEM_INFO   equ 1 << 1     ; provide the memory map in the multiboot information structure
+FLAGS        equ MBOOT_PAGE_ALIGN | MBOOT_MEM_INFO    ; multiboot flags
+CHECKSUM     equ -(MAGIC_NUMBER + FLAGS)  ; calculate the checksum (magic number + checksum + flags should equal 0)
 KERNEL_STACK_SIZE equ 4096      ; size of stack in bytes
 
+; The kernel is linked at KERNEL_VIRTUAL_BASE + 1 MB but loaded at 1 MB (see link.ld and mm/paging/paging.h).
+KERNEL_VIRTUAL_BASE equ 0xC0000000
+KERNEL_PDE_INDEX    equ KERNEL_VIRTUAL_BASE >> 22   ; page directory entry of the higher half (768)
+CR0_PG              equ 0x80000000                  ; paging enable bit of cr0
+CR4_PSE             equ 0x00000010                  ; 4 MB page enable bit of cr4
+PDE_4MB_KERNEL      equ 0x00000083                  ; present, writable, 4 MB page
+
 section .grub_sig
 signature:
     dd MAGIC_NUMBER             ; write the magic number to the machine code,
     dd FLAGS                    ; the flags,
     dd CHECKSUM                 ; and the checksum
 
+section .data align=4096
+; The page directory used until init_paging builds the real one. The first 4 MB of physical memory are mapped twice
+; with a single 4 MB page: at address 0, so the instructions following the enabling of paging can still be fetched
+; from their physical addresses, and at KERNEL_VIRTUAL_BASE, where the kernel is linked.
+boot_page_directory:
+    dd PDE_4MB_KERNEL                               ; 0x00000000 - 0x003FFFFF -> 0x00000000
+    times (KERNEL_PDE_INDEX - 1) dd 0
+    dd PDE_4MB_KERNEL                               ; 0xC0000000 - 0xC03FFFFF -> 0x00000000
+    times (1024 - KERNEL_PDE_INDEX - 1) dd 0
+
 section .text                   ; start of the text (code) section
 ; The align 4 directive is used to ensure that the code is aligned on a 4-byte boundary.
 ; This is a common requirement for x86 and x86-64 architectures, and ensures that the code will work correctly
 ; on all platforms. By aligning the code to a 4-byte boundary, the code can be accessed more efficiently by the CPU,
 ; which can improve performance.
-loader:                         ; the loader label (defined as entry point in linker script)
+; GRUB jumps to the entry point before paging is enabled, so the entry point must be given by its physical address.
+loader equ (_loader - KERNEL_VIRTUAL_BASE)          ; the loader label (defined as entry point in linker script)
+
+_loader:
+  ; Until paging is enabled the code runs at its physical address, every absolute address has to be translated.
+  mov ecx, (boot_page_directory - KERNEL_VIRTUAL_BASE)
+  mov cr3, ecx                  ; load the boot page directory
+
+  mov ecx, cr4
+  or ecx, CR4_PSE               ; enable 4 MB pages
+  mov cr4, ecx
+
+  mov ecx, cr0
+  or ecx, CR0_PG                ; enable paging
+  mov cr0, ecx
+
+  ; Jump to the higher half with an absolute jump, eip is still a low address.
+  lea ecx, [higher_half]
+  jmp ecx
+
+higher_half:
   ; We could point esp to a random area in memory since, so far, the only thing in the memory is GRUB, BIOS,
   ; the OS kernel and some memory-mapped I/O. This is not a good idea - we don’t know how much memory is available or
   ; if the area esp would point to is used by something else. A better idea is to reserve a piece of uninitialized
@@ -28,9 +68,14 @@ loader:                         ; the loader label (defined as entry point in li
   ; section to reduce the size of the OS executable. Since GRUB understands ELF, GRUB will allocate any memory
   ; reserved in the bss section when loading the OS.
   mov esp, kernel_stack + KERNEL_STACK_SIZE   ; point esp to the start of the stack (end of memory area)
+  ; GRUB leaves the magic value in eax and the physical address of the multiboot information structure in ebx,
+  ; pass both to os_main(magic, mbi). eax and ebx are not touched above, only ecx is used.
+  push ebx
+  push eax
   call os_main
 .loop:
-    jmp .loop                   ; loop forever
+    hlt                         ; os_main only returns when booting failed, sleep until an interrupt
+    jmp .loop
 
 section .bss
 align 4
@@ -0,0 +1,63 @@
+#ifndef __MULTIBOOT_H__
+#define __MULTIBOOT_H__
+
+#include "../include/stdint.h"
+
+// The value GRUB leaves in eax when it jumps to the kernel.
+#define MULTIBOOT_BOOTLOADER_MAGIC  0x2BADB002
+
+/* Flags of the multiboot information structure. A field of the structure is only valid if the corresponding bit is
+ * set in the flags field. */
+#define MULTIBOOT_INFO_MEMORY       0x00000001  /* mem_lower and mem_upper are valid */
+#define MULTIBOOT_INFO_CMDLINE      0x00000004  /* cmdline is valid */
+#define MULTIBOOT_INFO_MODS         0x00000008  /* mods_count and mods_addr are valid */
+#define MULTIBOOT_INFO_MEM_MAP      0x00000040  /* mmap_length and mmap_addr are valid */
+
+// Types of the memory map entries.
+#define MULTIBOOT_MEMORY_AVAILABLE  1
+#define MULTIBOOT_MEMORY_RESERVED   2
+
+/* The multiboot information structure. GRUB passes its physical address in ebx.
+ * Based on https://www.gnu.org/software/grub/manual/multiboot/multiboot.html */
+struct multiboot_info {
+    uint32_t flags;
+    uint32_t mem_lower;         // Amount of lower memory in kilobytes, starting at address 0.
+    uint32_t mem_upper;         // Amount of upper memory in kilobytes, starting at address 1 MB.
+    uint32_t boot_device;
+    uint32_t cmdline;
+    uint32_t mods_count;
+    uint32_t mods_addr;
+    uint32_t syms[4];
+    uint32_t mmap_length;       // Size of the memory map buffer in bytes.
+    uint32_t mmap_addr;         // Physical address of the first memory map entry.
+    uint32_t drives_length;
+    uint32_t drives_addr;
+    uint32_t config_table;
+    uint32_t boot_loader_name;
+    uint32_t apm_table;
+    uint32_t vbe_control_info;
+    uint32_t vbe_mode_info;
+    uint16_t vbe_mode;
+    uint16_t vbe_interface_seg;
+    uint16_t vbe_interface_off;
+    uint16_t vbe_interface_len;
+} __attribute__((packed));
+
+/* Memory map entry. The size field holds the size of the rest of the entry, it is not included in the size itself,
+ * so the next entry starts at (address of the entry + size + 4). */
+// A module loaded by GRUB, mods_addr points to an array of mods_count of them.
+struct multiboot_module {
+    uint32_t mod_start;         // Physical address of the first byte of the module.
+    uint32_t mod_end;           // Physical address of the byte after the module.
+    uint32_t cmdline;           // Physical address of the command line of the module, a zero terminated string.
+    uint32_t reserved;
+} __attribute__((packed));
+
+struct multiboot_mmap_entry {
+    uint32_t size;
+    uint64_t addr;
+    uint64_t len;
+    uint32_t type;
+} __attribute__((packed));
+
+#endif
\ No newline at end of file
@@ -1,15 +1,111 @@
 #include "../drivers/framebuffer/framebuffer.h"
+#include "../kernel/console/console.h"
 #include "../drivers/serial/serial.h"
 #include "../mm/segmentation/gdt.h"
+#include "../mm/paging/paging.h"
+#include "../mm/physical/pmm.h"
+#include "../mm/slab/slab.h"
 #include "../drivers/interrupts/idt.h"
 #include "../drivers/keyboard/keyboard.h"
+#include "../drivers/timer/pit.h"
+#include "../drivers/apic/apic.h"
+#include "../drivers/apic/lapic.h"
+#include "../kernel/acpi/acpi.h"
+#include "../kernel/smp/smp.h"
+#include "../kernel/sched/sched.h"
+#include "../kernel/cpu/fpu.h"
+#include "../kernel/syscall/syscall.h"
+#include "../kernel/module/module.h"
+#include "../kernel/process/process.h"
+#include "../mm/vm/vm.h"
+#include "../kernel/log/log.h"
+#include "../kernel/time/ktime.h"
+#include "../bench/bench.h"
+#include "../include/string.h"
+#include "multiboot.h"
+
+/** cmdline_has_option:
+ *  Checks whether the kernel command line GRUB passed contains the given word. The first word is the kernel path.
+ */
+static int cmdline_has_option(struct multiboot_info *mbi, const char *option) {
+    const char *cmdline;
+    size_t length = strlen(option);
+
+    if (!(mbi->flags & MULTIBOOT_INFO_CMDLINE) || mbi->cmdline == 0) {
+        return 0;
+    }
+
+    cmdline = phys_to_virt(mbi->cmdline);
+    while (*cmdline) {
+        const char *word = cmdline;
+
+        while (*cmdline && *cmdline != ' ') {
+            cmdline++;
+        }
+        if ((size_t) (cmdline - word) == length && memcmp(word, option, length) == 0) {
+            return 1;
+        }
+        while (*cmdline == ' ') {
+            cmdline++;
+        }
+    }
+    return 0;
+}
+
+/** os_main:
+ *  The C entrypoint, called by the loader.
+ *
+ *  @param magic The magic value GRUB leaves in eax
+ *  @param mbi   Physical address of the multiboot information structure
+ */
+void os_main(uint32_t magic, struct multiboot_info *mbi) {
+    int run_benchmarks;
 
-void os_main() {
     fb_clear();
     fb_write_str("Welcome to SaturnOS!\n");
     serial_write_str("test");
+
+    if (magic != MULTIBOOT_BOOTLOADER_MAGIC) {
+        os_printf("Invalid multiboot magic: 0x%x\n", magic);
+        return;
+    }
+    mbi = phys_to_virt(mbi);
+    // Read before the memory of the boot loader is handed out.
+    run_benchmarks = cmdline_has_option(mbi, "bench");
+    init_modules(mbi);
+
     init_gdt();
+    init_fpu();
+    init_paging(mbi);
+    init_pmm(mbi);
+    init_slab();
+    sched_init();
     init_idt();
+    init_syscall();
+    init_vm();
+    init_ktime();
+    // Without ACPI tables or an APIC, the IRQ lines stay on the 8259 init_idt set up.
+    if (init_acpi() == 0) {
+        init_apic();
+    }
+    init_serial();
+    console_register_sink(&console_serial_sink);
+    if (lapic_timer_init() != 0) {
+        init_pit();
+    }
+    init_log_drain();
+    init_smp();
+    log_info("Memory: %u KB free of %u KB", pmm_free_frame_count() * (PAGE_SIZE / 1024),
+             pmm_total_frame_count() * (PAGE_SIZE / 1024));
+
     init_keyboard();
     //asm volatile ("int $0x3");
+
+    if (run_benchmarks) {
+        bench_run_all();
+    }
+    process_spawn_modules();
+
+    // Initialization is done, the boot thread ends here and the idle thread halts the CPU while nothing is ready.
+    thread_exit();
 }
\ No newline at end of file
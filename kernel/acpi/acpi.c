@@ -0,0 +1,219 @@
+#include "acpi.h"
+#include "../../include/string.h"
+#include "../../mm/paging/paging.h"
+#include "../log/log.h"
+
+/* ACPI tables
+ *
+ * The firmware describes the machine in tables reached from the Root System Description Pointer: the RSDT (or, from
+ * ACPI 2.0 on, the XSDT with 64-bit addresses) lists the physical addresses of the other tables. Only the MADT is used
+ * so far, it lists the processors, the IO APICs and how the ISA IRQs are wired to the IO APIC inputs.
+ *
+ * The tables usually lie in the direct map; the ones above it are mapped into the MMIO window. */
+
+static const struct acpi_header *root_table;
+static uint32_t root_entry_size;
+static struct acpi_madt_info madt_info;
+static int madt_found;
+
+/** acpi_map:
+ *  Returns a virtual address of physical memory holding firmware tables.
+ *
+ *  @return The virtual address, 0 if it cannot be mapped
+ */
+static const void *acpi_map(uint32_t physical_address, uint32_t length) {
+    if (physical_address + length > physical_address && physical_address + length <= paging_direct_map_end()) {
+        return phys_to_virt(physical_address);
+    }
+    return paging_map_mmio(physical_address, length);
+}
+
+/** acpi_checksum:
+ *  Adds up the bytes of a structure, a valid ACPI structure sums up to 0.
+ */
+static uint8_t acpi_checksum(const void *data, uint32_t length) {
+    const uint8_t *bytes = data;
+    uint8_t sum = 0;
+
+    for (uint32_t i = 0; i < length; i++) {
+        sum += bytes[i];
+    }
+    return sum;
+}
+
+/** acpi_scan_rsdp:
+ *  Searches a physical memory range for the RSDP.
+ *
+ *  @return The RSDP, 0 if the range has none
+ */
+static const struct acpi_rsdp *acpi_scan_rsdp(uint32_t start, uint32_t end) {
+    for (uint32_t address = start & ~0xF; address + 20 <= end; address += 16) {
+        const struct acpi_rsdp *rsdp = phys_to_virt(address);
+
+        if (memcmp(rsdp->signature, "RSD PTR ", 8) == 0 && acpi_checksum(rsdp, 20) == 0) {
+            return rsdp;
+        }
+    }
+    return 0;
+}
+
+/** acpi_map_table:
+ *  Maps a system description table and validates its checksum.
+ *
+ *  @return The table, 0 if it is invalid
+ */
+static const struct acpi_header *acpi_map_table(uint32_t physical_address) {
+    const struct acpi_header *header = acpi_map(physical_address, sizeof(struct acpi_header));
+
+    if (header == 0 || header->length < sizeof(struct acpi_header)) {
+        return 0;
+    }
+    // A table outside the direct map was only mapped up to its header.
+    header = acpi_map(physical_address, header->length);
+    if (header == 0 || acpi_checksum(header, header->length) != 0) {
+        return 0;
+    }
+    return header;
+}
+
+/** acpi_parse_madt:
+ *  Collects the processors, the IO APICs and the ISA IRQ routing from the MADT.
+ */
+static void acpi_parse_madt(const struct acpi_madt *madt) {
+    const uint8_t *entry = (const uint8_t *) (madt + 1);
+    const uint8_t *end = (const uint8_t *) madt + madt->header.length;
+
+    madt_info.lapic_address = madt->lapic_address;
+    madt_info.pcat_compat = madt->flags & ACPI_MADT_PCAT_COMPAT;
+    // Without an override, ISA IRQ n is input n of the IO APICs, active high and edge triggered.
+    for (int i = 0; i < ACPI_ISA_IRQS; i++) {
+        madt_info.isa_routes[i].gsi = i;
+        madt_info.isa_routes[i].flags = 0;
+    }
+
+    while (entry + sizeof(struct acpi_madt_entry) <= end) {
+        const struct acpi_madt_entry *header = (const struct acpi_madt_entry *) entry;
+
+        if (header->length < sizeof(struct acpi_madt_entry) || entry + header->length > end) {
+            break;
+        }
+
+        if (header->type == ACPI_MADT_LAPIC) {
+            const struct acpi_madt_lapic *lapic = (const struct acpi_madt_lapic *) entry;
+
+            if ((lapic->flags & ACPI_MADT_LAPIC_ENABLED) && madt_info.cpu_count < ACPI_MAX_CPUS) {
+                madt_info.cpu_apic_ids[madt_info.cpu_count++] = lapic->apic_id;
+            }
+        }
+        else if (header->type == ACPI_MADT_IOAPIC) {
+            const struct acpi_madt_ioapic *ioapic = (const struct acpi_madt_ioapic *) entry;
+
+            if (madt_info.ioapic_count < ACPI_MAX_IOAPICS) {
+                madt_info.ioapics[madt_info.ioapic_count].id = ioapic->id;
+                madt_info.ioapics[madt_info.ioapic_count].address = ioapic->address;
+                madt_info.ioapics[madt_info.ioapic_count].gsi_base = ioapic->gsi_base;
+                madt_info.ioapic_count++;
+            }
+        }
+        else if (header->type == ACPI_MADT_OVERRIDE) {
+            const struct acpi_madt_override *override = (const struct acpi_madt_override *) entry;
+
+            if (override->bus == 0 && override->source < ACPI_ISA_IRQS) {
+                madt_info.isa_routes[override->source].gsi = override->gsi;
+                madt_info.isa_routes[override->source].flags = override->flags;
+            }
+        }
+        else if (header->type == ACPI_MADT_LAPIC_ADDRESS) {
+            const struct acpi_madt_lapic_address *address = (const struct acpi_madt_lapic_address *) entry;
+
+            if ((address->address >> 32) == 0) {
+                madt_info.lapic_address = (uint32_t) address->address;
+            }
+        }
+        entry += header->length;
+    }
+}
+
+/** init_acpi:
+ *  Locates the ACPI tables and parses the MADT. Requires paging.
+ *
+ *  @return 0 on success, -1 if the firmware provides no ACPI tables
+ */
+int init_acpi() {
+    uint32_t ebda = (uint32_t) *(uint16_t *) phys_to_virt(ACPI_EBDA_POINTER) << 4;
+    const struct acpi_rsdp *rsdp = 0;
+    const struct acpi_madt *madt;
+
+    if (ebda >= 0x80000 && ebda < 0xA0000) {
+        rsdp = acpi_scan_rsdp(ebda, ebda + 1024);
+    }
+    if (rsdp == 0) {
+        rsdp = acpi_scan_rsdp(ACPI_BIOS_AREA_START, ACPI_BIOS_AREA_END);
+    }
+    if (rsdp == 0) {
+        return -1;
+    }
+
+    // The XSDT is only usable if the 32-bit kernel can reach it.
+    if (rsdp->revision >= 2 && rsdp->xsdt_address && (rsdp->xsdt_address >> 32) == 0 &&
+        acpi_checksum(rsdp, rsdp->length) == 0) {
+        root_table = acpi_map_table((uint32_t) rsdp->xsdt_address);
+        root_entry_size = 8;
+    }
+    if (root_table == 0) {
+        root_table = acpi_map_table(rsdp->rsdt_address);
+        root_entry_size = 4;
+    }
+    if (root_table == 0) {
+        return -1;
+    }
+
+    madt = (const struct acpi_madt *) acpi_find_table("APIC");
+    if (madt) {
+        acpi_parse_madt(madt);
+        madt_found = 1;
+        log_info("ACPI: %d CPUs, %d IO APICs, local APIC at 0x%x", madt_info.cpu_count, madt_info.ioapic_count,
+                 madt_info.lapic_address);
+    }
+
+    return 0;
+}
+
+/** acpi_find_table:
+ *  Looks up a system description table.
+ *
+ *  @param signature The 4 character signature of the table, e.g. "APIC"
+ *  @return          The table, 0 if the firmware provides none or it is invalid
+ */
+const struct acpi_header *acpi_find_table(const char *signature) {
+    const uint8_t *entries;
+    uint32_t count;
+
+    if (root_table == 0) {
+        return 0;
+    }
+
+    entries = (const uint8_t *) (root_table + 1);
+    count = (root_table->length - sizeof(struct acpi_header)) / root_entry_size;
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t *entry = (const uint32_t *) (entries + i * root_entry_size);
+        const struct acpi_header *table;
+
+        // The upper half of an XSDT entry must be 0 for the table to be reachable.
+        if (root_entry_size == 8 && entry[1] != 0) {
+            continue;
+        }
+        table = acpi_map_table(entry[0]);
+        if (table && memcmp(table->signature, signature, 4) == 0) {
+            return table;
+        }
+    }
+    return 0;
+}
+
+/** acpi_get_madt:
+ *  Returns what the MADT tells about the interrupt controllers, 0 if there is no MADT.
+ */
+const struct acpi_madt_info *acpi_get_madt() {
+    return madt_found ? &madt_info : 0;
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#ifndef __ACPI_H__
+#define __ACPI_H__
+
+#include "../../include/stdint.h"
+
+// The RSDP is searched in the first KB of the EBDA and in the BIOS area, on 16-byte boundaries.
+#define ACPI_EBDA_POINTER       0x40E       /* BDA word holding the real mode segment of the EBDA */
+#define ACPI_BIOS_AREA_START    0xE0000
+#define ACPI_BIOS_AREA_END      0x100000
+
+#define ACPI_MAX_CPUS           16
+#define ACPI_MAX_IOAPICS        4
+#define ACPI_ISA_IRQS           16
+
+// MADT flags and entry types
+#define ACPI_MADT_PCAT_COMPAT   0x01        /* the system also has 8259 PICs */
+#define ACPI_MADT_LAPIC         0
+#define ACPI_MADT_IOAPIC        1
+#define ACPI_MADT_OVERRIDE      2
+#define ACPI_MADT_LAPIC_ADDRESS 5
+#define ACPI_MADT_LAPIC_ENABLED 0x01
+
+// Polarity (bits 0 - 1) and trigger mode (bits 2 - 3) in the flags of an interrupt source override
+#define ACPI_POLARITY_MASK      0x03
+#define ACPI_POLARITY_HIGH      0x01
+#define ACPI_POLARITY_LOW       0x03
+#define ACPI_TRIGGER_MASK       0x0C
+#define ACPI_TRIGGER_EDGE       0x04
+#define ACPI_TRIGGER_LEVEL      0x0C
+
+// Root System Description Pointer, revision 2 adds the fields from length on.
+struct acpi_rsdp {
+    char signature[8];              // "RSD PTR "
+    uint8_t checksum;               // the first 20 bytes sum up to 0
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_address;
+    uint32_t length;
+    uint64_t xsdt_address;
+    uint8_t extended_checksum;      // the whole structure sums up to 0
+    uint8_t reserved[3];
+} __attribute__((packed));
+
+// Header of every system description table, the whole table sums up to 0.
+struct acpi_header {
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} __attribute__((packed));
+
+// Multiple APIC Description Table ("APIC"), followed by variable length entries.
+struct acpi_madt {
+    struct acpi_header header;
+    uint32_t lapic_address;
+    uint32_t flags;
+} __attribute__((packed));
+
+struct acpi_madt_entry {
+    uint8_t type;
+    uint8_t length;
+} __attribute__((packed));
+
+struct acpi_madt_lapic {
+    struct acpi_madt_entry entry;
+    uint8_t processor_id;
+    uint8_t apic_id;
+    uint32_t flags;
+} __attribute__((packed));
+
+struct acpi_madt_ioapic {
+    struct acpi_madt_entry entry;
+    uint8_t id;
+    uint8_t reserved;
+    uint32_t address;
+    uint32_t gsi_base;              // first global system interrupt of the IO APIC
+} __attribute__((packed));
+
+// An ISA IRQ which is not connected to the IO APIC input of the same number, or not active high and edge triggered.
+struct acpi_madt_override {
+    struct acpi_madt_entry entry;
+    uint8_t bus;                    // 0, ISA
+    uint8_t source;                 // the ISA IRQ
+    uint32_t gsi;
+    uint16_t flags;
+} __attribute__((packed));
+
+struct acpi_madt_lapic_address {
+    struct acpi_madt_entry entry;
+    uint16_t reserved;
+    uint64_t address;
+} __attribute__((packed));
+
+struct acpi_ioapic_info {
+    uint8_t id;
+    uint32_t address;
+    uint32_t gsi_base;
+};
+
+// Routing of an ISA IRQ to a global system interrupt
+struct acpi_isa_route {
+    uint32_t gsi;
+    uint16_t flags;                 // polarity and trigger mode, 0 for the ISA default (active high, edge)
+};
+
+// What the MADT tells about the interrupt controllers
+struct acpi_madt_info {
+    uint32_t lapic_address;
+    int pcat_compat;
+    int cpu_count;
+    uint8_t cpu_apic_ids[ACPI_MAX_CPUS];
+    int ioapic_count;
+    struct acpi_ioapic_info ioapics[ACPI_MAX_IOAPICS];
+    struct acpi_isa_route isa_routes[ACPI_ISA_IRQS];
+};
+
+int init_acpi();
+const struct acpi_header *acpi_find_table(const char *signature);
+const struct acpi_madt_info *acpi_get_madt();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "console.h"
+#include "../sync/spinlock.h"
+#include "../../include/stdio.h"
+#include "../../include/stdarg.h"
+#include "../../drivers/framebuffer/framebuffer.h"
+#include "../../drivers/serial/serial.h"
+
+/* Console
+ *
+ * os_printf formats its whole output into a buffer first and then hands it to the registered sinks in one call each,
+ * so a sink sees whole messages and pays its fixed costs (flushing the screen, kicking the UART) once per message.
+ * The VGA console and the in-memory log are registered from the start, the serial console once the UART is set up.
+ *
+ * The sink list and the sinks are protected by console_lock, so the output of different processors is not mixed. */
+
+static void vga_write(const char *buf, size_t len);
+static void serial_console_write(const char *buf, size_t len);
+static void memory_write(const char *buf, size_t len);
+
+struct console_sink console_memory_sink = {"memory", memory_write, 1, 0};
+struct console_sink console_vga_sink = {"vga", vga_write, 1, &console_memory_sink};
+struct console_sink console_serial_sink = {"serial", serial_console_write, 1, 0};
+
+static struct console_sink *sinks = &console_vga_sink;
+static struct spinlock console_lock = SPINLOCK_INIT;
+
+static char log_buffer[CONSOLE_LOG_SIZE];
+static uint32_t log_head;               // total number of characters written to the log
+
+static void vga_write(const char *buf, size_t len) {
+    fb_write(buf, len);
+}
+
+static void serial_console_write(const char *buf, size_t len) {
+    serial_write_console(buf, len);
+}
+
+/** memory_write:
+ *  Appends to the in-memory log, overwriting the oldest characters when it is full.
+ */
+static void memory_write(const char *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        log_buffer[log_head++ & (CONSOLE_LOG_SIZE - 1)] = buf[i];
+    }
+}
+
+/** console_register_sink:
+ *  Adds a sink to the console. The sink receives the output written from now on.
+ *
+ *  @param sink The sink, it must stay valid while it is registered
+ */
+void console_register_sink(struct console_sink *sink) {
+    uint32_t flags = spin_lock_irqsave(&console_lock);
+
+    sink->next = sinks;
+    sinks = sink;
+    spin_unlock_irqrestore(&console_lock, flags);
+}
+
+/** console_unregister_sink:
+ *  Removes a sink from the console.
+ *
+ *  @param sink The sink
+ */
+void console_unregister_sink(struct console_sink *sink) {
+    uint32_t flags = spin_lock_irqsave(&console_lock);
+    struct console_sink **link = &sinks;
+
+    while (*link && *link != sink) {
+        link = &(*link)->next;
+    }
+    if (*link) {
+        *link = sink->next;
+        sink->next = 0;
+    }
+    spin_unlock_irqrestore(&console_lock, flags);
+}
+
+/** console_write:
+ *  Writes a buffer to all enabled sinks. Output of concurrent writers is not interleaved.
+ *
+ *  @param buf The characters
+ *  @param len Number of characters
+ */
+void console_write(const char *buf, size_t len) {
+    uint32_t flags = spin_lock_irqsave(&console_lock);
+
+    for (struct console_sink *sink = sinks; sink; sink = sink->next) {
+        if (sink->enabled) {
+            sink->write(buf, len);
+        }
+    }
+    spin_unlock_irqrestore(&console_lock, flags);
+}
+
+/** os_printf:
+ *  Writes the string pointed by format to the console. If format includes format specifiers
+ *  (subsequences beginning with %), the additional arguments following format are formatted and inserted in the
+ *  resulting string replacing their respective specifiers. See vsnprintf for the supported specifiers.
+ *
+ * @param format C string that contains the text to be written to the console.
+ */
+void os_printf(const char *format, ...) {
+    char buf[CONSOLE_PRINTF_BUFFER_SIZE];
+    va_list ap;
+    int len;
+
+    va_start(ap, format);
+    len = vsnprintf(buf, sizeof(buf), format, ap);
+    va_end(ap);
+
+    if (len >= (int) sizeof(buf)) {
+        len = sizeof(buf) - 1;
+    }
+    console_write(buf, len);
+}
+
+/** console_log_read:
+ *  Copies the most recent content of the in-memory log.
+ *
+ *  @param buf  Destination
+ *  @param size Size of the destination
+ *  @return     Number of characters copied, the last ones written to the log
+ */
+size_t console_log_read(char *buf, size_t size) {
+    uint32_t flags = spin_lock_irqsave(&console_lock);
+    uint32_t stored = log_head < CONSOLE_LOG_SIZE ? log_head : CONSOLE_LOG_SIZE;
+    uint32_t count = size < stored ? size : stored;
+    uint32_t start = log_head - count;
+
+    for (uint32_t i = 0; i < count; i++) {
+        buf[i] = log_buffer[(start + i) & (CONSOLE_LOG_SIZE - 1)];
+    }
+    spin_unlock_irqrestore(&console_lock, flags);
+
+    return count;
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef __CONSOLE_H__
+#define __CONSOLE_H__
+
+#include "../../include/stdint.h"
+#include "../../include/stddef.h"
+
+// os_printf formats into a buffer of this size on the stack, longer output is truncated.
+#define CONSOLE_PRINTF_BUFFER_SIZE  512
+
+// Size of the in-memory log written by console_memory_sink, a power of two.
+#define CONSOLE_LOG_SIZE            16384
+
+/* A destination of the console output. The formatted text is handed to every enabled sink in one piece. */
+struct console_sink {
+    const char *name;
+    void (*write)(const char *buf, size_t len);
+    int enabled;
+    struct console_sink *next;
+};
+
+extern struct console_sink console_vga_sink;
+extern struct console_sink console_serial_sink;
+extern struct console_sink console_memory_sink;
+
+void console_register_sink(struct console_sink *sink);
+void console_unregister_sink(struct console_sink *sink);
+void console_write(const char *buf, size_t len);
+void os_printf(const char *format, ...);
+size_t console_log_read(char *buf, size_t size);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "cpu.h"
+
+/** cpuid:
+ *  Executes the CPUID instruction for the given leaf.
+ *
+ *  @param leaf The value of eax when CPUID is executed
+ *  @param eax  Set to the value of eax after CPUID
+ *  @param ebx  Set to the value of ebx after CPUID
+ *  @param ecx  Set to the value of ecx after CPUID
+ *  @param edx  Set to the value of edx after CPUID
+ */
+void cpuid(uint32_t leaf, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx) {
+    asm volatile("cpuid" : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx) : "a"(leaf), "c"(0));
+}
+
+/** cpu_has_feature:
+ *  Checks whether the processor reports the given feature in edx of CPUID leaf 1.
+ *
+ *  @param feature One of the CPU_FEATURE_* flags
+ *  @return        Non-zero if the feature is supported
+ */
+int cpu_has_feature(uint32_t feature) {
+    uint32_t eax, ebx, ecx, edx;
+
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    return (edx & feature) != 0;
+}
+
+/** cpu_has_invariant_tsc:
+ *  Checks whether the time stamp counter runs at a constant rate, independent of frequency changes and sleep states.
+ *
+ *  @return Non-zero if the TSC is invariant
+ */
+int cpu_has_invariant_tsc() {
+    uint32_t eax, ebx, ecx, edx;
+
+    cpuid(CPUID_EXTENDED_MAX, &eax, &ebx, &ecx, &edx);
+    if (eax < CPUID_POWER_MANAGEMENT) {
+        return 0;
+    }
+    cpuid(CPUID_POWER_MANAGEMENT, &eax, &ebx, &ecx, &edx);
+    return (edx & CPU_APM_INVARIANT_TSC) != 0;
+}
+
+uint32_t read_cr0() {
+    uint32_t value;
+    asm volatile("mov %%cr0, %0" : "=r"(value));
+    return value;
+}
+
+void write_cr0(uint32_t value) {
+    asm volatile("mov %0, %%cr0" : : "r"(value) : "memory");
+}
+
+uint32_t read_cr2() {
+    uint32_t value;
+    asm volatile("mov %%cr2, %0" : "=r"(value));
+    return value;
+}
+
+uint32_t read_cr3() {
+    uint32_t value;
+    asm volatile("mov %%cr3, %0" : "=r"(value));
+    return value;
+}
+
+void write_cr3(uint32_t value) {
+    asm volatile("mov %0, %%cr3" : : "r"(value) : "memory");
+}
+
+uint32_t read_cr4() {
+    uint32_t value;
+    asm volatile("mov %%cr4, %0" : "=r"(value));
+    return value;
+}
+
+void write_cr4(uint32_t value) {
+    asm volatile("mov %0, %%cr4" : : "r"(value) : "memory");
+}
+
+/** invlpg:
+ *  Invalidates the TLB entry of the page that contains the given virtual address.
+ *
+ *  @param address Virtual address
+ */
+void invlpg(uint32_t address) {
+    asm volatile("invlpg (%0)" : : "r"(address) : "memory");
+}
+
+/** rdmsr:
+ *  Reads a model specific register.
+ */
+uint64_t rdmsr(uint32_t msr) {
+    uint32_t low, high;
+
+    asm volatile("rdmsr" : "=a"(low), "=d"(high) : "c"(msr));
+    return ((uint64_t) high << 32) | low;
+}
+
+/** wrmsr:
+ *  Writes a model specific register.
+ */
+void wrmsr(uint32_t msr, uint64_t value) {
+    asm volatile("wrmsr" : : "c"(msr), "a"((uint32_t) value), "d"((uint32_t) (value >> 32)) : "memory");
+}
+
+/** irq_save:
+ *  Disables the interrupts and returns the previous value of EFLAGS, to be passed to irq_restore. Sections between
+ *  irq_save and irq_restore can not be preempted.
+ *
+ *  @return The value of EFLAGS before the interrupts were disabled
+ */
+uint32_t irq_save() {
+    uint32_t flags;
+    asm volatile("pushf\n\tpop %0\n\tcli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+/** irq_restore:
+ *  Enables the interrupts again if they were enabled when irq_save returned the given flags.
+ *
+ *  @param flags The value returned by irq_save
+ */
+void irq_restore(uint32_t flags) {
+    if (flags & EFLAGS_IF) {
+        asm volatile("sti" : : : "memory");
+    }
+}
\ No newline at end of file
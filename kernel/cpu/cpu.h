@@ -0,0 +1,72 @@
+#ifndef __CPU_H__
+#define __CPU_H__
+
+#include "../../include/stdint.h"
+
+// Feature flags reported in edx by CPUID leaf 1
+#define CPU_FEATURE_FPU     (1 << 0)    /* x87 FPU on chip */
+#define CPU_FEATURE_PSE     (1 << 3)    /* Page Size Extension (4 MB pages) */
+#define CPU_FEATURE_TSC     (1 << 4)    /* Time Stamp Counter */
+#define CPU_FEATURE_MSR     (1 << 5)    /* RDMSR and WRMSR instructions */
+#define CPU_FEATURE_APIC    (1 << 9)    /* APIC on chip */
+#define CPU_FEATURE_SEP     (1 << 11)   /* SYSENTER and SYSEXIT instructions */
+#define CPU_FEATURE_PGE     (1 << 13)   /* Page Global Enable */
+#define CPU_FEATURE_FXSR    (1 << 24)   /* FXSAVE and FXRSTOR instructions */
+#define CPU_FEATURE_SSE     (1 << 25)   /* SSE extensions */
+#define CPU_FEATURE_SSE2    (1 << 26)   /* SSE2 extensions */
+
+// Extended CPUID leaves
+#define CPUID_EXTENDED_MAX      0x80000000  /* eax: highest extended leaf */
+#define CPUID_POWER_MANAGEMENT  0x80000007  /* edx: advanced power management features */
+#define CPU_APM_INVARIANT_TSC   (1 << 8)    /* the TSC runs at a constant rate in every P-, C- and T-state */
+
+// EFLAGS bits
+#define EFLAGS_IF           (1 << 9)    /* Interrupt enable flag */
+
+// Control register bits
+#define CR0_MP              (1 << 1)    /* Monitor coprocessor: wait/fwait honour TS */
+#define CR0_EM              (1 << 2)    /* Emulation: FPU instructions raise #NM */
+#define CR0_TS              (1 << 3)    /* Task switched: the next FPU instruction raises #NM */
+#define CR0_NE              (1 << 5)    /* Native FPU error reporting */
+#define CR0_WP              (1 << 16)   /* Write Protect: supervisor writes honour read-only pages */
+#define CR0_PG              (1 << 31)   /* Paging */
+#define CR4_PSE             (1 << 4)    /* Page Size Extensions */
+#define CR4_PGE             (1 << 7)    /* Page Global Enable */
+#define CR4_OSFXSR          (1 << 9)    /* FXSAVE/FXRSTOR and SSE instructions enabled */
+#define CR4_OSXMMEXCPT      (1 << 10)   /* Unmasked SSE floating point exceptions raise #XM */
+
+// Model specific registers
+#define MSR_APIC_BASE       0x1B
+#define MSR_APIC_BASE_BSP   (1 << 8)    /* the processor is the bootstrap processor */
+#define MSR_APIC_BASE_EN    (1 << 11)   /* the local APIC is enabled */
+#define MSR_SYSENTER_CS     0x174       /* kernel code selector loaded by sysenter, the other selectors follow it */
+#define MSR_SYSENTER_ESP    0x175       /* stack pointer loaded by sysenter */
+#define MSR_SYSENTER_EIP    0x176       /* entry point of sysenter */
+
+/** rdtsc:
+ *  Reads the time stamp counter. Inline, so that measurements do not include the cost of a call.
+ */
+static inline uint64_t rdtsc() {
+    uint32_t low, high;
+
+    asm volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t) high << 32) | low;
+}
+
+void cpuid(uint32_t leaf, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx);
+int cpu_has_feature(uint32_t feature);
+int cpu_has_invariant_tsc();
+uint32_t read_cr0();
+void write_cr0(uint32_t value);
+uint32_t read_cr2();
+uint32_t read_cr3();
+void write_cr3(uint32_t value);
+uint32_t read_cr4();
+void write_cr4(uint32_t value);
+void invlpg(uint32_t address);
+uint64_t rdmsr(uint32_t msr);
+void wrmsr(uint32_t msr, uint64_t value);
+uint32_t irq_save();
+void irq_restore(uint32_t flags);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,298 @@
+#include "fpu.h"
+#include "cpu.h"
+#include "../sched/sched.h"
+#include "../smp/smp.h"
+#include "../../drivers/interrupts/isr.h"
+#include "../../include/string.h"
+
+/* FPU and SSE support
+ *
+ * The FPU and SSE registers are switched lazily. A context switch only sets CR0.TS, the first FPU or SSE instruction
+ * of the next thread then raises #NM (vector 7), whose handler loads the saved registers of the thread. Threads which
+ * never touch the FPU cost nothing; a thread which did is saved when it is switched out, one fxsave. Every processor
+ * remembers the thread whose registers it holds (its owner): a thread which runs on the same processor again, with no
+ * other thread having used the FPU there in between, finds its registers still loaded and skips the restore. The
+ * saved state is always up to date once a thread is switched out, so a thread can move to another processor.
+ *
+ * The kernel uses the SSE registers only between kernel_fpu_begin and kernel_fpu_end. Interrupts are disabled in
+ * between, so no other thread and no interrupt handler can touch the registers while they are in use. The registers
+ * of the running thread are saved first if they are loaded, the next FPU instruction of the thread restores them.
+ *
+ * When the processor has SSE2, init_fpu registers SSE2 versions of memcpy and memset for large blocks. They move 64
+ * bytes per iteration through four XMM registers, with aligned stores once the destination is aligned to 16 bytes.
+ * The kernel is built for the i386, only the functions which use the XMM registers are compiled with SSE2 enabled. */
+
+// FPU state of a processor
+struct fpu_cpu {
+    struct thread *owner;       // thread whose state the registers hold, 0 if none
+    int active;                 // CR0.TS is clear and the registers belong to the running thread, the owner
+};
+
+static struct fpu_cpu fpu_cpus[SMP_MAX_CPUS];
+static uint8_t fpu_initial_state[FPU_STATE_SIZE] __attribute__((aligned(FPU_STATE_ALIGN)));
+static int fxsr_enabled;
+static int sse2_enabled;
+
+/** fpu_save:
+ *  Saves the FPU (and SSE, with fxsave) registers of the processor. fnsave also reinitializes the FPU, the registers
+ *  hold no thread's state anymore then.
+ */
+static void fpu_save(struct fpu_cpu *fc, void *state) {
+    if (fxsr_enabled) {
+        asm volatile("fxsave (%0)" : : "r"(state) : "memory");
+    }
+    else {
+        asm volatile("fnsave (%0)" : : "r"(state) : "memory");
+        fc->owner = 0;
+    }
+}
+
+/** fpu_restore:
+ *  Loads the FPU (and SSE, with fxrstor) registers of the processor from a state saved by fpu_save.
+ */
+static void fpu_restore(const void *state) {
+    if (fxsr_enabled) {
+        asm volatile("fxrstor (%0)" : : "r"(state) : "memory");
+    }
+    else {
+        asm volatile("frstor (%0)" : : "r"(state) : "memory");
+    }
+}
+
+/** fpu_device_not_available:
+ *  Handles #NM, raised by the first FPU or SSE instruction after CR0.TS was set. Gives the FPU to the running thread,
+ *  loading its registers unless the processor still holds them.
+ */
+static void fpu_device_not_available(struct interrupt_frame *frame) {
+    uint32_t cpu = this_cpu()->id;
+    struct fpu_cpu *fc = &fpu_cpus[cpu];
+    struct thread *current = thread_current();
+
+    (void) frame;
+
+    asm volatile("clts");
+    // Before the scheduler runs there are no threads to switch between.
+    if (current == 0) {
+        return;
+    }
+    fc->active = 1;
+    if (fc->owner == current && current->fpu_cpu == cpu) {
+        return;
+    }
+    fpu_restore(current->fpu_state);
+    current->fpu_cpu = cpu;
+    fc->owner = current;
+}
+
+/** init_fpu:
+ *  Initializes the FPU and, when supported, enables the SSE instructions and selects the SSE2 string routines. The
+ *  first call also records the initial state of the threads. Called by each processor for itself.
+ */
+void init_fpu() {
+    struct fpu_cpu *fc = &fpu_cpus[this_cpu()->id];
+    uint32_t cr0 = read_cr0();
+
+    // Use the FPU natively: no emulation, no pending task switch, errors reported as #MF.
+    cr0 &= ~(CR0_EM | CR0_TS);
+    cr0 |= CR0_MP | CR0_NE;
+    write_cr0(cr0);
+    asm volatile("fninit");
+
+    if (cpu_has_feature(CPU_FEATURE_FXSR) && cpu_has_feature(CPU_FEATURE_SSE)) {
+        write_cr4(read_cr4() | CR4_OSFXSR | CR4_OSXMMEXCPT);
+        fxsr_enabled = 1;
+
+        if (cpu_has_feature(CPU_FEATURE_SSE2)) {
+            sse2_enabled = 1;
+            string_set_large_ops(sse2_memcpy, sse2_memset);
+        }
+    }
+
+    // The state right after fninit (with MXCSR at its reset value) is the one every thread starts with.
+    if (this_cpu()->id == 0) {
+        fpu_save(fc, fpu_initial_state);
+        register_interrupt_handler(7, fpu_device_not_available);
+    }
+
+    // The first FPU instruction of a thread loads its state.
+    fc->owner = 0;
+    fc->active = 0;
+    write_cr0(read_cr0() | CR0_TS);
+}
+
+/** fpu_init_state:
+ *  Sets a saved FPU state to the initial state, for a new thread.
+ *
+ *  @param state FPU_STATE_SIZE bytes, aligned to FPU_STATE_ALIGN
+ */
+void fpu_init_state(void *state) {
+    memcpy(state, fpu_initial_state, FPU_STATE_SIZE);
+}
+
+/** fpu_switch:
+ *  Called when the running processor switches away from a thread. Saves the FPU registers if the thread used them
+ *  since it was switched to, and sets CR0.TS so the next thread to use the FPU loads its own. Called with the
+ *  interrupts disabled.
+ *
+ *  @param prev The thread switched away from
+ */
+void fpu_switch(struct thread *prev) {
+    struct fpu_cpu *fc = &fpu_cpus[this_cpu()->id];
+
+    if (!fc->active) {
+        return;
+    }
+    fpu_save(fc, prev->fpu_state);
+    fc->active = 0;
+    write_cr0(read_cr0() | CR0_TS);
+}
+
+/** fpu_has_sse2:
+ *  Returns non-zero if init_fpu enabled the SSE2 routines.
+ */
+int fpu_has_sse2() {
+    return sse2_enabled;
+}
+
+/** kernel_fpu_begin:
+ *  Starts a section in which the kernel may use the FPU and SSE registers. Must be paired with kernel_fpu_end.
+ *
+ *  @return Value to pass to kernel_fpu_end
+ */
+uint32_t kernel_fpu_begin() {
+    uint32_t flags = irq_save();
+    struct fpu_cpu *fc = &fpu_cpus[this_cpu()->id];
+
+    if (fc->active) {
+        fpu_save(fc, fc->owner->fpu_state);
+        fc->active = 0;
+    }
+    else {
+        asm volatile("clts");
+    }
+    // The kernel overwrites the registers, no thread owns them anymore.
+    fc->owner = 0;
+
+    return flags;
+}
+
+/** kernel_fpu_end:
+ *  Ends a section started by kernel_fpu_begin.
+ *
+ *  @param flags The value returned by kernel_fpu_begin
+ */
+void kernel_fpu_end(uint32_t flags) {
+    write_cr0(read_cr0() | CR0_TS);
+    irq_restore(flags);
+}
+
+/** sse2_copy_chunk:
+ *  Copies a block between non-overlapping buffers with SSE2. Must run between kernel_fpu_begin and kernel_fpu_end.
+ */
+__attribute__((target("sse2"))) static void sse2_copy_chunk(uint8_t *dst, const uint8_t *src, size_t n) {
+    // Align the destination, so the stores can be aligned.
+    while (((uint32_t) dst & 15) && n) {
+        *dst++ = *src++;
+        n--;
+    }
+
+    for (; n >= 64; n -= 64, src += 64, dst += 64) {
+        asm volatile("movdqu   (%0), %%xmm0\n\t"
+                     "movdqu 16(%0), %%xmm1\n\t"
+                     "movdqu 32(%0), %%xmm2\n\t"
+                     "movdqu 48(%0), %%xmm3\n\t"
+                     "movdqa %%xmm0,   (%1)\n\t"
+                     "movdqa %%xmm1, 16(%1)\n\t"
+                     "movdqa %%xmm2, 32(%1)\n\t"
+                     "movdqa %%xmm3, 48(%1)"
+                     : : "r"(src), "r"(dst) : "memory", "xmm0", "xmm1", "xmm2", "xmm3");
+    }
+
+    while (n--) {
+        *dst++ = *src++;
+    }
+}
+
+/** sse2_fill_chunk:
+ *  Fills a block with a byte value with SSE2. Must run between kernel_fpu_begin and kernel_fpu_end.
+ */
+__attribute__((target("sse2"))) static void sse2_fill_chunk(uint8_t *dest, uint8_t value, size_t n) {
+    uint32_t pattern = value * 0x01010101u;
+
+    while (((uint32_t) dest & 15) && n) {
+        *dest++ = value;
+        n--;
+    }
+
+    // Broadcast the pattern to all four dwords of xmm0, then store it 64 bytes at a time.
+    if (n >= 64) {
+        asm volatile("movd %[pattern], %%xmm0\n\t"
+                     "pshufd $0, %%xmm0, %%xmm0\n"
+                     "1:\n\t"
+                     "movdqa %%xmm0,   (%[dest])\n\t"
+                     "movdqa %%xmm0, 16(%[dest])\n\t"
+                     "movdqa %%xmm0, 32(%[dest])\n\t"
+                     "movdqa %%xmm0, 48(%[dest])\n\t"
+                     "addl $64, %[dest]\n\t"
+                     "subl $64, %[n]\n\t"
+                     "cmpl $64, %[n]\n\t"
+                     "jae 1b"
+                     : [dest] "+r"(dest), [n] "+r"(n)
+                     : [pattern] "r"(pattern)
+                     : "memory", "cc", "xmm0");
+    }
+
+    while (n--) {
+        *dest++ = value;
+    }
+}
+
+/** sse2_memcpy:
+ *  memcpy with SSE2, for large blocks.
+ *
+ *  @param dst Destination
+ *  @param src Source, must not overlap the destination
+ *  @param n   Number of bytes to copy
+ *  @return    dst
+ */
+void *sse2_memcpy(void *dst, const void *src, size_t n) {
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+
+    while (n) {
+        size_t chunk = n < FPU_SSE2_CHUNK_SIZE ? n : FPU_SSE2_CHUNK_SIZE;
+        uint32_t flags = kernel_fpu_begin();
+
+        sse2_copy_chunk(d, s, chunk);
+        kernel_fpu_end(flags);
+        d += chunk;
+        s += chunk;
+        n -= chunk;
+    }
+
+    return dst;
+}
+
+/** sse2_memset:
+ *  memset with SSE2, for large blocks.
+ *
+ *  @param dest  Destination
+ *  @param value Byte value
+ *  @param n     Number of bytes to fill
+ *  @return      dest
+ */
+void *sse2_memset(void *dest, int value, size_t n) {
+    uint8_t *d = dest;
+
+    while (n) {
+        size_t chunk = n < FPU_SSE2_CHUNK_SIZE ? n : FPU_SSE2_CHUNK_SIZE;
+        uint32_t flags = kernel_fpu_begin();
+
+        sse2_fill_chunk(d, value, chunk);
+        kernel_fpu_end(flags);
+        d += chunk;
+        n -= chunk;
+    }
+
+    return dest;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef __FPU_H__
+#define __FPU_H__
+
+#include "../../include/stdint.h"
+#include "../../include/stddef.h"
+
+// The SSE2 routines turn interrupts off per chunk of this many bytes, which bounds the interrupt latency they add.
+#define FPU_SSE2_CHUNK_SIZE     4096
+
+// Size and alignment of the area fxsave stores the FPU and SSE registers in, fnsave needs only 108 bytes of it.
+#define FPU_STATE_SIZE          512
+#define FPU_STATE_ALIGN         16
+
+// fpu_cpu of a thread whose FPU state is held by no processor
+#define FPU_NO_CPU              0xFFFFFFFF
+
+struct thread;
+
+void init_fpu();
+void fpu_init_state(void *state);
+void fpu_switch(struct thread *prev);
+int fpu_has_sse2();
+uint32_t kernel_fpu_begin();
+void kernel_fpu_end(uint32_t flags);
+void *sse2_memcpy(void *dst, const void *src, size_t n);
+void *sse2_memset(void *dest, int value, size_t n);
+
+#endif
\ No newline at end of file
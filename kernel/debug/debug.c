@@ -0,0 +1,37 @@
+#include "debug.h"
+#include "../console/console.h"
+#include "../log/log.h"
+#include "../sched/sched.h"
+#include "../../mm/slab/slab.h"
+#include "../../drivers/interrupts/irq.h"
+
+/* Debug keys: the function keys write the statistics of the kernel to the console.
+ *
+ *  F1  Interrupt statistics
+ *  F2  Scheduler statistics
+ *  F3  Slab caches
+ *  F4  Kernel log */
+
+/** debug_key:
+ *  Runs the dump bound to a debug key. Called by the keyboard driver.
+ *
+ *  @param key 0 for F1, 1 for F2, ...
+ */
+void debug_key(int key) {
+    switch (key) {
+        case 0:
+            irq_print_stats();
+            break;
+        case 1:
+            sched_print_stats();
+            break;
+        case 2:
+            slab_print_stats();
+            break;
+        case 3:
+            log_dmesg();
+            break;
+        default:
+            break;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#ifndef __DEBUG_H__
+#define __DEBUG_H__
+
+// Number of debug keys, F1 to F<DEBUG_KEY_COUNT>
+#define DEBUG_KEY_COUNT     4
+
+void debug_key(int key);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "elf.h"
+#include "../../mm/paging/paging.h"
+
+/** elf_check_header:
+ *  Checks that the image is an i386 ELF32 executable whose program headers lie within the image.
+ *
+ *  @return 0 if the header is valid, -1 otherwise
+ */
+static int elf_check_header(const struct elf_header *header, uint32_t size) {
+    if (size < sizeof(struct elf_header) || *(const uint32_t *) header->ident != ELF_MAGIC) {
+        return -1;
+    }
+    if (header->ident[4] != ELF_CLASS_32 || header->ident[5] != ELF_DATA_LSB || header->type != ELF_TYPE_EXEC ||
+        header->machine != ELF_MACHINE_386 || header->version != ELF_VERSION_CURRENT) {
+        return -1;
+    }
+    if (header->phentsize != sizeof(struct elf_program_header) || header->phoff > size ||
+        header->phnum > (size - header->phoff) / sizeof(struct elf_program_header)) {
+        return -1;
+    }
+    if (header->entry >= KERNEL_VIRTUAL_BASE) {
+        return -1;
+    }
+    return 0;
+}
+
+/** elf_load:
+ *  Maps the loadable segments of an ELF executable into an address space. Nothing is copied: every segment becomes an
+ *  area backed by the image (see vm_map), its pages are copied or zero-filled when they are first accessed. The image
+ *  must therefore stay in memory as long as the address space exists, as the modules do.
+ *
+ *  @param space The address space, its user half is expected to be empty
+ *  @param image The executable, in kernel memory
+ *  @param size  Size of the executable in bytes
+ *  @param entry Set to the entry point of the program
+ *  @return      0 on success, -1 if the image is not a valid executable or a segment can not be mapped
+ */
+int elf_load(struct address_space *space, const uint8_t *image, uint32_t size, uint32_t *entry) {
+    const struct elf_header *header = (const struct elf_header *) image;
+    const struct elf_program_header *segments;
+
+    if (elf_check_header(header, size) != 0) {
+        return -1;
+    }
+
+    segments = (const struct elf_program_header *) (image + header->phoff);
+    for (uint32_t i = 0; i < header->phnum; i++) {
+        const struct elf_program_header *segment = &segments[i];
+        uint32_t flags = PTE_USER;
+
+        if (segment->type != ELF_PT_LOAD || segment->memsz == 0) {
+            continue;
+        }
+        if (segment->filesz > segment->memsz || segment->offset > size || segment->filesz > size - segment->offset) {
+            return -1;
+        }
+        if (segment->flags & ELF_PF_W) {
+            flags |= PTE_WRITABLE;
+        }
+        if (vm_map(space, segment->vaddr, segment->memsz, flags, image + segment->offset, segment->filesz) != 0) {
+            return -1;
+        }
+    }
+
+    *entry = header->entry;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef __ELF_H__
+#define __ELF_H__
+
+#include "../../include/stdint.h"
+#include "../../mm/vm/vm.h"
+
+// Fields of ident, the first bytes of the ELF header
+#define ELF_MAGIC           0x464C457F      /* "\x7FELF", read as a little endian word */
+#define ELF_CLASS_32        1               /* ident[4]: 32-bit objects */
+#define ELF_DATA_LSB        1               /* ident[5]: little endian */
+
+#define ELF_TYPE_EXEC       2               /* executable file */
+#define ELF_MACHINE_386     3               /* Intel 80386 */
+#define ELF_VERSION_CURRENT 1
+
+// Program header types and flags
+#define ELF_PT_LOAD         1               /* a segment loaded into memory */
+#define ELF_PF_X            0x1             /* executable */
+#define ELF_PF_W            0x2             /* writable */
+#define ELF_PF_R            0x4             /* readable */
+
+// ELF32 file header
+struct elf_header {
+    uint8_t ident[16];
+    uint16_t type;
+    uint16_t machine;
+    uint32_t version;
+    uint32_t entry;             // virtual address of the entry point
+    uint32_t phoff;             // file offset of the program header table
+    uint32_t shoff;
+    uint32_t flags;
+    uint16_t ehsize;
+    uint16_t phentsize;         // size of a program header
+    uint16_t phnum;             // number of program headers
+    uint16_t shentsize;
+    uint16_t shnum;
+    uint16_t shstrndx;
+} __attribute__((packed));
+
+/* ELF32 program header. A loadable segment occupies memsz bytes from vaddr; the first filesz bytes come from the file
+ * at offset, the rest (the BSS) is zero. */
+struct elf_program_header {
+    uint32_t type;
+    uint32_t offset;
+    uint32_t vaddr;
+    uint32_t paddr;
+    uint32_t filesz;
+    uint32_t memsz;
+    uint32_t flags;
+    uint32_t align;
+} __attribute__((packed));
+
+int elf_load(struct address_space *space, const uint8_t *image, uint32_t size, uint32_t *entry);
+
+#endif
\ No newline at end of file
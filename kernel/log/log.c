@@ -0,0 +1,246 @@
+#include "log.h"
+#include "../cpu/cpu.h"
+#include "../sched/sched.h"
+#include "../console/console.h"
+#include "../../include/stdio.h"
+#include "../../include/stdarg.h"
+#include "../../include/div64.h"
+#include "../time/ktime.h"
+
+/* Kernel log
+ *
+ * log_write stores a record in a fixed-size ring and returns, it never touches a device; interrupt handlers can log
+ * in constant time. A low priority thread, the drain, later writes the records to the console sinks.
+ *
+ * The ring takes any number of concurrent writers without a lock. A writer claims the next sequence number with an
+ * atomic increment, which maps it to the slot seq % LOG_RECORD_COUNT. It then takes the slot by switching its marker
+ * to busy, fills it in and publishes it by marking it done. A busy slot is never taken over: a writer which finds the
+ * slot busy waits, and one which finds a newer record there has been lapped and drops its record. Writers run from
+ * the claim to the publish with the interrupts disabled, so a busy slot is released after a bounded time and a
+ * reader never waits long for a record which was claimed. A reader copies a record and checks the marker before and
+ * after the copy; if it does not match the sequence number asked for, the record was not written yet or was
+ * overwritten by a newer one in the meantime.
+ *
+ * The markers keep the sequence numbers modulo 2^30; records 2^30 apart never share the ring, so the wraparound of
+ * the sequence numbers is harmless. */
+
+// Marker of the slot holding a record in the given state.
+#define LOG_MARKER(seq, state)  (((seq) << 2) | (state))
+
+static struct log_record records[LOG_RECORD_COUNT];
+static volatile uint32_t log_head;          // next sequence number to hand out
+static uint32_t drain_seq;                  // next sequence number the drain writes to the console
+static uint32_t dropped;                    // records overwritten before the drain reached them
+static int console_level = LOG_INFO;
+static struct thread *drain_thread;
+
+static const char *level_names[] = {"ERROR", "WARN", "INFO", "DEBUG"};
+
+/** log_marker_diff:
+ *  Returns how many records the record of a marker is newer than the given sequence number, negative if it is older.
+ */
+static inline int32_t log_marker_diff(uint32_t marker, uint32_t seq) {
+    return (int32_t) ((marker & ~3) - LOG_MARKER(seq, 0)) >> 2;
+}
+
+/** log_write:
+ *  Appends a record to the log. Can be called from interrupt handlers.
+ *
+ *  @param level  LOG_ERROR to LOG_DEBUG
+ *  @param format Format string, see vsnprintf
+ */
+void log_write(int level, const char *format, ...) {
+    uint32_t flags = irq_save();
+    uint32_t seq = __atomic_fetch_add(&log_head, 1, __ATOMIC_RELAXED);
+    struct log_record *record = &records[seq & (LOG_RECORD_COUNT - 1)];
+    uint32_t marker;
+    va_list ap;
+    int length;
+
+    // Take the slot. A busy slot belongs to a writer on another processor, which has its interrupts disabled.
+    for (;;) {
+        marker = __atomic_load_n(&record->marker, __ATOMIC_RELAXED);
+        if ((marker & 3) == LOG_SLOT_BUSY) {
+            asm volatile("pause");
+            continue;
+        }
+        if ((marker & 3) != LOG_SLOT_EMPTY && log_marker_diff(marker, seq) > 0) {
+            // Lapped: a newer record has the slot already, the reader counts this one as dropped.
+            irq_restore(flags);
+            return;
+        }
+        if (__atomic_compare_exchange_n(&record->marker, &marker, LOG_MARKER(seq, LOG_SLOT_BUSY), 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+    // The stores below must not become visible before the busy marker.
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    record->level = level;
+    record->timestamp = ktime_get_ns();
+    va_start(ap, format);
+    length = vsnprintf(record->message, LOG_MESSAGE_SIZE, format, ap);
+    va_end(ap);
+    record->length = length < LOG_MESSAGE_SIZE ? length : LOG_MESSAGE_SIZE - 1;
+
+    __atomic_store_n(&record->marker, LOG_MARKER(seq, LOG_SLOT_DONE), __ATOMIC_RELEASE);
+    irq_restore(flags);
+
+    if (drain_thread && level <= console_level) {
+        thread_wake(drain_thread);
+    }
+}
+
+/** log_read:
+ *  Copies a record of the log.
+ *
+ *  @param seq    Sequence number of the record
+ *  @param record Destination of the copy
+ *  @return       0 on success, -1 if the record is not complete yet, -2 if it was overwritten or dropped
+ */
+int log_read(uint32_t seq, struct log_record *record) {
+    struct log_record *slot = &records[seq & (LOG_RECORD_COUNT - 1)];
+    uint32_t before = __atomic_load_n(&slot->marker, __ATOMIC_ACQUIRE);
+    uint32_t after;
+
+    if (before != LOG_MARKER(seq, LOG_SLOT_DONE)) {
+        /* An empty slot, an older record or the record itself being written: the writer has claimed the sequence
+         * number and publishes it shortly. A newer record means this one was overwritten or dropped. */
+        if ((before & 3) == LOG_SLOT_EMPTY || log_marker_diff(before, seq) <= 0) {
+            return -1;
+        }
+        return -2;
+    }
+
+    *record = *slot;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    after = __atomic_load_n(&slot->marker, __ATOMIC_RELAXED);
+
+    return after == before ? 0 : -2;
+}
+
+/** log_first_seq:
+ *  Returns the sequence number of the oldest record which may still be in the ring.
+ */
+uint32_t log_first_seq() {
+    uint32_t head = __atomic_load_n(&log_head, __ATOMIC_ACQUIRE);
+
+    return head > LOG_RECORD_COUNT ? head - LOG_RECORD_COUNT : 0;
+}
+
+/** log_next_seq:
+ *  Returns the sequence number the next record will get.
+ */
+uint32_t log_next_seq() {
+    return __atomic_load_n(&log_head, __ATOMIC_ACQUIRE);
+}
+
+/** log_dropped_records:
+ *  Returns the number of records which were overwritten before the drain wrote them to the console.
+ */
+uint32_t log_dropped_records() {
+    return dropped;
+}
+
+/** log_set_console_level:
+ *  Sets the least severe level written to the console. Less severe records are only kept in the ring.
+ */
+void log_set_console_level(int level) {
+    console_level = level;
+}
+
+/** log_print_record:
+ *  Writes a record to the console sinks, prefixed with its timestamp and level.
+ */
+static void log_print_record(struct log_record *record) {
+    char line[LOG_MESSAGE_SIZE + 32];
+    uint64_t seconds = record->timestamp;
+    uint32_t nanoseconds = div64_u32(&seconds, 1000000000);
+    const char *level = record->level <= LOG_DEBUG ? level_names[record->level] : "?";
+    int length;
+
+    length = snprintf(line, sizeof(line), "[%5u.%06u] %s: %s\n", (uint32_t) seconds, nanoseconds / 1000, level,
+                      record->message);
+    if (length >= (int) sizeof(line)) {
+        length = sizeof(line) - 1;
+    }
+    console_write(line, length);
+}
+
+/** log_drain:
+ *  Writes the records which were not written yet to the console. Stops at a record which is still being written.
+ *
+ *  @return Non-zero if records are left which are not complete yet
+ */
+static int log_drain() {
+    struct log_record record;
+
+    while (drain_seq != log_next_seq()) {
+        // Skip the records which were overwritten before the drain got to them.
+        uint32_t first = log_first_seq();
+        if ((int32_t) (drain_seq - first) < 0) {
+            dropped += first - drain_seq;
+            drain_seq = first;
+        }
+
+        int result = log_read(drain_seq, &record);
+        if (result == -1) {
+            return 1;
+        }
+        if (result == 0 && record.level <= console_level) {
+            log_print_record(&record);
+        }
+        else if (result == -2) {
+            dropped++;
+        }
+        drain_seq++;
+    }
+
+    return 0;
+}
+
+/** log_drain_loop:
+ *  Body of the drain thread.
+ */
+static void log_drain_loop(void *arg) {
+    (void) arg;
+
+    for (;;) {
+        uint32_t flags;
+        int pending = log_drain();
+
+        // Check for new records with the interrupts disabled, so a wake-up between the check and the block is not
+        // lost. A record still being written is picked up on the next wake-up, or after yielding to its writer.
+        flags = irq_save();
+        if (drain_seq == log_next_seq()) {
+            thread_block();
+        }
+        irq_restore(flags);
+        if (pending) {
+            thread_yield();
+        }
+    }
+}
+
+/** init_log_drain:
+ *  Starts the thread which writes the log to the console. Records logged before are written right away.
+ *  Requires the scheduler.
+ */
+void init_log_drain() {
+    drain_thread = thread_create("logd", log_drain_loop, 0, SCHED_PRIORITY_LOWEST);
+}
+
+/** log_dmesg:
+ *  Writes every record still in the ring to the console, whatever its level.
+ */
+void log_dmesg() {
+    struct log_record record;
+    uint32_t end = log_next_seq();
+
+    for (uint32_t seq = log_first_seq(); seq != end; seq++) {
+        if (log_read(seq, &record) == 0) {
+            log_print_record(&record);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef __LOG_H__
+#define __LOG_H__
+
+#include "../../include/stdint.h"
+
+// Number of records kept by the log ring, a power of two. The oldest records are overwritten.
+#define LOG_RECORD_COUNT        256
+// Longest message of a record, including the terminator. Longer messages are truncated.
+#define LOG_MESSAGE_SIZE        112
+
+// State of a slot of the ring, in bits 1:0 of its marker.
+#define LOG_SLOT_EMPTY          0       /* never written */
+#define LOG_SLOT_BUSY           1       /* a writer fills it in */
+#define LOG_SLOT_DONE           2       /* complete */
+
+// Log levels, lower is more severe.
+#define LOG_ERROR               0
+#define LOG_WARNING             1
+#define LOG_INFO                2
+#define LOG_DEBUG               3
+
+/* A record of the log ring. The marker holds the low 30 bits of the sequence number of the record and its state
+ * (LOG_SLOT_*), so a reader can tell a finished record from a stale, overwritten or half-written one. */
+struct log_record {
+    volatile uint32_t marker;
+    uint8_t level;
+    uint8_t reserved;
+    uint16_t length;            // length of the message
+    uint64_t timestamp;         // nanoseconds since boot
+    char message[LOG_MESSAGE_SIZE];
+};
+
+void log_write(int level, const char *format, ...);
+int log_read(uint32_t seq, struct log_record *record);
+uint32_t log_first_seq();
+uint32_t log_next_seq();
+uint32_t log_dropped_records();
+void log_set_console_level(int level);
+void init_log_drain();
+void log_dmesg();
+
+#define log_error(...)      log_write(LOG_ERROR, __VA_ARGS__)
+#define log_warning(...)    log_write(LOG_WARNING, __VA_ARGS__)
+#define log_info(...)       log_write(LOG_INFO, __VA_ARGS__)
+#define log_debug(...)      log_write(LOG_DEBUG, __VA_ARGS__)
+
+#endif
\ No newline at end of file
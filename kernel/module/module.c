@@ -0,0 +1,54 @@
+#include "module.h"
+#include "../../mm/paging/paging.h"
+
+static struct module modules[MODULE_MAX_COUNT];
+static uint32_t modules_loaded;
+
+/** init_modules:
+ *  Copies the list of modules from the multiboot information. Called before the memory of the boot loader, which
+ *  holds the list and the command lines, is handed out.
+ *
+ *  @param mbi The multiboot information structure
+ */
+void init_modules(struct multiboot_info *mbi) {
+    struct multiboot_module *entries;
+
+    if (!(mbi->flags & MULTIBOOT_INFO_MODS)) {
+        return;
+    }
+
+    entries = phys_to_virt(mbi->mods_addr);
+    for (uint32_t i = 0; i < mbi->mods_count && modules_loaded < MODULE_MAX_COUNT; i++) {
+        struct module *module = &modules[modules_loaded++];
+        const char *cmdline = entries[i].cmdline ? phys_to_virt(entries[i].cmdline) : "";
+        uint32_t length = 0;
+
+        module->start = entries[i].mod_start;
+        module->end = entries[i].mod_end;
+        while (cmdline[length] && length < MODULE_CMDLINE_LENGTH - 1) {
+            module->cmdline[length] = cmdline[length];
+            length++;
+        }
+        module->cmdline[length] = 0;
+    }
+}
+
+/** module_count:
+ *  Returns the number of modules.
+ */
+uint32_t module_count() {
+    return modules_loaded;
+}
+
+/** module_get:
+ *  Returns the module with the given index, in the order of menu.lst.
+ *
+ *  @param index 0 to module_count() - 1
+ *  @return      The module, 0 if there is no such module
+ */
+const struct module *module_get(uint32_t index) {
+    if (index >= modules_loaded) {
+        return 0;
+    }
+    return &modules[index];
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef __MODULE_H__
+#define __MODULE_H__
+
+#include "../../include/stdint.h"
+#include "../../init/multiboot.h"
+
+// Modules beyond this count are ignored.
+#define MODULE_MAX_COUNT        8
+// Longer command lines are cut off.
+#define MODULE_CMDLINE_LENGTH   64
+
+// A module GRUB loaded next to the kernel ("module" lines of menu.lst). The physical memory manager keeps its memory.
+struct module {
+    uint32_t start;                         // physical address of the first byte
+    uint32_t end;                           // physical address of the byte after the module
+    char cmdline[MODULE_CMDLINE_LENGTH];    // path of the module, followed by its arguments
+};
+
+void init_modules(struct multiboot_info *mbi);
+uint32_t module_count();
+const struct module *module_get(uint32_t index);
+
+#endif
\ No newline at end of file
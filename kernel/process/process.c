@@ -0,0 +1,82 @@
+#include "process.h"
+#include "../elf/elf.h"
+#include "../log/log.h"
+#include "../syscall/syscall.h"
+#include "../cpu/cpu.h"
+#include "../../mm/paging/paging.h"
+#include "../../mm/vm/vm.h"
+
+/* Processes
+ *
+ * A process runs an ELF executable loaded as a module in its own address space, on a thread of its own. The thread
+ * loads the executable (see elf_load), enters it in user mode and, once the program makes the exit system call,
+ * frees the address space and exits itself. */
+
+/** process_set_space:
+ *  Makes the running thread use the given address space, 0 for the kernel page directory.
+ */
+static void process_set_space(struct address_space *space) {
+    uint32_t flags = irq_save();
+
+    thread_current()->space = space;
+    paging_switch_directory(space ? space->directory : paging_kernel_directory());
+    irq_restore(flags);
+}
+
+/** process_main:
+ *  The thread of a process.
+ *
+ *  @param arg The module of the executable
+ */
+static void process_main(void *arg) {
+    const struct module *module = arg;
+    struct address_space *space;
+    uint32_t entry;
+    int status;
+
+    // The module is read in place, through the direct map.
+    if (module->end > paging_direct_map_end() || module->end < module->start) {
+        log_error("%s: module outside the direct map", module->cmdline);
+        return;
+    }
+
+    space = vm_create();
+    if (space == 0) {
+        log_error("%s: out of memory", module->cmdline);
+        return;
+    }
+    if (elf_load(space, phys_to_virt(module->start), module->end - module->start, &entry) != 0 ||
+        vm_map(space, PROCESS_STACK_TOP - PROCESS_STACK_SIZE, PROCESS_STACK_SIZE, PTE_WRITABLE, 0, 0) != 0) {
+        log_error("%s: not a valid executable", module->cmdline);
+        vm_destroy(space);
+        return;
+    }
+
+    process_set_space(space);
+    status = user_enter(entry, PROCESS_STACK_TOP, 0);
+    process_set_space(0);
+
+    vm_destroy(space);
+    log_info("%s exited with status %d", module->cmdline, status);
+}
+
+/** process_spawn:
+ *  Starts a process running the executable in the given module.
+ *
+ *  @param module A module holding an ELF executable
+ *  @return       The thread of the process, 0 if the memory is exhausted
+ */
+struct thread *process_spawn(const struct module *module) {
+    return thread_create(module->cmdline, process_main, (void *) module, SCHED_PRIORITY_DEFAULT);
+}
+
+/** process_spawn_modules:
+ *  Starts a process for every module GRUB loaded.
+ */
+void process_spawn_modules() {
+    for (uint32_t i = 0; i < module_count(); i++) {
+        if (process_spawn(module_get(i)) == 0) {
+            log_error("%s: can not create the thread", module_get(i)->cmdline);
+        }
+    }
+}
\ No newline at end of file
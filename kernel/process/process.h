@@ -0,0 +1,16 @@
+#ifndef __PROCESS_H__
+#define __PROCESS_H__
+
+#include "../../include/stdint.h"
+#include "../module/module.h"
+#include "../sched/sched.h"
+#include "../../mm/paging/paging.h"
+
+// The user stack ends below the kernel half and is faulted in as it grows, up to its maximum size.
+#define PROCESS_STACK_TOP       KERNEL_VIRTUAL_BASE
+#define PROCESS_STACK_SIZE      0x100000
+
+struct thread *process_spawn(const struct module *module);
+void process_spawn_modules();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,883 @@
+#include "sched.h"
+#include "../cpu/cpu.h"
+#include "../../mm/physical/pmm.h"
+#include "../../mm/paging/paging.h"
+#include "../../mm/slab/slab.h"
+#include "../../mm/vm/vm.h"
+#include "../console/console.h"
+#include "../time/ktime.h"
+#include "../../include/div64.h"
+
+/* Scheduler
+ *
+ * Kernel threads are scheduled preemptively by priority, and round-robin among threads of the same priority. Every
+ * thread has its own kernel stack; switching threads means saving the callee-saved registers on the stack of the
+ * current thread and loading the stack pointer of the next one (switch_context in switch.s).
+ *
+ * The scheduler tick, a timer every SCHED_TICK_PERIOD, calls sched_tick, which requests a reschedule when the time
+ * slice of the running thread is used up. The reschedule itself happens in sched_preempt, at the end of the interrupt
+ * handler once the interrupt has been acknowledged. A thread preempted that way continues later by returning from its
+ * interrupt.
+ *
+ * When no thread is ready the idle thread halts the processor until the next interrupt, so an idle machine does not
+ * burn cycles (or, virtualized, a host core). The tick is not re-armed while the idle thread runs, an idle processor
+ * only wakes up for its timers, the devices and the other processors; switching to a thread starts the tick again.
+ * The time spent in the idle thread is accounted separately, which gives the utilisation of the processor.
+ *
+ * Every processor has its own run queue, idle thread and statistics, so the processors only contend when threads
+ * move between them:
+ *  - a new or woken thread goes to an idle processor it may run on if there is one, else to the processor it last ran
+ *    on (a new thread to the least loaded one), and a processor which runs a lower priority thread is interrupted;
+ *  - a processor whose run queue is empty steals a thread from the busiest run queue;
+ *  - every SCHED_BALANCE_INTERVAL ticks a processor pulls a thread from the busiest run queue when that one has at
+ *    least two threads more than its own, and wakes an idle processor up to steal when it has threads waiting.
+ * Threads only run on the processors of their affinity mask.
+ *
+ * A thread is protected by the run queue lock of its processor (thread->cpu), with the interrupts disabled. A
+ * processor holding its own lock only try-locks the others, so two processors balancing against each other cannot
+ * deadlock. */
+
+// Per-processor scheduler state
+struct sched_cpu {
+    struct run_queue queue;
+    struct thread *current;
+    struct thread *idle;
+    struct thread *dead;            // exited thread, freed by the next thread once the switch is done
+    struct thread *migrate;         // preempted thread which may not run here anymore, moved after the switch
+    volatile int need_resched;
+    uint32_t balance_ticks;
+    struct timer tick;
+    uint64_t switch_time;           // time of the last switch, the running thread is accounted from there
+    struct sched_stats stats;
+};
+
+// Defined in switch.s
+extern void switch_context(uint32_t *old_esp, uint32_t *new_esp, volatile int *old_on_cpu, volatile int *new_on_cpu);
+
+static void sched_tick_timer(struct timer *timer);
+
+static struct sched_cpu sched_cpus[SMP_MAX_CPUS];
+static volatile uint32_t online_mask;
+static struct kmem_cache *thread_cache;
+static uint32_t next_thread_id;
+
+/** this_sched:
+ *  Returns the scheduler state of the running processor. Only stable while the interrupts are disabled.
+ */
+static inline struct sched_cpu *this_sched() {
+    return &sched_cpus[this_cpu()->id];
+}
+
+/** enqueue:
+ *  Appends a ready thread to the run queue list of its priority. The run queue lock must be held.
+ */
+static void enqueue(struct run_queue *queue, struct thread *thread) {
+    int priority = thread->priority;
+
+    thread->next = 0;
+    if (queue->tail[priority]) {
+        queue->tail[priority]->next = thread;
+    }
+    else {
+        queue->head[priority] = thread;
+    }
+    queue->tail[priority] = thread;
+    queue->bitmap |= 1u << priority;
+    queue->nr_running++;
+}
+
+/** dequeue:
+ *  Removes a thread from the run queue list of its priority. The run queue lock must be held.
+ *
+ *  @param previous The thread before it in the list, 0 if it is the first one
+ */
+static void dequeue(struct run_queue *queue, struct thread *thread, struct thread *previous) {
+    int priority = thread->priority;
+
+    if (previous) {
+        previous->next = thread->next;
+    }
+    else {
+        queue->head[priority] = thread->next;
+    }
+    if (queue->tail[priority] == thread) {
+        queue->tail[priority] = previous;
+    }
+    if (queue->head[priority] == 0) {
+        queue->bitmap &= ~(1u << priority);
+    }
+    queue->nr_running--;
+    thread->next = 0;
+}
+
+/** dequeue_highest:
+ *  Removes the first thread of the highest priority non-empty list from the run queue.
+ *
+ *  @return The thread, 0 if the run queue is empty
+ */
+static struct thread *dequeue_highest(struct run_queue *queue) {
+    struct thread *thread;
+
+    if (queue->bitmap == 0) {
+        return 0;
+    }
+
+    // The lowest set bit is the highest priority level with a ready thread (compiled to a single bsf).
+    thread = queue->head[__builtin_ctz(queue->bitmap)];
+    dequeue(queue, thread, 0);
+
+    return thread;
+}
+
+/** dequeue_allowed:
+ *  Removes the highest priority thread which may run on the given processor from a run queue.
+ *
+ *  @return The thread, 0 if there is none
+ */
+static struct thread *dequeue_allowed(struct run_queue *queue, uint32_t cpu) {
+    uint32_t bitmap = queue->bitmap;
+
+    while (bitmap) {
+        int priority = __builtin_ctz(bitmap);
+        struct thread *previous = 0;
+
+        for (struct thread *thread = queue->head[priority]; thread; previous = thread, thread = thread->next) {
+            if (thread->affinity & (1u << cpu)) {
+                dequeue(queue, thread, previous);
+                return thread;
+            }
+        }
+        bitmap &= bitmap - 1;
+    }
+    return 0;
+}
+
+/** find_busiest:
+ *  Returns the processor with the most ready threads other than the given one, or -1 if no other run queue has at
+ *  least min_running threads. The counters are read without the locks, the result is only a hint.
+ */
+static int find_busiest(uint32_t self, uint32_t min_running) {
+    uint32_t busiest_running = min_running - 1;
+    int busiest = -1;
+
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        uint32_t running = sched_cpus[cpu].queue.nr_running;
+
+        if (cpu != self && (online_mask & (1u << cpu)) && running > busiest_running) {
+            busiest_running = running;
+            busiest = cpu;
+        }
+    }
+    return busiest;
+}
+
+/** steal_from:
+ *  Moves a thread which may run on processor self from the run queue of another processor. The lock of self is held
+ *  by the caller, the other lock is only tried.
+ *
+ *  @return The thread, not enqueued yet, 0 if none could be taken
+ */
+static struct thread *steal_from(uint32_t self, int victim) {
+    struct sched_cpu *other;
+    struct thread *thread;
+
+    if (victim < 0) {
+        return 0;
+    }
+    other = &sched_cpus[victim];
+    if (!spin_trylock(&other->queue.lock)) {
+        return 0;
+    }
+
+    thread = dequeue_allowed(&other->queue, self);
+    if (thread) {
+        thread->cpu = self;
+    }
+    spin_unlock(&other->queue.lock);
+
+    if (thread) {
+        sched_cpus[self].stats.migrations++;
+    }
+    return thread;
+}
+
+/** lock_thread:
+ *  Takes the run queue lock which protects a thread. The thread may move while the lock is taken, so it is checked
+ *  again once the lock is held.
+ *
+ *  @return The scheduler state of the processor whose lock is held
+ */
+static struct sched_cpu *lock_thread(struct thread *thread) {
+    for (;;) {
+        uint32_t cpu = thread->cpu;
+        struct sched_cpu *sc = &sched_cpus[cpu];
+
+        spin_lock(&sc->queue.lock);
+        if (thread->cpu == cpu) {
+            return sc;
+        }
+        spin_unlock(&sc->queue.lock);
+    }
+}
+
+/** select_cpu:
+ *  Chooses the processor a ready thread is queued on: an idle processor of its affinity, preferring the one it last
+ *  ran on; else the one it last ran on, whose cache may still hold its data, if allowed and prefer_last is set; else
+ *  the allowed processor with the fewest ready threads. The run queues are read without their locks.
+ */
+static uint32_t select_cpu(struct thread *thread, int prefer_last) {
+    uint32_t allowed = thread->affinity & online_mask;
+    uint32_t last = thread->cpu;
+    uint32_t best = last;
+    uint32_t best_running = 0xFFFFFFFF;
+
+    if (allowed == 0) {
+        allowed = online_mask;
+    }
+    if ((allowed & (1u << last)) && sched_cpus[last].current == sched_cpus[last].idle) {
+        return last;
+    }
+
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        struct sched_cpu *sc = &sched_cpus[cpu];
+
+        if (!(allowed & (1u << cpu))) {
+            continue;
+        }
+        if (sc->current == sc->idle && sc->queue.nr_running == 0) {
+            return cpu;
+        }
+        if (sc->queue.nr_running < best_running) {
+            best_running = sc->queue.nr_running;
+            best = cpu;
+        }
+    }
+    if (prefer_last && (allowed & (1u << last))) {
+        return last;
+    }
+    return best;
+}
+
+/** activate:
+ *  Queues a ready thread on the processor chosen for it, and interrupts that processor if the thread should preempt
+ *  what it runs. No run queue lock may be held.
+ *
+ *  @param prefer_last Non-zero to keep the thread on the processor it last ran on when that one is not idle either
+ */
+static void activate(struct thread *thread, int prefer_last) {
+    uint32_t cpu = select_cpu(thread, prefer_last);
+    struct sched_cpu *sc = &sched_cpus[cpu];
+    int preempt;
+
+    spin_lock(&sc->queue.lock);
+    thread->cpu = cpu;
+    enqueue(&sc->queue, thread);
+    preempt = sc->current == sc->idle || thread->priority < sc->current->priority;
+    if (preempt) {
+        sc->need_resched = 1;
+    }
+    spin_unlock(&sc->queue.lock);
+
+    if (preempt && cpu != this_cpu()->id) {
+        smp_send_reschedule(cpu);
+    }
+}
+
+/** finish_switch:
+ *  Completes a switch on the thread switched to: frees the thread which exited and moves the thread which may not run
+ *  on this processor anymore. Called with the interrupts disabled.
+ */
+static void finish_switch() {
+    struct sched_cpu *sc = this_sched();
+    struct thread *dead = sc->dead;
+    struct thread *migrate = sc->migrate;
+
+    sc->dead = 0;
+    sc->migrate = 0;
+
+    if (dead) {
+        if (dead->stack) {
+            pmm_free_pages(virt_to_phys(dead->stack), THREAD_STACK_ORDER);
+        }
+        kmem_cache_free(thread_cache, dead);
+    }
+    if (migrate) {
+        activate(migrate, 0);
+    }
+}
+
+/** thread_start:
+ *  First function run by a new thread, switch_context returns into it.
+ */
+static void thread_start() {
+    struct thread *self;
+
+    finish_switch();
+    self = this_sched()->current;
+    // schedule disabled the interrupts before switching to the new thread.
+    irq_restore(EFLAGS_IF);
+
+    self->entry(self->arg);
+    thread_exit();
+}
+
+/** idle_loop:
+ *  Runs when no other thread is ready. Halts the processor until an interrupt arrives; an interrupt which makes a
+ *  thread ready switches away from the idle thread on its way out.
+ */
+static void idle_loop(void *arg) {
+    (void) arg;
+
+    for (;;) {
+        struct sched_cpu *sc;
+
+        asm volatile("cli");
+        sc = this_sched();
+        if (sc->queue.bitmap || sc->need_resched) {
+            // A thread became ready without an interrupt handler switching to it (e.g. woken by the boot thread).
+            schedule();
+            asm volatile("sti");
+            continue;
+        }
+        /* sti only takes effect after the next instruction, so no interrupt can slip in between the check above and
+         * hlt; an interrupt arriving after the check wakes hlt up. */
+        asm volatile("sti\n\thlt" : : : "memory");
+        sc->stats.idle_wakeups++;
+    }
+}
+
+/** alloc_thread:
+ *  Allocates and initializes a thread descriptor.
+ */
+static struct thread *alloc_thread(const char *name, int priority) {
+    struct thread *thread = kmem_cache_alloc(thread_cache);
+
+    if (thread == 0) {
+        return 0;
+    }
+
+    if (priority < SCHED_PRIORITY_HIGHEST) {
+        priority = SCHED_PRIORITY_HIGHEST;
+    }
+    if (priority > SCHED_PRIORITY_LOWEST) {
+        priority = SCHED_PRIORITY_LOWEST;
+    }
+
+    thread->esp = 0;
+    thread->id = __atomic_fetch_add(&next_thread_id, 1, __ATOMIC_RELAXED);
+    thread->name = name;
+    thread->state = THREAD_READY;
+    thread->priority = priority;
+    thread->time_slice = SCHED_TIME_SLICE;
+    thread->ticks = 0;
+    thread->stack = 0;
+    thread->entry = 0;
+    thread->arg = 0;
+    thread->affinity = SCHED_AFFINITY_ALL;
+    thread->cpu = 0;
+    thread->on_cpu = 0;
+    thread->wake_pending = 0;
+    thread->next = 0;
+    thread->esp0 = 0;
+    thread->space = 0;
+    thread->fpu_cpu = FPU_NO_CPU;
+    fpu_init_state(thread->fpu_state);
+
+    return thread;
+}
+
+/** prepare_thread:
+ *  Allocates the stack of a thread and lays out the frame switch_context expects, so the first switch to the thread
+ *  "returns" into thread_start.
+ *
+ *  @return 0 on success, -1 if the memory is exhausted
+ */
+static int prepare_thread(struct thread *thread, void (*entry)(void *), void *arg) {
+    uint32_t stack = pmm_alloc_pages(THREAD_STACK_ORDER);
+    uint32_t *sp;
+
+    if (stack == 0) {
+        return -1;
+    }
+
+    thread->stack = phys_to_virt(stack);
+    thread->entry = entry;
+    thread->arg = arg;
+
+    sp = (uint32_t *) ((uint32_t) thread->stack + THREAD_STACK_SIZE);
+    *--sp = 0;                          // return address of thread_start, never used
+    *--sp = (uint32_t) thread_start;    // popped by the ret of switch_context
+    *--sp = 0;                          // ebp
+    *--sp = 0;                          // ebx
+    *--sp = 0;                          // esi
+    *--sp = 0;                          // edi
+    thread->esp = (uint32_t) sp;
+
+    return 0;
+}
+
+/** sched_init:
+ *  Initializes the scheduler. The code calling it becomes the boot thread, running on the stack set up by the loader.
+ *  Requires the slab allocator.
+ */
+void sched_init() {
+    struct sched_cpu *sc = &sched_cpus[0];
+
+    thread_cache = kmem_cache_create("thread", sizeof(struct thread), FPU_STATE_ALIGN, 0);
+
+    for (int cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        spin_lock_init(&sched_cpus[cpu].queue.lock);
+        timer_init(&sched_cpus[cpu].tick, sched_tick_timer, 0);
+    }
+
+    sc->current = alloc_thread("main", SCHED_PRIORITY_DEFAULT);
+    sc->current->state = THREAD_RUNNING;
+    sc->current->on_cpu = 1;
+
+    sc->idle = alloc_thread("idle", SCHED_PRIORITY_LOWEST);
+    sc->idle->affinity = 1;
+    prepare_thread(sc->idle, idle_loop, 0);
+
+    online_mask = 1;
+    // The boot thread runs, so the tick does; it is programmed once the timers have a clock event.
+    timer_add(&sc->tick, SCHED_TICK_PERIOD);
+}
+
+/** sched_start_ap:
+ *  Starts scheduling on an application processor. The code calling it becomes the idle thread of the processor, on
+ *  its boot stack, and never returns.
+ */
+void sched_start_ap() {
+    uint32_t cpu = this_cpu()->id;
+    struct sched_cpu *sc = &sched_cpus[cpu];
+    struct thread *idle = alloc_thread("idle", SCHED_PRIORITY_LOWEST);
+
+    asm volatile("cli");
+    idle->state = THREAD_RUNNING;
+    idle->affinity = 1u << cpu;
+    idle->cpu = cpu;
+    idle->on_cpu = 1;
+    sc->idle = idle;
+    sc->current = idle;
+    sc->switch_time = ktime_get_ns();
+    __atomic_or_fetch(&online_mask, 1u << cpu, __ATOMIC_RELEASE);
+
+    idle_loop(0);
+}
+
+/** thread_create:
+ *  Creates a kernel thread and makes it ready to run.
+ *
+ *  @param name     Name of the thread. The string is not copied.
+ *  @param entry    Function run by the thread, the thread exits when it returns
+ *  @param arg      Argument passed to entry
+ *  @param priority Priority of the thread, SCHED_PRIORITY_HIGHEST (0) to SCHED_PRIORITY_LOWEST
+ *  @return         The thread, 0 if the memory is exhausted
+ */
+struct thread *thread_create(const char *name, void (*entry)(void *), void *arg, int priority) {
+    struct thread *thread = alloc_thread(name, priority);
+    uint32_t flags;
+
+    if (thread == 0) {
+        return 0;
+    }
+    if (prepare_thread(thread, entry, arg) != 0) {
+        kmem_cache_free(thread_cache, thread);
+        return 0;
+    }
+
+    flags = irq_save();
+    thread->cpu = this_cpu()->id;
+    activate(thread, 0);
+    irq_restore(flags);
+
+    return thread;
+}
+
+/** schedule_locked:
+ *  Switches to the highest priority ready thread. Called with the interrupts disabled and the run queue lock of the
+ *  running processor held, which is released.
+ */
+static void schedule_locked(struct sched_cpu *sc) {
+    uint32_t cpu = this_cpu()->id;
+    struct thread *prev = sc->current;
+    struct thread *next;
+    uint32_t *directory;
+    uint64_t now;
+
+    sc->need_resched = 0;
+
+    if (prev->state == THREAD_RUNNING) {
+        prev->state = THREAD_READY;
+        if (prev == sc->idle) {
+            // The idle thread is never queued.
+        }
+        else if (prev->affinity & (1u << cpu)) {
+            enqueue(&sc->queue, prev);
+        }
+        else {
+            sc->migrate = prev;
+        }
+    }
+    else if (prev->state == THREAD_ZOMBIE) {
+        sc->dead = prev;
+    }
+
+    next = dequeue_highest(&sc->queue);
+    if (next == 0) {
+        next = steal_from(cpu, find_busiest(cpu, 1));
+    }
+    if (next == 0) {
+        next = sc->idle;
+    }
+
+    next->state = THREAD_RUNNING;
+    next->cpu = cpu;
+    if (next == prev) {
+        spin_unlock(&sc->queue.lock);
+        return;
+    }
+
+    now = ktime_get_ns();
+    if (prev == sc->idle) {
+        sc->stats.idle_time += now - sc->switch_time;
+    }
+    else {
+        sc->stats.busy_time += now - sc->switch_time;
+    }
+    sc->switch_time = now;
+
+    // Leaving the idle thread restarts the tick, which stopped while the processor had nothing to run.
+    if (next != sc->idle && !timer_pending(&sc->tick)) {
+        timer_add(&sc->tick, now + SCHED_TICK_PERIOD);
+    }
+
+    next->time_slice = SCHED_TIME_SLICE;
+    sc->current = next;
+    sc->stats.context_switches++;
+    spin_unlock(&sc->queue.lock);
+
+    // Saves the FPU registers if prev used them, before another processor may pick prev up.
+    fpu_switch(prev);
+    // Interrupts and system calls from user mode enter the kernel on the stack of the thread running the user code.
+    if (next->esp0) {
+        this_cpu()->tss.esp0 = next->esp0;
+    }
+    /* A thread of a process runs in its address space, the other threads in the kernel page directory; never in an
+     * address space which may be freed while the processor still has it loaded. */
+    directory = next->space ? next->space->directory : paging_kernel_directory();
+    if (read_cr3() != virt_to_phys(directory)) {
+        paging_switch_directory(directory);
+    }
+    switch_context(&prev->esp, &next->esp, &prev->on_cpu, &next->on_cpu);
+
+    // Running as prev again, switched back by another call of schedule, possibly on another processor.
+    finish_switch();
+}
+
+/** schedule:
+ *  Switches to the highest priority ready thread. The current thread is put back to the run queue if it is still
+ *  runnable, behind the other threads of its priority.
+ */
+void schedule() {
+    uint32_t flags = irq_save();
+    struct sched_cpu *sc = this_sched();
+
+    spin_lock(&sc->queue.lock);
+    schedule_locked(sc);
+    irq_restore(flags);
+}
+
+/** thread_yield:
+ *  Gives the processor to the other ready threads of the same or a higher priority.
+ */
+void thread_yield() {
+    schedule();
+}
+
+/** thread_block:
+ *  Puts the current thread to sleep until thread_wake is called for it. To avoid missing a wake-up, disable the
+ *  interrupts before checking the condition the thread waits for: a wake-up from another processor after the check
+ *  makes thread_block return at once. It may also return for a wake-up which came before the check, so the condition
+ *  has to be checked again.
+ */
+void thread_block() {
+    uint32_t flags = irq_save();
+    struct sched_cpu *sc = this_sched();
+    struct thread *self = sc->current;
+
+    spin_lock(&sc->queue.lock);
+    if (self->wake_pending) {
+        self->wake_pending = 0;
+        spin_unlock(&sc->queue.lock);
+        irq_restore(flags);
+        return;
+    }
+    self->state = THREAD_BLOCKED;
+    schedule_locked(sc);
+    irq_restore(flags);
+}
+
+/** thread_wake:
+ *  Makes a blocked thread ready. Can be called from interrupt handlers and from any processor.
+ *
+ *  @param thread The thread
+ */
+void thread_wake(struct thread *thread) {
+    uint32_t flags = irq_save();
+    struct sched_cpu *sc = lock_thread(thread);
+
+    if (thread->state == THREAD_BLOCKED) {
+        thread->state = THREAD_READY;
+        spin_unlock(&sc->queue.lock);
+        activate(thread, 1);
+    }
+    else {
+        if (thread->state == THREAD_RUNNING) {
+            thread->wake_pending = 1;
+        }
+        spin_unlock(&sc->queue.lock);
+    }
+    irq_restore(flags);
+}
+
+/** thread_set_affinity:
+ *  Restricts the processors a thread may run on. A thread running or queued on a processor it may not use anymore is
+ *  moved.
+ *
+ *  @param thread   The thread
+ *  @param affinity Bit n allows processor n
+ *  @return         0 on success, -1 if the mask allows no online processor
+ */
+int thread_set_affinity(struct thread *thread, uint32_t affinity) {
+    uint32_t flags;
+    struct sched_cpu *sc;
+    int move = 0;
+    int remote = 0;
+
+    if ((affinity & online_mask) == 0) {
+        return -1;
+    }
+
+    flags = irq_save();
+    sc = lock_thread(thread);
+    thread->affinity = affinity;
+    if (!(affinity & (1u << thread->cpu))) {
+        if (sc->current == thread) {
+            // It is moved when it is switched out.
+            sc->need_resched = 1;
+            remote = thread->cpu != this_cpu()->id;
+        }
+        else if (thread->state == THREAD_READY) {
+            struct thread *previous = 0;
+            struct thread *t = sc->queue.head[thread->priority];
+
+            while (t && t != thread) {
+                previous = t;
+                t = t->next;
+            }
+            // A thread being moved by activate is not on any run queue yet, it is placed by its new mask.
+            if (t) {
+                dequeue(&sc->queue, thread, previous);
+                move = 1;
+            }
+        }
+    }
+    spin_unlock(&sc->queue.lock);
+
+    if (move) {
+        activate(thread, 0);
+    }
+    else if (remote) {
+        smp_send_reschedule(thread->cpu);
+    }
+    irq_restore(flags);
+
+    return 0;
+}
+
+/** thread_exit:
+ *  Terminates the current thread.
+ */
+void thread_exit() {
+    struct sched_cpu *sc;
+
+    irq_save();
+    sc = this_sched();
+
+    spin_lock(&sc->queue.lock);
+    sc->current->state = THREAD_ZOMBIE;
+    schedule_locked(sc);
+
+    // Not reached, a zombie is never scheduled again.
+    for (;;) {
+        asm volatile("hlt");
+    }
+}
+
+/** thread_current:
+ *  Returns the running thread.
+ */
+struct thread *thread_current() {
+    uint32_t flags = irq_save();
+    struct thread *current = this_sched()->current;
+
+    irq_restore(flags);
+    return current;
+}
+
+/** sched_balance:
+ *  Pulls a thread from the busiest run queue when it has at least two ready threads more than the run queue of the
+ *  running processor. Called from the timer tick.
+ */
+static void sched_balance(struct sched_cpu *sc, uint32_t cpu) {
+    struct thread *thread;
+    int busiest = find_busiest(cpu, sc->queue.nr_running + 2);
+
+    if (busiest < 0) {
+        return;
+    }
+
+    spin_lock(&sc->queue.lock);
+    thread = steal_from(cpu, busiest);
+    if (thread) {
+        enqueue(&sc->queue, thread);
+        if (thread->priority < sc->current->priority || sc->current == sc->idle) {
+            sc->need_resched = 1;
+        }
+    }
+    spin_unlock(&sc->queue.lock);
+}
+
+/** kick_idle:
+ *  Wakes up an idle processor which may steal from the run queue of the running processor, which has threads waiting.
+ *  The idle processors take no tick, they would not notice the waiting threads otherwise.
+ */
+static void kick_idle(uint32_t self) {
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        struct sched_cpu *sc = &sched_cpus[cpu];
+
+        if (cpu != self && (online_mask & (1u << cpu)) && sc->current == sc->idle && sc->queue.nr_running == 0) {
+            sc->need_resched = 1;
+            smp_send_reschedule(cpu);
+            return;
+        }
+    }
+}
+
+/** sched_tick:
+ *  Accounts a scheduler tick to the running thread.
+ */
+static void sched_tick(struct sched_cpu *sc, uint32_t cpu) {
+    struct thread *current = sc->current;
+
+    current->ticks++;
+
+    if (current == sc->idle) {
+        // The last tick before the tick stops, there may be work left.
+        if (sc->queue.bitmap || find_busiest(cpu, 1) >= 0) {
+            sc->need_resched = 1;
+        }
+    }
+    else if (current->time_slice > 0 && --current->time_slice == 0) {
+        sc->need_resched = 1;
+    }
+
+    if (++sc->balance_ticks >= SCHED_BALANCE_INTERVAL) {
+        sc->balance_ticks = 0;
+        sched_balance(sc, cpu);
+        if (sc->queue.nr_running > 0) {
+            kick_idle(cpu);
+        }
+    }
+}
+
+/** sched_tick_timer:
+ *  Function of the tick timer of a processor. Re-arms the timer one period later, unless the processor went idle.
+ */
+static void sched_tick_timer(struct timer *timer) {
+    uint32_t cpu = this_cpu()->id;
+    struct sched_cpu *sc = &sched_cpus[cpu];
+    uint64_t next = timer->expires + SCHED_TICK_PERIOD;
+    uint64_t now;
+
+    sched_tick(sc, cpu);
+    if (sc->current == sc->idle && !sc->need_resched) {
+        return;
+    }
+
+    // Ticks missed while the interrupts were disabled for long are dropped rather than caught up with.
+    now = ktime_get_ns();
+    if (next <= now) {
+        next = now + SCHED_TICK_PERIOD;
+    }
+    timer_add(timer, next);
+}
+
+/** sched_preempt:
+ *  Reschedules if it was requested. Called at the end of the interrupt handler, after the interrupt is acknowledged,
+ *  and after the system calls, which run with the interrupts enabled.
+ */
+void sched_preempt() {
+    uint32_t flags = irq_save();
+
+    if (this_sched()->need_resched) {
+        schedule();
+    }
+    irq_restore(flags);
+}
+
+/** sched_get_stats:
+ *  Copies the scheduler statistics of a processor.
+ *
+ *  @param cpu The processor
+ *  @param out Where the statistics are copied to
+ */
+void sched_get_stats(uint32_t cpu, struct sched_stats *out) {
+    struct sched_cpu *sc = &sched_cpus[cpu % SMP_MAX_CPUS];
+    uint32_t flags = spin_lock_irqsave(&sc->queue.lock);
+    uint64_t running = ktime_get_ns() - sc->switch_time;
+
+    *out = sc->stats;
+    // Add the time of the running thread up to now.
+    if (sc->current == sc->idle) {
+        out->idle_time += running;
+    }
+    else {
+        out->busy_time += running;
+    }
+    spin_unlock_irqrestore(&sc->queue.lock, flags);
+}
+
+/** sched_print_stats:
+ *  Writes the utilisation and the scheduler statistics of every processor to the console.
+ */
+void sched_print_stats() {
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        struct sched_stats snapshot;
+        uint64_t idle_ms;
+        uint64_t total_ms;
+        uint64_t percent;
+
+        if (!(online_mask & (1u << cpu))) {
+            continue;
+        }
+        sched_get_stats(cpu, &snapshot);
+        idle_ms = snapshot.idle_time;
+        total_ms = snapshot.idle_time + snapshot.busy_time;
+        div64_u32(&idle_ms, NSEC_PER_MSEC);
+        div64_u32(&total_ms, NSEC_PER_MSEC);
+        percent = idle_ms * 100;
+        if (total_ms) {
+            div64_u32(&percent, (uint32_t) total_ms);
+        }
+        else {
+            percent = 100;
+        }
+
+        os_printf("CPU%u: %u%% idle (%u of %u ms), %u wakeups, %u switches, %u migrations, %u ready\n", cpu,
+                  (uint32_t) percent, (uint32_t) idle_ms, (uint32_t) total_ms,
+                  snapshot.idle_wakeups, snapshot.context_switches, snapshot.migrations,
+                  sched_cpus[cpu].queue.nr_running);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#ifndef __SCHED_H__
+#define __SCHED_H__
+
+#include "../../include/stdint.h"
+#include "../sync/spinlock.h"
+#include "../smp/smp.h"
+#include "../time/timer.h"
+#include "../cpu/fpu.h"
+
+#define THREAD_STACK_ORDER      1                               /* kernel stacks are 2^1 pages */
+#define THREAD_STACK_SIZE       (4096 << THREAD_STACK_ORDER)
+
+// Priority levels, 0 is the highest priority.
+#define SCHED_PRIORITY_LEVELS   32
+#define SCHED_PRIORITY_HIGHEST  0
+#define SCHED_PRIORITY_DEFAULT  16
+#define SCHED_PRIORITY_LOWEST   (SCHED_PRIORITY_LEVELS - 1)
+
+// Period of the scheduler tick, which only runs while the processor has a thread to run.
+#define SCHED_TICK_PERIOD       10000000    /* nanoseconds, 100 Hz */
+
+// Number of scheduler ticks a thread runs before it is preempted in favour of a thread of the same priority.
+#define SCHED_TIME_SLICE        5
+
+// Ticks between two load balancing passes of a processor
+#define SCHED_BALANCE_INTERVAL  4
+
+// Affinity mask allowing all processors, bit n allows processor n.
+#define SCHED_AFFINITY_ALL      0xFFFFFFFF
+
+#define THREAD_RUNNING          0
+#define THREAD_READY            1
+#define THREAD_BLOCKED          2
+#define THREAD_ZOMBIE           3
+
+struct address_space;
+
+struct thread {
+    uint32_t esp;               // saved stack pointer while the thread is switched out
+    uint32_t id;
+    const char *name;
+    int state;
+    int priority;
+    uint32_t time_slice;        // ticks left before preemption
+    uint32_t ticks;             // ticks spent running
+    void *stack;                // base of the kernel stack, 0 for the boot thread
+    void (*entry)(void *);
+    void *arg;
+    uint32_t affinity;          // processors the thread may run on
+    uint32_t cpu;               // processor whose run queue lock protects the thread
+    volatile int on_cpu;        // set while a processor runs the thread or is still switching away from it
+    volatile int wake_pending;  // woken while running, the next thread_block returns at once
+    struct thread *next;        // link of the run queue
+    uint32_t esp0;              // kernel stack pointer on entry from user mode, 0 while the thread runs no user code
+    struct address_space *space;    // address space of the process of the thread, 0 for a kernel thread
+    uint32_t fpu_cpu;           // processor whose FPU registers may still hold fpu_state, FPU_NO_CPU if none
+    uint8_t fpu_state[FPU_STATE_SIZE] __attribute__((aligned(FPU_STATE_ALIGN)));   // saved FPU and SSE registers
+};
+
+/* Run queue with one FIFO list per priority level. Bit n of the bitmap is set when the list of level n is not empty,
+ * so the highest priority ready thread is found with a single bit scan, independent of the number of threads. Every
+ * processor has its own run queue. */
+struct run_queue {
+    struct spinlock lock;
+    uint32_t bitmap;
+    struct thread *head[SCHED_PRIORITY_LEVELS];
+    struct thread *tail[SCHED_PRIORITY_LEVELS];
+    uint32_t nr_running;
+};
+
+// Scheduler statistics, the idle and busy time give the utilisation of the processor.
+struct sched_stats {
+    uint64_t idle_time;         // nanoseconds the idle thread ran
+    uint64_t busy_time;         // nanoseconds other threads ran
+    uint32_t idle_wakeups;      // times the idle thread woke up from hlt
+    uint32_t context_switches;
+    uint32_t migrations;        // threads taken from the run queue of another processor
+};
+
+void sched_init();
+void sched_start_ap();
+struct thread *thread_create(const char *name, void (*entry)(void *), void *arg, int priority);
+void thread_exit();
+void thread_yield();
+void thread_block();
+void thread_wake(struct thread *thread);
+int thread_set_affinity(struct thread *thread, uint32_t affinity);
+struct thread *thread_current();
+void schedule();
+void sched_preempt();
+void sched_get_stats(uint32_t cpu, struct sched_stats *out);
+void sched_print_stats();
+
+#endif
\ No newline at end of file
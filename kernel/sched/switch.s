@@ -0,0 +1,49 @@
+global switch_context   ; make the label switch_context visible outside this file
+
+; switch_context - Saves the context of the current thread and continues the thread whose context is given.
+; The eip of a thread is the return address on top of its stack, so only the callee-saved registers of the cdecl
+; calling convention (ebp, ebx, esi, edi) and the stack pointer have to be saved, everything else is already saved by
+; the caller (schedule).
+;
+; A thread can be woken up or stolen by another processor while it is still switching out here. Its on_cpu flag stays
+; set until its stack pointer is saved; a processor switching to it waits for the flag to clear first. The flag of
+; the current thread is cleared before waiting for the next one, so two processors never wait for each other. Once
+; the flag is cleared the current stack may be reused by another processor: nothing is read from or written to it
+; anymore, all arguments are loaded into registers beforehand. The stack pointer of the next thread is only read once
+; its flag is clear: before, its previous processor may not have saved it yet.
+; stack: [esp + 16] the on_cpu flag of the next thread
+;        [esp + 12] the on_cpu flag of the current thread
+;        [esp + 8]  the address of the saved stack pointer of the next thread
+;        [esp + 4]  the address where the stack pointer of the current thread is saved
+;        [esp    ]  the return address
+switch_context:
+    push ebp                ; save the callee-saved registers on the stack of the current thread
+    push ebx
+    push esi
+    push edi
+
+    mov eax, [esp + 20]     ; address to save the current stack pointer to
+    mov edx, [esp + 24]     ; address of the saved stack pointer of the next thread
+    mov ecx, [esp + 28]     ; on_cpu flag of the current thread
+    mov esi, [esp + 32]     ; on_cpu flag of the next thread
+
+    mov [eax], esp          ; save the stack pointer of the current thread
+    mov dword [ecx], 0      ; release the current thread, stores are not reordered with the store above
+
+.wait:
+    cmp dword [esi], 0      ; wait until the next thread is switched out on its previous processor
+    je .claim
+    pause
+    jmp .wait
+
+.claim:
+    mov dword [esi], 1
+    mov edx, [edx]          ; loads are not reordered with the load of the flag, so this sees the saved value
+    mov esp, edx            ; switch to the stack of the next thread
+
+    pop edi                 ; restore the callee-saved registers of the next thread
+    pop esi
+    pop ebx
+    pop ebp
+
+    ret                     ; return to where the next thread called switch_context (or to thread_start)
\ No newline at end of file
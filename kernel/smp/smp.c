@@ -0,0 +1,176 @@
+#include "smp.h"
+#include "../cpu/cpu.h"
+#include "../cpu/fpu.h"
+#include "../log/log.h"
+#include "../sched/sched.h"
+#include "../syscall/syscall.h"
+#include "../../include/string.h"
+#include "../../mm/paging/paging.h"
+#include "../../mm/physical/pmm.h"
+#include "../../drivers/apic/lapic.h"
+#include "../../drivers/interrupts/idt.h"
+#include "../../drivers/interrupts/isr.h"
+#include "../../drivers/timer/pit.h"
+
+/* Multiprocessor startup
+ *
+ * The firmware starts only the bootstrap processor; the others, the application processors (APs), wait until the
+ * bootstrap processor sends them an INIT IPI followed by startup IPIs. An AP starts in real mode at the page named by
+ * the startup IPI, where init_smp copied the trampoline (trampoline.s). The trampoline switches to protected mode and
+ * paging and calls ap_main on the boot stack init_smp allocated for the processor.
+ *
+ * Each processor has its own per-CPU area (struct cpu) with its GDT and TSS; gs selects a segment over the area, so
+ * this_cpu() costs a single load. The APs are started one at a time, since they share the trampoline parameters.
+ *
+ * Once up, an AP enters the scheduler as its idle thread; its local APIC timer only runs while it has timers pending.
+ * The scheduler interrupts another processor with the reschedule IPI when it gives it a thread to run. */
+
+// Defined in trampoline.s
+extern char trampoline_start[];
+extern char trampoline_params[];
+extern char trampoline_end[];
+
+// The bootstrap processor is cpus[0], its area must be usable before anything else is set up (init_gdt).
+static struct cpu cpus[SMP_MAX_CPUS] = {[0] = {.self = &cpus[0]}};
+static uint32_t cpu_count = 1;
+
+/** ap_main:
+ *  The C entrypoint of the application processors, called by the trampoline on the boot stack of the processor.
+ *
+ *  @param cpu The per-CPU area of the processor
+ */
+void ap_main(struct cpu *cpu) {
+    paging_init_cpu();
+    gdt_init_cpu(cpu);
+    idt_load();
+    syscall_init_cpu();
+    init_fpu();
+    lapic_init_cpu();
+    // A processor which arrived late may have claimed the area meant for the next one, IPIs must reach the right one.
+    cpu->apic_id = lapic_id();
+
+    __atomic_store_n(&cpu->online, 1, __ATOMIC_RELEASE);
+    sched_start_ap();
+}
+
+/** smp_reschedule_handler:
+ *  Handles the reschedule IPI. The sender already requested the reschedule, which happens on the way out of the
+ *  interrupt (sched_preempt).
+ */
+static void smp_reschedule_handler() {
+    lapic_eoi();
+}
+
+/** smp_send_reschedule:
+ *  Makes another processor reschedule, e.g. because a thread was queued on it.
+ *
+ *  @param id The index of the processor
+ */
+void smp_send_reschedule(uint32_t id) {
+    if (id < SMP_MAX_CPUS && __atomic_load_n(&cpus[id].online, __ATOMIC_ACQUIRE) && id != this_cpu()->id) {
+        lapic_send_fixed(cpus[id].apic_id, LAPIC_RESCHEDULE_VECTOR);
+    }
+}
+
+/** smp_start_cpu:
+ *  Starts an application processor with the INIT-SIPI-SIPI sequence and waits until it runs ap_main.
+ *
+ *  @return 0 if the processor came up, -1 otherwise
+ */
+static int smp_start_cpu(struct cpu *cpu) {
+    struct smp_trampoline_params *params =
+            phys_to_virt(SMP_TRAMPOLINE_ADDRESS + (trampoline_params - trampoline_start));
+    uint32_t stack = pmm_alloc_pages(SMP_STACK_ORDER);
+
+    if (stack == 0) {
+        return -1;
+    }
+    cpu->stack_top = (uint32_t) phys_to_virt(stack) + SMP_STACK_SIZE;
+
+    params->cr3 = virt_to_phys(paging_kernel_directory());
+    params->stack = cpu->stack_top;
+    params->cpu = (uint32_t) cpu;
+
+    lapic_send_init(cpu->apic_id);
+    pit_busy_wait(10000);
+
+    // A second startup IPI is only needed if the processor missed the first one.
+    for (int attempt = 0; attempt < 2; attempt++) {
+        lapic_send_startup(cpu->apic_id, SMP_STARTUP_VECTOR);
+        for (int ms = 0; ms < SMP_STARTUP_TIMEOUT; ms++) {
+            if (__atomic_load_n(&cpu->online, __ATOMIC_ACQUIRE)) {
+                return 0;
+            }
+            pit_busy_wait(1000);
+        }
+    }
+
+    /* Revoke the parameters. If the processor claimed them in the meantime it is on its way and may still use the
+     * stack and the area, which are then never handed out again. Otherwise it halts should it arrive late. */
+    if (__atomic_exchange_n(&params->cpu, 0, __ATOMIC_ACQ_REL) != 0) {
+        pmm_free_pages(stack, SMP_STACK_ORDER);
+    }
+    return -1;
+}
+
+/** init_smp:
+ *  Starts the application processors the MADT lists. Requires the local APIC (init_apic), the scheduler and the
+ *  physical memory manager. The tick source must be started before, the APs start their timers alike. Without a local
+ *  APIC the kernel runs on the bootstrap processor only.
+ */
+void init_smp() {
+    const struct acpi_madt_info *madt = acpi_get_madt();
+    uint32_t bsp_apic_id;
+    uint32_t slot = 1;
+
+    if (madt == 0 || !lapic_enabled()) {
+        return;
+    }
+
+    bsp_apic_id = lapic_id();
+    cpus[0].id = 0;
+    cpus[0].apic_id = bsp_apic_id;
+    cpus[0].online = 1;
+
+    register_interrupt_handler(LAPIC_RESCHEDULE_VECTOR, smp_reschedule_handler);
+    memcpy(phys_to_virt(SMP_TRAMPOLINE_ADDRESS), trampoline_start, trampoline_end - trampoline_start);
+
+    /* Every processor gets the next unused area. The area of a processor which did not come up is not reused for
+     * the next one: a late processor could still be running with it, and two processors must never share a GDT and a
+     * TSS. The indices of the processors may have gaps then. */
+    for (int i = 0; i < madt->cpu_count && slot < SMP_MAX_CPUS; i++) {
+        struct cpu *cpu = &cpus[slot];
+
+        if (madt->cpu_apic_ids[i] == bsp_apic_id) {
+            continue;
+        }
+
+        cpu->self = cpu;
+        cpu->id = slot++;
+        cpu->apic_id = madt->cpu_apic_ids[i];
+        if (smp_start_cpu(cpu) == 0) {
+            cpu_count++;
+        }
+        else {
+            log_warning("SMP: CPU with APIC ID %u did not start", cpu->apic_id);
+        }
+    }
+
+    log_info("SMP: %u of %d CPUs online", cpu_count, madt->cpu_count);
+}
+
+/** smp_get_cpu:
+ *  Returns the per-CPU area of a processor.
+ *
+ *  @param id The index of the processor, below SMP_MAX_CPUS
+ */
+struct cpu *smp_get_cpu(uint32_t id) {
+    return id < SMP_MAX_CPUS ? &cpus[id] : 0;
+}
+
+/** smp_cpu_count:
+ *  Returns the number of processors online.
+ */
+uint32_t smp_cpu_count() {
+    return cpu_count;
+}
\ No newline at end of file
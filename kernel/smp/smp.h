@@ -0,0 +1,55 @@
+#ifndef __SMP_H__
+#define __SMP_H__
+
+#include "../../include/stdint.h"
+#include "../../mm/segmentation/gdt.h"
+#include "../acpi/acpi.h"
+
+#define SMP_MAX_CPUS            ACPI_MAX_CPUS
+
+// The application processors start in real mode at the page given by the startup IPI, below 1 MB.
+#define SMP_TRAMPOLINE_ADDRESS  0x8000
+#define SMP_STARTUP_VECTOR      (SMP_TRAMPOLINE_ADDRESS >> 12)
+
+// Order of the pages of the boot stack of an application processor
+#define SMP_STACK_ORDER         1
+#define SMP_STACK_SIZE          (4096 << SMP_STACK_ORDER)
+
+// How long the bootstrap processor waits for an application processor to come up
+#define SMP_STARTUP_TIMEOUT     100         /* milliseconds */
+
+// Per-CPU area. The percpu segment of each processor covers its own area, so gs:0 is this_cpu.
+struct cpu {
+    struct cpu *self;           // must stay first, read by this_cpu
+    uint32_t id;                // index of the processor, 0 for the bootstrap processor
+    uint32_t apic_id;
+    volatile int online;
+    uint32_t stack_top;         // top of the boot stack, 0 for the bootstrap processor (loader.s provides it)
+    struct gdt_entry gdt[GDT_ENTRY_COUNT] __attribute__((aligned(8)));
+    struct gdt gdt_pointer;
+    struct tss tss __attribute__((aligned(4)));     // esp0 is read on every entry from user mode
+};
+
+// Filled by init_smp in the copy of the trampoline before each startup IPI, see trampoline.s.
+struct smp_trampoline_params {
+    uint32_t cr3;
+    uint32_t stack;
+    uint32_t cpu;
+};
+
+/** this_cpu:
+ *  Returns the per-CPU area of the running processor. Read through gs, so it takes a single load.
+ */
+static inline struct cpu *this_cpu() {
+    struct cpu *cpu;
+
+    asm volatile("mov %%gs:0, %0" : "=r"(cpu));
+    return cpu;
+}
+
+void init_smp();
+struct cpu *smp_get_cpu(uint32_t id);
+uint32_t smp_cpu_count();
+void smp_send_reschedule(uint32_t id);
+
+#endif
\ No newline at end of file
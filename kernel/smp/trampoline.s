@@ -0,0 +1,89 @@
+global trampoline_start
+global trampoline_params
+global trampoline_end
+extern boot_page_directory      ; defined in loader.s
+extern ap_main                  ; the C entrypoint of the application processors, in smp.c
+
+; The startup IPI starts an application processor in real mode at SMP_TRAMPOLINE_ADDRESS (see kernel/smp/smp.h).
+; init_smp copies the code from trampoline_start to trampoline_end there, so the code between them must not depend on
+; where it is linked: every address is computed relative to trampoline_start with the TRAMPOLINE macro.
+SMP_TRAMPOLINE_ADDRESS equ 0x8000
+KERNEL_VIRTUAL_BASE equ 0xC0000000
+CR0_PE              equ 0x00000001                  ; protected mode enable bit of cr0
+CR0_PG              equ 0x80000000                  ; paging enable bit of cr0
+CR4_PSE             equ 0x00000010                  ; 4 MB page enable bit of cr4
+
+%define TRAMPOLINE(label) (SMP_TRAMPOLINE_ADDRESS + (label) - trampoline_start)
+
+section .text
+bits 16
+trampoline_start:
+    cli
+    cld
+    xor ax, ax
+    mov ds, ax                  ; address the trampoline by its physical address
+
+    lgdt [TRAMPOLINE(trampoline_gdtr)]
+    mov eax, cr0
+    or eax, CR0_PE              ; enter protected mode
+    mov cr0, eax
+    jmp dword 0x08:TRAMPOLINE(trampoline_protected)
+
+bits 32
+trampoline_protected:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    ; Enable paging with the boot page directory like the loader does, it maps the trampoline and the kernel.
+    mov ecx, (boot_page_directory - KERNEL_VIRTUAL_BASE)
+    mov cr3, ecx
+    mov ecx, cr4
+    or ecx, CR4_PSE
+    mov cr4, ecx
+    mov ecx, cr0
+    or ecx, CR0_PG
+    mov cr0, ecx
+
+    ; Continue in the higher half, eip is still a low address.
+    lea ecx, [ap_higher_half]
+    jmp ecx
+
+; A flat code and a flat data segment, until the processor loads its own GDT.
+align 8
+trampoline_gdt:
+    dq 0
+    dq 0x00CF9A000000FFFF       ; code: base 0, limit 4 GB, 32-bit, ring 0
+    dq 0x00CF92000000FFFF       ; data: base 0, limit 4 GB, 32-bit, ring 0
+trampoline_gdtr:
+    dw 3 * 8 - 1
+    dd TRAMPOLINE(trampoline_gdt)
+
+; Filled by init_smp for each processor, see struct smp_trampoline_params.
+align 4
+trampoline_params:
+    dd 0                        ; cr3: the kernel page directory
+    dd 0                        ; stack: top of the boot stack of the processor
+    dd 0                        ; cpu: the per-CPU area of the processor
+trampoline_end:
+
+ap_higher_half:
+    ; The parameters are read through the higher half mapping of the copy.
+    mov ebx, KERNEL_VIRTUAL_BASE + TRAMPOLINE(trampoline_params)
+    ; Claim the per-CPU area. init_smp revokes it when the processor does not come up in time, a processor which
+    ; arrives after that finds 0 and stays halted, without touching the stack or the area.
+    xor eax, eax
+    xchg eax, [ebx + 8]
+    test eax, eax
+    jz .loop
+    mov ecx, [ebx]
+    mov cr3, ecx                ; switch to the kernel page directory
+    mov esp, [ebx + 4]
+    push eax
+    call ap_main                ; ap_main(cpu), does not return
+.loop:
+    hlt
+    jmp .loop
\ No newline at end of file
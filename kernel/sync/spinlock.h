@@ -0,0 +1,70 @@
+#ifndef __SPINLOCK_H__
+#define __SPINLOCK_H__
+
+#include "../../include/stdint.h"
+#include "../cpu/cpu.h"
+
+/* Ticket spinlock
+ *
+ * A processor takes the next ticket and spins until the owner counter reaches it, so the processors get the lock in
+ * the order they asked for it and none of them starves. The waiters only read the lock while spinning, the cache line
+ * is written once per acquisition and once per release.
+ *
+ * A lock which is also taken by interrupt handlers must be held with the interrupts disabled
+ * (spin_lock_irqsave), otherwise an interrupt on the holding processor deadlocks on it. */
+
+struct spinlock {
+    volatile uint16_t next;     // next ticket to hand out
+    volatile uint16_t owner;    // ticket of the holder
+};
+
+#define SPINLOCK_INIT   {0, 0}
+
+static inline void spin_lock_init(struct spinlock *lock) {
+    lock->next = 0;
+    lock->owner = 0;
+}
+
+static inline void spin_lock(struct spinlock *lock) {
+    uint16_t ticket = __atomic_fetch_add(&lock->next, 1, __ATOMIC_RELAXED);
+
+    while (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket) {
+        asm volatile("pause");
+    }
+}
+
+/** spin_trylock:
+ *  Takes the lock if it is free.
+ *
+ *  @return Non-zero if the lock was taken
+ */
+static inline int spin_trylock(struct spinlock *lock) {
+    uint16_t owner = __atomic_load_n(&lock->owner, __ATOMIC_RELAXED);
+    uint16_t expected = owner;
+
+    return __atomic_compare_exchange_n(&lock->next, &expected, (uint16_t) (owner + 1), 0, __ATOMIC_ACQUIRE,
+                                       __ATOMIC_RELAXED);
+}
+
+static inline void spin_unlock(struct spinlock *lock) {
+    // Only the holder writes the owner counter.
+    __atomic_store_n(&lock->owner, (uint16_t) (lock->owner + 1), __ATOMIC_RELEASE);
+}
+
+static inline int spin_is_locked(struct spinlock *lock) {
+    return __atomic_load_n(&lock->owner, __ATOMIC_RELAXED) != __atomic_load_n(&lock->next, __ATOMIC_RELAXED);
+}
+
+static inline uint32_t spin_lock_irqsave(struct spinlock *lock) {
+    uint32_t flags = irq_save();
+
+    spin_lock(lock);
+    return flags;
+}
+
+static inline void spin_unlock_irqrestore(struct spinlock *lock, uint32_t flags) {
+    spin_unlock(lock);
+    irq_restore(flags);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include "syscall.h"
+#include "../cpu/cpu.h"
+#include "../smp/smp.h"
+#include "../sched/sched.h"
+#include "../console/console.h"
+#include "../../drivers/interrupts/idt.h"
+#include "../../mm/paging/paging.h"
+
+/* System calls
+ *
+ * User code enters the kernel in one of two ways. int 0x80 goes through the gate of SYSCALL_VECTOR, the only gate with
+ * DPL 3, and the common interrupt path; it works on every processor. sysenter jumps straight to sysenter_entry (in
+ * syscall_entry.s) without reading the IDT, the GDT or the TSS, and sysexit returns without popping a frame; the pair
+ * is considerably cheaper than int and iret where the processor has it. Both paths build the same struct
+ * interrupt_frame and end up in syscall_dispatch, which calls the function of the system call from syscall_table.
+ * The system calls run with the interrupts enabled: the gate of SYSCALL_VECTOR is a trap gate, and sysenter_entry
+ * enables them once the frame is saved. A long write then does not hold off the timers and the UART interrupts.
+ *
+ * A thread runs user code by calling user_enter. Its kernel stack below the frame of user_enter takes the interrupts
+ * and system calls from user mode; the exit system call unwinds back to user_enter, which returns the status. */
+
+// Defined in syscall_entry.s
+extern void sysenter_entry();
+extern int user_switch(uint32_t eip, uint32_t esp, uint32_t arg, uint32_t *thread_esp0, struct tss *tss);
+extern void user_return(uint32_t esp0, int status) __attribute__((noreturn));
+extern int user_copy(void *dst, const void *src, uint32_t n);
+extern char user_copy_start[];
+extern char user_copy_end[];
+extern char user_copy_fault[];
+
+static int sysenter_enabled;
+
+static uint32_t sys_exit(uint32_t status, uint32_t arg1, uint32_t arg2) {
+    struct thread *thread = thread_current();
+
+    (void) arg1;
+    (void) arg2;
+
+    // Raised by kernel code, which has no user_enter to return to.
+    if (thread->esp0 == 0) {
+        return SYSCALL_ERROR;
+    }
+    user_exit(status);
+}
+
+static uint32_t sys_write(uint32_t buffer, uint32_t length, uint32_t arg2) {
+    char chunk[SYSCALL_WRITE_CHUNK];
+    uint32_t written = 0;
+
+    (void) arg2;
+
+    /* The bytes go through a buffer on the kernel stack: a fault on the user buffer then happens in copy_from_user,
+     * which returns an error, and never inside console_write, which holds the console lock. */
+    while (written < length) {
+        uint32_t count = length - written < SYSCALL_WRITE_CHUNK ? length - written : SYSCALL_WRITE_CHUNK;
+
+        if (copy_from_user(chunk, buffer + written, count) != 0) {
+            return written ? written : SYSCALL_ERROR;
+        }
+        console_write(chunk, count);
+        written += count;
+    }
+
+    return written;
+}
+
+static uint32_t sys_yield(uint32_t arg0, uint32_t arg1, uint32_t arg2) {
+    (void) arg0;
+    (void) arg1;
+    (void) arg2;
+
+    thread_yield();
+
+    return 0;
+}
+
+static uint32_t sys_gettid(uint32_t arg0, uint32_t arg1, uint32_t arg2) {
+    (void) arg0;
+    (void) arg1;
+    (void) arg2;
+
+    return thread_current()->id;
+}
+
+// The functions of the system calls, indexed by system call number.
+static uint32_t (*const syscall_table[SYSCALL_COUNT])(uint32_t arg0, uint32_t arg1, uint32_t arg2) = {
+    [SYSCALL_EXIT] = sys_exit,
+    [SYSCALL_WRITE] = sys_write,
+    [SYSCALL_YIELD] = sys_yield,
+    [SYSCALL_GETTID] = sys_gettid,
+};
+
+/** syscall_dispatch:
+ *  Runs the system call requested by the frame and stores its result in the eax of the frame. Handles the int 0x80
+ *  gate, and is called by syscall_sysenter for the sysenter path.
+ *
+ *  @param frame The registers of the user code
+ */
+void syscall_dispatch(struct interrupt_frame *frame) {
+    uint32_t number = frame->eax;
+
+    if (number >= SYSCALL_COUNT || syscall_table[number] == 0) {
+        frame->eax = SYSCALL_ERROR;
+        return;
+    }
+    frame->eax = syscall_table[number](frame->ebx, frame->esi, frame->edi);
+}
+
+/** syscall_sysenter:
+ *  Called by sysenter_entry with the frame it built. Like an interrupt, a system call may end with a switch to another
+ *  thread.
+ *
+ *  @param frame The registers of the user code
+ */
+void syscall_sysenter(struct interrupt_frame *frame) {
+    syscall_dispatch(frame);
+    sched_preempt();
+}
+
+/** sysenter_supported:
+ *  Checks whether the processor has working sysenter and sysexit instructions.
+ */
+static int sysenter_supported() {
+    uint32_t eax, ebx, ecx, edx;
+
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    // The Pentium Pro (family 6, model and stepping below 3) reports SEP without supporting the instructions.
+    if (((eax >> 8) & 0xF) == 6 && ((eax >> 4) & 0xF) < 3 && (eax & 0xF) < 3) {
+        return 0;
+    }
+    return (edx & CPU_FEATURE_SEP) != 0;
+}
+
+/** init_syscall:
+ *  Opens the int 0x80 gate to user code and sets up sysenter on the bootstrap processor. Requires the IDT.
+ */
+void init_syscall() {
+    register_interrupt_handler(SYSCALL_VECTOR, syscall_dispatch);
+    idt_set_dpl(SYSCALL_VECTOR, GDT_RPL_USER);
+    idt_set_trap(SYSCALL_VECTOR);
+
+    sysenter_enabled = sysenter_supported();
+    syscall_init_cpu();
+}
+
+/** syscall_init_cpu:
+ *  Points the sysenter MSRs of the running processor to sysenter_entry. sysenter loads the stack pointer from the MSR,
+ *  which holds the address of esp0 in the TSS of the processor; sysenter_entry loads the kernel stack of the thread
+ *  from there. Called by each processor for itself, after its GDT is set up.
+ */
+void syscall_init_cpu() {
+    if (!sysenter_enabled) {
+        return;
+    }
+    wrmsr(MSR_SYSENTER_CS, KERNEL_CODE_SELECTOR);
+    wrmsr(MSR_SYSENTER_ESP, (uint32_t) &this_cpu()->tss.esp0);
+    wrmsr(MSR_SYSENTER_EIP, (uint32_t) sysenter_entry);
+}
+
+/** syscall_has_sysenter:
+ *  Returns non-zero if user code may use sysenter.
+ */
+int syscall_has_sysenter() {
+    return sysenter_enabled;
+}
+
+/** user_enter:
+ *  Runs user code on the running thread until it makes the exit system call. The user code starts in ring 3 with the
+ *  interrupts enabled, the given argument in eax and the other general purpose registers cleared. Its pages must be
+ *  mapped with PTE_USER in the active page directory.
+ *
+ *  @param eip Entry point of the user code
+ *  @param esp Stack pointer of the user code
+ *  @param arg Value of eax at the entry point
+ *  @return    The status passed to the exit system call
+ */
+int user_enter(uint32_t eip, uint32_t esp, uint32_t arg) {
+    uint32_t flags = irq_save();
+    struct thread *thread = thread_current();
+    int status;
+
+    status = user_switch(eip, esp, arg, &thread->esp0, &this_cpu()->tss);
+    thread->esp0 = 0;
+    irq_restore(flags);
+
+    return status;
+}
+
+/** user_exit:
+ *  Ends the user code of the running thread, the user_enter it runs under returns the given status. Called by the exit
+ *  system call and by the handlers of exceptions the user code caused, on the kernel stack of the thread.
+ *
+ *  @param status The status returned by user_enter
+ */
+void user_exit(int status) {
+    user_return(thread_current()->esp0, status);
+}
+
+/** copy_from_user:
+ *  Copies bytes from user memory of the running thread to kernel memory. The pages are faulted in as usual; an
+ *  address outside user space, or a fault the address space cannot resolve, makes the copy fail instead of halting.
+ *
+ *  @param dst    Destination in kernel memory
+ *  @param src    User address of the bytes
+ *  @param length Number of bytes
+ *  @return       0 on success, -1 if the bytes are not all readable user memory
+ */
+int copy_from_user(void *dst, uint32_t src, uint32_t length) {
+    if (src >= KERNEL_VIRTUAL_BASE || length > KERNEL_VIRTUAL_BASE - src) {
+        return -1;
+    }
+    return user_copy(dst, (const void *) src, length);
+}
+
+/** user_fault_fixup:
+ *  Resumes a page fault of the kernel on user memory inside user_copy at its error return. Called by the page fault
+ *  handler for the faults it could not resolve.
+ *
+ *  @param frame The frame of the page fault
+ *  @return      Non-zero if the fault was inside user_copy and the frame was redirected
+ */
+int user_fault_fixup(struct interrupt_frame *frame) {
+    if (frame->eip >= (uint32_t) user_copy_start && frame->eip < (uint32_t) user_copy_end) {
+        frame->eip = (uint32_t) user_copy_fault;
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
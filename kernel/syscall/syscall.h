@@ -0,0 +1,37 @@
+#ifndef __SYSCALL_H__
+#define __SYSCALL_H__
+
+#include "../../include/stdint.h"
+#include "../../drivers/interrupts/isr.h"
+
+// Vector of the int 0x80 system call gate, the one vector user code may raise.
+#define SYSCALL_VECTOR      0x80
+
+/* System call numbers, passed in eax; the result is returned in eax. The arguments are passed in ebx, esi and edi on
+ * both entry paths: sysexit takes the return address and the user stack pointer from edx and ecx, so the sysenter
+ * path has them hold those instead. Also used by the user code in assembly, which has its own copies. */
+#define SYSCALL_EXIT        0       /* exit(status): leaves user mode, user_enter returns status */
+#define SYSCALL_WRITE       1       /* write(buffer, length): writes to the console, returns the bytes written */
+#define SYSCALL_YIELD       2       /* yield(): lets other threads run */
+#define SYSCALL_GETTID      3       /* gettid(): returns the id of the calling thread */
+#define SYSCALL_COUNT       4
+
+// Returned for an unknown system call or invalid arguments
+#define SYSCALL_ERROR       ((uint32_t) -1)
+
+// Bytes sys_write copies from user memory to the kernel stack at a time
+#define SYSCALL_WRITE_CHUNK 256
+
+// Exit status of user code ended by an exception it raised, e.g. a general protection fault or an invalid opcode
+#define USER_FAULT_EXIT_STATUS  -1
+
+void init_syscall();
+void syscall_init_cpu();
+int syscall_has_sysenter();
+void syscall_dispatch(struct interrupt_frame *frame);
+int user_enter(uint32_t eip, uint32_t esp, uint32_t arg);
+void user_exit(int status) __attribute__((noreturn));
+int copy_from_user(void *dst, uint32_t src, uint32_t length);
+int user_fault_fixup(struct interrupt_frame *frame);
+
+#endif
\ No newline at end of file
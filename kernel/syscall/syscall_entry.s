@@ -0,0 +1,158 @@
+global sysenter_entry   ; make the labels visible outside this file
+global user_switch
+global user_return
+global user_copy
+global user_copy_start
+global user_copy_end
+global user_copy_fault
+extern syscall_sysenter
+
+KERNEL_DATA_SELECTOR equ 0x10       ; GDT_SELECTOR(GDT_KERNEL_DATA), see gdt.h
+USER_CODE_SELECTOR equ 0x1B         ; GDT_SELECTOR(GDT_USER_CODE) | GDT_RPL_USER, see gdt.h
+USER_DATA_SELECTOR equ 0x23         ; GDT_SELECTOR(GDT_USER_DATA) | GDT_RPL_USER, see gdt.h
+PERCPU_SELECTOR equ 0x30            ; GDT_SELECTOR(GDT_PERCPU), see gdt.h
+SYSCALL_VECTOR equ 0x80             ; see syscall.h
+TSS_ESP0 equ 4                      ; offset of esp0 in struct tss, see gdt.h
+USER_EFLAGS equ 0x202               ; the reserved bit 1 and IF: user code runs with the interrupts enabled
+
+section .text
+
+; sysenter_entry - Entry point of sysenter, set up by syscall_init_cpu.
+; sysenter loads cs and ss from the MSRs and esp with the address of esp0 in the TSS of the processor; it saves
+; nothing and disables the interrupts. The user code passes its stack pointer in ecx and the address to return to in
+; edx. A frame like the one of an int 0x80 from ring 3 is built on the kernel stack of the thread, so the system calls
+; see the same struct interrupt_frame on both paths. The system call runs with the interrupts enabled, like one made
+; through the trap gate of int 0x80.
+sysenter_entry:
+    mov   esp, [esp]                ; the kernel stack of the thread, esp0 of the TSS
+
+    push  dword USER_DATA_SELECTOR  ; user_ss
+    push  ecx                       ; user_esp
+    push  dword USER_EFLAGS         ; eflags
+    push  dword USER_CODE_SELECTOR  ; cs
+    push  edx                       ; eip
+    push  dword 0                   ; error code
+    push  dword SYSCALL_VECTOR      ; interrupt number
+
+    ; save the registers and load the kernel segments, as common_interrupt_handler does
+    pushad
+    push  ds
+    push  es
+    push  fs
+    push  gs
+    mov   ax, KERNEL_DATA_SELECTOR
+    mov   ds, ax
+    mov   es, ax
+    mov   fs, ax
+    mov   ax, PERCPU_SELECTOR
+    mov   gs, ax
+    cld
+    sti                             ; the frame is saved, interrupts may nest from here on
+
+    push  esp                       ; struct interrupt_frame *
+    call  syscall_sysenter
+    add   esp, 4
+    cli                             ; sysexit needs the frame, keep the interrupts off until then
+
+    pop   gs
+    pop   fs
+    pop   es
+    pop   ds
+    popad
+    add   esp, 8                    ; the interrupt number and the error code
+
+    ; sysexit continues at edx with the stack pointer ecx, both taken from the frame
+    mov   edx, [esp]                ; eip
+    mov   ecx, [esp + 12]           ; user_esp
+    sti                             ; takes effect after the next instruction, no interrupt arrives before sysexit
+    sysexit
+
+; user_switch - Enters user mode, see user_enter. Saves the callee-saved registers and eflags, and stores the stack
+; pointer after them as esp0 of the thread and of the TSS: the interrupts and system calls from user mode build their
+; frames below it. user_return loads it back and returns from user_switch. Called with the interrupts disabled.
+; stack: [esp + 20] the TSS of the processor
+;        [esp + 16] the address of esp0 of the thread
+;        [esp + 12] the value of eax in user mode
+;        [esp + 8]  the stack pointer of the user code
+;        [esp + 4]  the entry point of the user code
+;        [esp    ]  the return address
+user_switch:
+    push  ebp                       ; save the callee-saved registers and eflags, restored by user_return
+    push  ebx
+    push  esi
+    push  edi
+    pushfd
+
+    mov   eax, [esp + 40]           ; esp0 of the TSS
+    mov   [eax + TSS_ESP0], esp
+    mov   eax, [esp + 36]           ; esp0 of the thread
+    mov   [eax], esp
+
+    mov   ecx, [esp + 24]           ; entry point
+    mov   edx, [esp + 28]           ; user stack pointer
+    mov   eax, [esp + 32]           ; argument
+
+    ; the frame iret pops to change to ring 3
+    push  dword USER_DATA_SELECTOR  ; ss
+    push  edx                       ; esp
+    push  dword USER_EFLAGS         ; eflags
+    push  dword USER_CODE_SELECTOR  ; cs
+    push  ecx                       ; eip
+
+    mov   cx, USER_DATA_SELECTOR
+    mov   ds, cx
+    mov   es, cx
+    mov   fs, cx
+    mov   gs, cx
+
+    ; no kernel values are left in the registers of the user code
+    xor   ebx, ebx
+    xor   ecx, ecx
+    xor   edx, edx
+    xor   esi, esi
+    xor   edi, edi
+    xor   ebp, ebp
+    iret
+
+; user_return - Leaves user mode for good: returns from the user_switch whose esp0 is given, with the given status.
+; Called by the exit system call on the kernel stack below esp0.
+; stack: [esp + 8] the status returned by user_switch
+;        [esp + 4] esp0 stored by user_switch
+;        [esp    ] the return address
+user_return:
+    mov   eax, [esp + 8]            ; status
+    mov   esp, [esp + 4]            ; drop the frames of the system call
+
+    popfd                           ; restore eflags and the callee-saved registers saved by user_switch
+    pop   edi
+    pop   esi
+    pop   ebx
+    pop   ebp
+    ret                             ; return to the caller of user_switch
+
+; user_copy - Copies bytes between user and kernel memory, any of which may fault: int user_copy(dst, src, n).
+; Returns 0, or -1 if an access to user memory faulted and could not be resolved: the page fault handler resumes a
+; fault between user_copy_start and user_copy_end at user_copy_fault (see user_fault_fixup in syscall.c).
+; stack: [esp + 12] the number of bytes
+;        [esp + 8]  the source
+;        [esp + 4]  the destination
+;        [esp    ]  the return address
+user_copy:
+    push  esi
+    push  edi
+    mov   edi, [esp + 12]           ; destination
+    mov   esi, [esp + 16]           ; source
+    mov   ecx, [esp + 20]           ; number of bytes
+user_copy_start:
+    rep movsb
+user_copy_end:
+    xor   eax, eax
+    pop   edi
+    pop   esi
+    ret
+
+user_copy_fault:
+    mov   eax, -1
+    pop   edi
+    pop   esi
+    ret
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "ktime.h"
+#include "../cpu/cpu.h"
+#include "../log/log.h"
+#include "../../include/div64.h"
+#include "../../drivers/rtc/rtc.h"
+#include "../../drivers/timer/pit.h"
+
+/* Kernel time
+ *
+ * The monotonic clock counts the nanoseconds since init_ktime, read from the time stamp counter. The TSC runs at a
+ * frequency the processor does not report, it is measured against the PIT during boot. Cycles are converted with a
+ * multiplication and a shift, ns = cycles * mult >> shift, where mult / 2^shift is the length of a cycle in
+ * nanoseconds; reading the clock takes a rdtsc and a few instructions, no division, no lock and no interrupt.
+ *
+ * A TSC which is not invariant changes its rate with the processor frequency and may stop in deep sleep states. The
+ * clock still uses it, but reports the fact: on such a processor intervals measured across power state changes are
+ * wrong.
+ *
+ * The wall time is the monotonic clock plus the time of the RTC at boot. */
+
+static uint64_t tsc_base;
+static uint32_t tsc_khz;
+static uint32_t tsc_mult;
+static uint32_t tsc_shift;
+static int tsc_invariant;
+static uint64_t boot_real_ns;
+
+/** mul_u64_u32_shr:
+ *  Returns value * mult >> shift, computed without losing the high bits of the 96-bit product.
+ *
+ *  @param shift At most 32
+ */
+static inline uint64_t mul_u64_u32_shr(uint64_t value, uint32_t mult, uint32_t shift) {
+    uint32_t low = (uint32_t) value;
+    uint32_t high = (uint32_t) (value >> 32);
+
+    return (((uint64_t) low * mult) >> shift) + (((uint64_t) high * mult) << (32 - shift));
+}
+
+/** tsc_calibrate:
+ *  Measures the frequency of the TSC. An interrupt or a preempted virtual processor can only make a round longer, so
+ *  the shortest round is the closest to the truth.
+ *
+ *  @return The frequency in kHz
+ */
+static uint32_t tsc_calibrate() {
+    uint64_t best = 0xFFFFFFFFFFFFFFFFULL;
+
+    for (int round = 0; round < KTIME_CALIBRATION_ROUNDS; round++) {
+        uint32_t flags = irq_save();
+        uint64_t start = rdtsc();
+        uint64_t cycles;
+
+        pit_busy_wait(KTIME_CALIBRATION_TIME);
+        cycles = rdtsc() - start;
+        irq_restore(flags);
+
+        if (cycles < best) {
+            best = cycles;
+        }
+    }
+    div64_u32(&best, KTIME_CALIBRATION_TIME / 1000);
+    return (uint32_t) best;
+}
+
+/** tsc_set_conversion:
+ *  Chooses mult and shift for the measured frequency: the largest shift, for precision, whose mult fits into 32 bits.
+ */
+static void tsc_set_conversion() {
+    // With a shift of 0 mult is at most 10^6, the loop always ends.
+    for (tsc_shift = 32;; tsc_shift--) {
+        uint64_t mult = NSEC_PER_MSEC << tsc_shift;
+
+        div64_u32(&mult, tsc_khz);
+        if (mult <= 0xFFFFFFFF) {
+            tsc_mult = (uint32_t) mult;
+            return;
+        }
+    }
+}
+
+/** init_ktime:
+ *  Calibrates the time stamp counter, starts the monotonic clock and reads the wall time from the RTC.
+ *
+ *  @return 0 on success, -1 if the processor has no TSC
+ */
+int init_ktime() {
+    struct rtc_time now;
+
+    if (!cpu_has_feature(CPU_FEATURE_TSC)) {
+        log_error("No time stamp counter, the kernel clock stands still");
+        return -1;
+    }
+
+    tsc_invariant = cpu_has_invariant_tsc();
+    tsc_khz = tsc_calibrate();
+    if (tsc_khz == 0) {
+        log_error("TSC calibration failed, the kernel clock stands still");
+        return -1;
+    }
+    tsc_set_conversion();
+    tsc_base = rdtsc();
+
+    rtc_read(&now);
+    boot_real_ns = rtc_to_unix(&now) * NSEC_PER_SEC;
+
+    log_info("TSC: %u kHz, %s", tsc_khz, tsc_invariant ? "invariant" : "not invariant, may drift");
+    log_info("Wall time: %u-%02u-%02u %02u:%02u:%02u UTC", now.year, now.month, now.day, now.hour, now.minute, now.second);
+    return 0;
+}
+
+/** ktime_get_ns:
+ *  Returns the nanoseconds since the clock was started, 0 before.
+ */
+uint64_t ktime_get_ns() {
+    if (tsc_mult == 0) {
+        return 0;
+    }
+    return mul_u64_u32_shr(rdtsc() - tsc_base, tsc_mult, tsc_shift);
+}
+
+/** ktime_get_real_ns:
+ *  Returns the wall time, in nanoseconds since 1970-01-01 00:00:00 UTC. Resolution of the monotonic clock, accuracy
+ *  of the RTC at boot.
+ */
+uint64_t ktime_get_real_ns() {
+    return boot_real_ns + ktime_get_ns();
+}
+
+/** ktime_cycles_to_ns:
+ *  Converts a number of TSC cycles, e.g. the difference of two rdtsc, to nanoseconds.
+ */
+uint64_t ktime_cycles_to_ns(uint64_t cycles) {
+    return mul_u64_u32_shr(cycles, tsc_mult, tsc_shift);
+}
+
+/** ktime_get_tsc_khz:
+ *  Returns the measured frequency of the time stamp counter, 0 if it is not calibrated.
+ */
+uint32_t ktime_get_tsc_khz() {
+    return tsc_khz;
+}
+
+/** ktime_tsc_invariant:
+ *  Checks whether the clock runs on an invariant TSC.
+ */
+int ktime_tsc_invariant() {
+    return tsc_invariant;
+}
\ No newline at end of file
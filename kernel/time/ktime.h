@@ -0,0 +1,21 @@
+#ifndef __KTIME_H__
+#define __KTIME_H__
+
+#include "../../include/stdint.h"
+
+#define NSEC_PER_SEC            1000000000ULL
+#define NSEC_PER_MSEC           1000000ULL
+#define NSEC_PER_USEC           1000ULL
+
+// The TSC is calibrated by counting its increments during PIT busy waits, the lowest count of the rounds is taken.
+#define KTIME_CALIBRATION_TIME  10000       /* microseconds */
+#define KTIME_CALIBRATION_ROUNDS 5
+
+int init_ktime();
+uint64_t ktime_get_ns();
+uint64_t ktime_get_real_ns();
+uint64_t ktime_cycles_to_ns(uint64_t cycles);
+uint32_t ktime_get_tsc_khz();
+int ktime_tsc_invariant();
+
+#endif
\ No newline at end of file
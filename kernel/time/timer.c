@@ -0,0 +1,298 @@
+#include "timer.h"
+#include "ktime.h"
+#include "../cpu/cpu.h"
+#include "../log/log.h"
+#include "../sched/sched.h"
+#include "../smp/smp.h"
+#include "../sync/spinlock.h"
+
+/* Timers
+ *
+ * There is no periodic interrupt. Every processor keeps its pending timers in a binary min-heap ordered by deadline,
+ * and the clock event (the local APIC timer, or the PIT) is programmed in one-shot mode for the earliest of them.
+ * Adding or cancelling a timer costs O(log n), and the next deadline is always at the root of the heap.
+ *
+ * The scheduler tick is a timer like any other, which re-arms itself only while the processor has threads to run. An
+ * idle processor with no pending timer takes no timer interrupt at all and sleeps in hlt until a device or another
+ * processor wakes it.
+ *
+ * The heap of a processor is protected by its lock, with the interrupts disabled. The functions of the expired timers
+ * run from the timer interrupt without the lock, so they may add and cancel timers. */
+
+struct timer_base {
+    struct spinlock lock;
+    struct timer *heap[TIMER_HEAP_SIZE];
+    uint32_t count;
+    uint64_t programmed;        // time the clock event will interrupt at, 0 while it is stopped
+};
+
+static struct timer_base timer_bases[SMP_MAX_CPUS];
+static struct clock_event *clock_event;
+
+/** heap_place:
+ *  Stores a timer at a position of the heap.
+ */
+static inline void heap_place(struct timer_base *base, struct timer *timer, uint32_t index) {
+    base->heap[index] = timer;
+    timer->index = index;
+}
+
+/** sift_up:
+ *  Moves the timer at the given position towards the root until its parent expires no later than it does.
+ */
+static void sift_up(struct timer_base *base, uint32_t index) {
+    struct timer *timer = base->heap[index];
+
+    while (index > 0) {
+        uint32_t parent = (index - 1) / 2;
+
+        if (base->heap[parent]->expires <= timer->expires) {
+            break;
+        }
+        heap_place(base, base->heap[parent], index);
+        index = parent;
+    }
+    heap_place(base, timer, index);
+}
+
+/** sift_down:
+ *  Moves the timer at the given position towards the leaves until its children expire no earlier than it does.
+ */
+static void sift_down(struct timer_base *base, uint32_t index) {
+    struct timer *timer = base->heap[index];
+
+    for (;;) {
+        uint32_t child = 2 * index + 1;
+
+        if (child >= base->count) {
+            break;
+        }
+        if (child + 1 < base->count && base->heap[child + 1]->expires < base->heap[child]->expires) {
+            child++;
+        }
+        if (timer->expires <= base->heap[child]->expires) {
+            break;
+        }
+        heap_place(base, base->heap[child], index);
+        index = child;
+    }
+    heap_place(base, timer, index);
+}
+
+/** heap_remove:
+ *  Removes a pending timer from the heap; the last timer takes its place.
+ */
+static void heap_remove(struct timer_base *base, struct timer *timer) {
+    uint32_t index = timer->index;
+    struct timer *last = base->heap[--base->count];
+
+    timer->index = -1;
+    if (last == timer) {
+        return;
+    }
+    heap_place(base, last, index);
+    if (index > 0 && base->heap[(index - 1) / 2]->expires > last->expires) {
+        sift_up(base, index);
+    }
+    else {
+        sift_down(base, index);
+    }
+}
+
+/** program_next:
+ *  Programs the clock event for the earliest pending timer if it would otherwise interrupt later than that, or stops
+ *  it when no timer is pending. Called on the processor of the heap, with its lock held.
+ */
+static void program_next(struct timer_base *base) {
+    uint64_t now;
+    uint64_t delta;
+
+    if (clock_event == 0) {
+        return;
+    }
+    if (base->count == 0) {
+        if (base->programmed) {
+            clock_event->stop();
+            base->programmed = 0;
+        }
+        return;
+    }
+    if (base->programmed && base->programmed <= base->heap[0]->expires) {
+        return;
+    }
+
+    now = ktime_get_ns();
+    delta = base->heap[0]->expires > now ? base->heap[0]->expires - now : 0;
+    if (delta < clock_event->min_delta) {
+        delta = clock_event->min_delta;
+    }
+    // A deadline beyond the reach of the clock event is approached in steps.
+    if (delta > clock_event->max_delta) {
+        delta = clock_event->max_delta;
+    }
+    clock_event->program(delta);
+    base->programmed = now + delta;
+}
+
+/** timer_set_clock_event:
+ *  Selects the interrupt source the timers are programmed on, and programs it for the timers already pending on the
+ *  running processor. Called once during boot, by the driver of the source.
+ */
+void timer_set_clock_event(struct clock_event *event) {
+    struct timer_base *base;
+    uint32_t flags = irq_save();
+
+    clock_event = event;
+    base = &timer_bases[this_cpu()->id];
+    spin_lock(&base->lock);
+    program_next(base);
+    spin_unlock(&base->lock);
+    irq_restore(flags);
+
+    log_info("Timer: %s clock event, one-shot", event->name);
+}
+
+/** timer_init:
+ *  Initializes a timer, which is not pending.
+ *
+ *  @param timer    The timer
+ *  @param function Function run once the timer expires, from the timer interrupt
+ *  @param data     Free for the function to use
+ */
+void timer_init(struct timer *timer, void (*function)(struct timer *), void *data) {
+    timer->expires = 0;
+    timer->function = function;
+    timer->data = data;
+    timer->index = -1;
+    timer->cpu = 0;
+}
+
+/** timer_add:
+ *  Starts a timer on the running processor. A pending timer is moved to the new deadline.
+ *
+ *  @param timer   The timer
+ *  @param expires Deadline, kernel time in nanoseconds (see ktime_get_ns). A deadline in the past expires at once.
+ *  @return        0 on success, -1 if too many timers are pending on the processor
+ */
+int timer_add(struct timer *timer, uint64_t expires) {
+    struct timer_base *base;
+    uint32_t flags = irq_save();
+    int result = 0;
+
+    timer_cancel(timer);
+
+    base = &timer_bases[this_cpu()->id];
+    spin_lock(&base->lock);
+    if (base->count == TIMER_HEAP_SIZE) {
+        result = -1;
+    }
+    else {
+        timer->expires = expires;
+        timer->cpu = this_cpu()->id;
+        heap_place(base, timer, base->count++);
+        sift_up(base, timer->index);
+        if (timer->index == 0) {
+            program_next(base);
+        }
+    }
+    spin_unlock(&base->lock);
+    irq_restore(flags);
+
+    return result;
+}
+
+/** timer_cancel:
+ *  Stops a pending timer. The clock event is not reprogrammed, if it interrupts for the cancelled timer the interrupt
+ *  finds nothing to do. A timer whose function already started is not waited for.
+ *
+ *  @return 1 if the timer was pending, 0 otherwise
+ */
+int timer_cancel(struct timer *timer) {
+    struct timer_base *base;
+    uint32_t flags;
+    int pending = 0;
+
+    if (timer->index < 0) {
+        return 0;
+    }
+
+    base = &timer_bases[timer->cpu];
+    flags = spin_lock_irqsave(&base->lock);
+    if (timer->index >= 0) {
+        heap_remove(base, timer);
+        pending = 1;
+    }
+    spin_unlock_irqrestore(&base->lock, flags);
+
+    return pending;
+}
+
+/** timer_pending:
+ *  Checks whether a timer is started and has not expired yet.
+ */
+int timer_pending(struct timer *timer) {
+    return timer->index >= 0;
+}
+
+/** timer_interrupt:
+ *  Runs the functions of the expired timers of the running processor and programs the clock event for the next
+ *  deadline. Called from the interrupt handler of the clock event.
+ */
+void timer_interrupt() {
+    struct timer_base *base = &timer_bases[this_cpu()->id];
+    uint64_t now = ktime_get_ns();
+
+    spin_lock(&base->lock);
+    base->programmed = 0;
+    while (base->count && base->heap[0]->expires <= now) {
+        struct timer *timer = base->heap[0];
+
+        heap_remove(base, timer);
+        spin_unlock(&base->lock);
+        timer->function(timer);
+        spin_lock(&base->lock);
+    }
+    program_next(base);
+    spin_unlock(&base->lock);
+}
+
+// A thread sleeping in timer_sleep
+struct sleeper {
+    struct timer timer;
+    struct thread *thread;
+    volatile int done;
+};
+
+/** sleeper_wake:
+ *  Wakes the thread of an expired sleep timer.
+ */
+static void sleeper_wake(struct timer *timer) {
+    struct sleeper *sleeper = timer->data;
+    struct thread *thread = sleeper->thread;
+
+    // The sleeper may return as soon as done is set, its stack frame must not be touched afterwards.
+    __atomic_store_n(&sleeper->done, 1, __ATOMIC_RELEASE);
+    thread_wake(thread);
+}
+
+/** timer_sleep:
+ *  Blocks the current thread for at least the given time. The processor is free for other threads, or halts.
+ *
+ *  @param nanoseconds The time to sleep
+ */
+void timer_sleep(uint64_t nanoseconds) {
+    struct sleeper sleeper;
+    uint32_t flags;
+
+    sleeper.thread = thread_current();
+    sleeper.done = 0;
+    timer_init(&sleeper.timer, sleeper_wake, &sleeper);
+
+    flags = irq_save();
+    if (timer_add(&sleeper.timer, ktime_get_ns() + nanoseconds) == 0) {
+        while (!__atomic_load_n(&sleeper.done, __ATOMIC_ACQUIRE)) {
+            thread_block();
+        }
+    }
+    irq_restore(flags);
+}
\ No newline at end of file
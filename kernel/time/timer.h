@@ -0,0 +1,35 @@
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+#include "../../include/stdint.h"
+
+// Most timers pending on one processor at a time
+#define TIMER_HEAP_SIZE         128
+
+struct timer {
+    uint64_t expires;                       // deadline, kernel time in nanoseconds
+    void (*function)(struct timer *timer);  // run from the timer interrupt once the deadline passed
+    void *data;
+    int index;                              // position in the heap of its processor, -1 while not pending
+    uint32_t cpu;                           // processor whose heap holds the timer
+};
+
+/* A one-shot interrupt source: program raises a single interrupt on the running processor once the given number of
+ * nanoseconds (min_delta to max_delta) passed, and the interrupt handler calls timer_interrupt. stop cancels it. */
+struct clock_event {
+    const char *name;
+    void (*program)(uint64_t delta);
+    void (*stop)();
+    uint64_t min_delta;
+    uint64_t max_delta;
+};
+
+void timer_set_clock_event(struct clock_event *event);
+void timer_init(struct timer *timer, void (*function)(struct timer *), void *data);
+int timer_add(struct timer *timer, uint64_t expires);
+int timer_cancel(struct timer *timer);
+int timer_pending(struct timer *timer);
+void timer_interrupt();
+void timer_sleep(uint64_t nanoseconds);
+
+#endif
\ No newline at end of file
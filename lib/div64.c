@@ -0,0 +1,30 @@
+#include "../include/div64.h"
+
+/** div64_u32:
+ *  Divides a 64-bit value by a 32-bit divisor in place and returns the remainder. On the i386 the division is done with
+ *  two divl, 64-bit division would otherwise need the helpers of libgcc, which the kernel is not linked with.
+ *
+ *  @param value   The dividend, replaced by the quotient
+ *  @param divisor The divisor, not 0
+ *  @return        The remainder
+ */
+uint32_t div64_u32(uint64_t *value, uint32_t divisor) {
+#if defined(__i386__)
+    uint32_t high = (uint32_t) (*value >> 32);
+    uint32_t low = (uint32_t) *value;
+    uint32_t high_quotient = high / divisor;
+    uint32_t remainder;
+
+    // The remainder of the high half is below the divisor, so the quotient of the second division fits into 32 bits.
+    high %= divisor;
+    asm("divl %4" : "=a"(low), "=d"(remainder) : "0"(low), "1"(high), "rm"(divisor));
+    *value = ((uint64_t) high_quotient << 32) | low;
+
+    return remainder;
+#else
+    uint32_t remainder = (uint32_t) (*value % divisor);
+
+    *value /= divisor;
+    return remainder;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,337 @@
+#include "../include/stdio.h"
+#include "../include/stdint.h"
+#include "../include/string.h"
+#include "../include/div64.h"
+
+/* Formatted output into a buffer, in a single pass over the format string.
+ *
+ * Conversions: %d %i %u %x %X %o %c %s %p %%
+ * Flags:       - (left-justify), 0 (pad with zeros), + and space (sign of positive numbers), # (0x/0 prefix)
+ * Width and precision as numbers or *, length modifiers hh, h, l, ll and z.
+ *
+ * Output beyond the size of the buffer is counted but not stored, like snprintf of the C library. */
+
+#define FLAG_LEFT       0x01
+#define FLAG_ZERO       0x02
+#define FLAG_PLUS       0x04
+#define FLAG_SPACE      0x08
+#define FLAG_ALT        0x10
+#define FLAG_UPPER      0x20
+#define FLAG_POINTER    0x40    // 0x prefix also for 0, %p
+
+// Output position in the destination buffer
+struct printf_buffer {
+    char *buf;
+    size_t size;
+    size_t len;             // characters produced so far, stored or not
+};
+
+/** put_char:
+ *  Appends a character to the buffer if there is room left for it and the terminator.
+ */
+static inline void put_char(struct printf_buffer *out, char c) {
+    if (out->len + 1 < out->size) {
+        out->buf[out->len] = c;
+    }
+    out->len++;
+}
+
+/** put_padding:
+ *  Appends count copies of a character.
+ */
+static void put_padding(struct printf_buffer *out, char c, int count) {
+    while (count-- > 0) {
+        put_char(out, c);
+    }
+}
+
+/** put_number:
+ *  Appends a number with its sign or prefix, padding and precision.
+ *
+ *  @param out       The buffer
+ *  @param value     Absolute value of the number
+ *  @param negative  Whether the number is negative
+ *  @param base      8, 10 or 16
+ *  @param flags     FLAG_*
+ *  @param width     Minimum field width
+ *  @param precision Minimum number of digits, -1 if not given
+ */
+static void put_number(struct printf_buffer *out, uint64_t value, int negative, uint32_t base, int flags, int width,
+                       int precision) {
+    const char *digits = (flags & FLAG_UPPER) ? "0123456789ABCDEF" : "0123456789abcdef";
+    char tmp[24];               // 22 octal digits at most for 64 bits
+    char prefix[2];
+    int length = 0;
+    int prefix_length = 0;
+    int zero = value == 0;
+    int zeros;
+
+    if (value == 0 && precision == 0) {
+        length = 0;             // "%.0d" of 0 prints no digits
+    }
+    else {
+        do {
+            tmp[length++] = digits[div64_u32(&value, base)];
+        } while (value);
+    }
+    zeros = precision > length ? precision - length : 0;
+
+    if (negative) {
+        prefix[prefix_length++] = '-';
+    }
+    else if (flags & FLAG_PLUS) {
+        prefix[prefix_length++] = '+';
+    }
+    else if (flags & FLAG_SPACE) {
+        prefix[prefix_length++] = ' ';
+    }
+    else if ((flags & FLAG_ALT) && base == 16 && (!zero || (flags & FLAG_POINTER))) {
+        prefix[prefix_length++] = '0';
+        prefix[prefix_length++] = (flags & FLAG_UPPER) ? 'X' : 'x';
+    }
+    else if ((flags & FLAG_ALT) && base == 8 && zeros == 0 && (length == 0 || tmp[length - 1] != '0')) {
+        // Only if the digits do not start with a zero already, the precision may provide it.
+        prefix[prefix_length++] = '0';
+    }
+
+    // Zeros up to the precision; without a precision the 0 flag pads the field with zeros after the prefix.
+    if (precision < 0 && (flags & FLAG_ZERO) && !(flags & FLAG_LEFT)) {
+        zeros = width - prefix_length - length;
+    }
+    width -= prefix_length + (zeros > 0 ? zeros : 0) + length;
+
+    if (!(flags & FLAG_LEFT)) {
+        put_padding(out, ' ', width);
+    }
+    for (int i = 0; i < prefix_length; i++) {
+        put_char(out, prefix[i]);
+    }
+    put_padding(out, '0', zeros);
+    while (length) {
+        put_char(out, tmp[--length]);
+    }
+    if (flags & FLAG_LEFT) {
+        put_padding(out, ' ', width);
+    }
+}
+
+/** put_string:
+ *  Appends a string with padding, at most precision characters of it if precision is not negative.
+ */
+static void put_string(struct printf_buffer *out, const char *s, int flags, int width, int precision) {
+    int length;
+
+    if (s == 0) {
+        s = "(null)";
+    }
+    length = precision >= 0 ? (int) strnlen(s, precision) : (int) strlen(s);
+
+    if (!(flags & FLAG_LEFT)) {
+        put_padding(out, ' ', width - length);
+    }
+    for (int i = 0; i < length; i++) {
+        put_char(out, s[i]);
+    }
+    if (flags & FLAG_LEFT) {
+        put_padding(out, ' ', width - length);
+    }
+}
+
+/** vsnprintf:
+ *  Formats a string into a buffer.
+ *
+ *  @param buf    Destination, always null-terminated if size is not 0
+ *  @param size   Size of the destination
+ *  @param format Format string
+ *  @param ap     Arguments
+ *  @return       Length of the formatted string, which was truncated if it is not below size
+ */
+int vsnprintf(char *buf, size_t size, const char *format, va_list ap) {
+    struct printf_buffer out = {buf, size, 0};
+    const char *f = format;
+
+    while (*f) {
+        int flags = 0;
+        int width = 0;
+        int precision = -1;
+        int length = 0;         // number of 'l', or -1/-2 for 'h'/'hh'
+        uint32_t base = 10;
+        uint64_t value;
+        int negative = 0;
+
+        if (*f != '%') {
+            put_char(&out, *f++);
+            continue;
+        }
+        f++;
+
+        // Flags
+        for (;; f++) {
+            if (*f == '-') {
+                flags |= FLAG_LEFT;
+            }
+            else if (*f == '0') {
+                flags |= FLAG_ZERO;
+            }
+            else if (*f == '+') {
+                flags |= FLAG_PLUS;
+            }
+            else if (*f == ' ') {
+                flags |= FLAG_SPACE;
+            }
+            else if (*f == '#') {
+                flags |= FLAG_ALT;
+            }
+            else {
+                break;
+            }
+        }
+
+        // Width
+        if (*f == '*') {
+            width = va_arg(ap, int);
+            if (width < 0) {
+                flags |= FLAG_LEFT;
+                width = -width;
+            }
+            f++;
+        }
+        else {
+            while (*f >= '0' && *f <= '9') {
+                width = width * 10 + (*f++ - '0');
+            }
+        }
+
+        // Precision
+        if (*f == '.') {
+            f++;
+            precision = 0;
+            if (*f == '*') {
+                precision = va_arg(ap, int);
+                f++;
+            }
+            else {
+                while (*f >= '0' && *f <= '9') {
+                    precision = precision * 10 + (*f++ - '0');
+                }
+            }
+        }
+
+        // Length modifier
+        for (;; f++) {
+            if (*f == 'l') {
+                length++;
+            }
+            else if (*f == 'h') {
+                length--;
+            }
+            else if (*f == 'z') {
+                length = 1;     // size_t is an unsigned long
+            }
+            else {
+                break;
+            }
+        }
+
+        switch (*f) {
+            case 'c':
+                put_padding(&out, ' ', (flags & FLAG_LEFT) ? 0 : width - 1);
+                put_char(&out, (char) va_arg(ap, int));
+                put_padding(&out, ' ', (flags & FLAG_LEFT) ? width - 1 : 0);
+                break;
+            case 's':
+                put_string(&out, va_arg(ap, const char *), flags, width, precision);
+                break;
+            case 'p':
+                put_number(&out, (unsigned long) va_arg(ap, void *), 0, 16, flags | FLAG_ALT | FLAG_POINTER, width,
+                           precision);
+                break;
+            case 'd':
+            case 'i': {
+                int64_t number;
+
+                if (length >= 2) {
+                    number = va_arg(ap, long long);
+                }
+                else if (length == 1) {
+                    number = va_arg(ap, long);
+                }
+                else {
+                    number = va_arg(ap, int);
+                    if (length == -1) {
+                        number = (short) number;
+                    }
+                    else if (length <= -2) {
+                        number = (signed char) number;
+                    }
+                }
+                negative = number < 0;
+                value = negative ? -(uint64_t) number : (uint64_t) number;
+                put_number(&out, value, negative, 10, flags, width, precision);
+                break;
+            }
+            case 'X':
+                flags |= FLAG_UPPER;
+                // fall through
+            case 'x':
+            case 'o':
+            case 'u':
+                if (*f == 'x' || *f == 'X') {
+                    base = 16;
+                }
+                else if (*f == 'o') {
+                    base = 8;
+                }
+
+                if (length >= 2) {
+                    value = va_arg(ap, unsigned long long);
+                }
+                else if (length == 1) {
+                    value = va_arg(ap, unsigned long);
+                }
+                else {
+                    value = va_arg(ap, unsigned int);
+                    if (length == -1) {
+                        value = (unsigned short) value;
+                    }
+                    else if (length <= -2) {
+                        value = (unsigned char) value;
+                    }
+                }
+                put_number(&out, value, 0, base, flags & ~(FLAG_PLUS | FLAG_SPACE), width, precision);
+                break;
+            case '\0':
+                // A lone '%' at the end of the format
+                continue;
+            case '%':
+                put_char(&out, '%');
+                break;
+            default:
+                // Unknown conversions are written as they are.
+                put_char(&out, '%');
+                put_char(&out, *f);
+                break;
+        }
+        f++;
+    }
+
+    if (size) {
+        buf[out.len < size ? out.len : size - 1] = '\0';
+    }
+
+    return out.len;
+}
+
+/** snprintf:
+ *  Formats a string into a buffer, see vsnprintf.
+ */
+int snprintf(char *buf, size_t size, const char *format, ...) {
+    va_list ap;
+    int length;
+
+    va_start(ap, format);
+    length = vsnprintf(buf, size, format, ap);
+    va_end(ap);
+
+    return length;
+}
\ No newline at end of file
@@ -1,21 +1,141 @@
 #include "../include/stddef.h"
+#include "../include/stdint.h"
+#include "../include/string.h"
+
+/* The copy and fill routines move 32-bit words with rep movsd/stosd and only the remaining bytes one at a time.
+ * Copies and fills of at least STRING_LARGE_THRESHOLD bytes are handed to the routines registered with
+ * string_set_large_ops, if any; the kernel registers SSE2 versions at boot when the processor supports them.
+ *
+ * Built for another architecture (make host-lib), the string instructions are replaced by plain loops, so the rest
+ * of the code can be tested and measured on the build machine. */
+
+// A word which may alias any other type, for reading strings a word at a time.
+typedef uint32_t __attribute__((__may_alias__)) string_word_t;
+
+static void *(*large_memcpy)(void *dst, const void *src, size_t n);
+static void *(*large_memset)(void *dest, int value, size_t n);
+
+/** string_set_large_ops:
+ *  Registers the routines used for copies and fills of at least STRING_LARGE_THRESHOLD bytes.
+ *
+ *  @param copy Copies n bytes between non-overlapping blocks, 0 to use rep movsd
+ *  @param fill Fills n bytes, 0 to use rep stosd
+ */
+void string_set_large_ops(void *(*copy)(void *, const void *, size_t), void *(*fill)(void *, int, size_t)) {
+    large_memcpy = copy;
+    large_memset = fill;
+}
 
 /** strlen:
- * Returns the length of the string.
+ * Returns the length of the string. Once the pointer is aligned the string is scanned a word at a time; an aligned
+ * word never crosses a page boundary, so reading past the terminator is harmless.
  *
  * @param s string
  * @return length of string
  */
 size_t strlen(const char *s) {
+    const char *p = s;
+    const string_word_t *w;
+
+    while ((uintptr_t) p & 3) {
+        if (*p == '\0') {
+            return p - s;
+        }
+        p++;
+    }
+
+    // (x - 0x01010101) & ~x & 0x80808080 is non-zero exactly when one of the bytes of x is zero.
+    w = (const string_word_t *) p;
+    while (((*w - 0x01010101) & ~*w & 0x80808080) == 0) {
+        w++;
+    }
+
+    p = (const char *) w;
+    while (*p != '\0') {
+        p++;
+    }
+    return p - s;
+}
+
+/** strnlen:
+ * Returns the length of the string, but at most maxlen. Does not read beyond s[maxlen - 1].
+ *
+ * @param s      string
+ * @param maxlen maximum number of characters to examine
+ * @return length of string, or maxlen if there is no terminator in the first maxlen characters
+ */
+size_t strnlen(const char *s, size_t maxlen) {
     size_t i = 0;
-    while(s[i] != '\0') {
+
+    while (i < maxlen && s[i] != '\0') {
         i++;
     }
     return i;
 }
 
+/** copy_forward:
+ *  Copies n bytes from the start of the blocks up to their end.
+ */
+static inline void copy_forward(void *dst, const void *src, size_t n) {
+#if defined(__i386__)
+    uint32_t ecx, edi, esi;
+
+    asm volatile("rep movsl\n\t"
+                 "movl %[bytes], %%ecx\n\t"
+                 "rep movsb"
+                 : "=&c"(ecx), "=&D"(edi), "=&S"(esi)
+                 : "0"(n >> 2), [bytes] "g"(n & 3), "1"(dst), "2"(src)
+                 : "memory");
+#else
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+
+    while (n--) {
+        *d++ = *s++;
+    }
+#endif
+}
+
+/** copy_backward:
+ *  Copies n bytes from the end of the blocks down to their start, a word at a time and then the odd bytes at the
+ *  start. A plain loop rather than rep movs with the direction flag set: an interrupt or exception arriving inside an
+ *  std ... cld window would run its handler with DF=1, and every rep movs/stos of the handler would run backwards.
+ */
+static inline void copy_backward(void *dst, const void *src, size_t n) {
+    uint8_t *d = (uint8_t *) dst + n;
+    const uint8_t *s = (const uint8_t *) src + n;
+
+    while (n >= sizeof(string_word_t)) {
+        d -= sizeof(string_word_t);
+        s -= sizeof(string_word_t);
+        *(string_word_t *) d = *(const string_word_t *) s;
+        n -= sizeof(string_word_t);
+    }
+    while (n--) {
+        *--d = *--s;
+    }
+}
+
+/** memcpy:
+ * Copies n bytes from src to dst. The blocks must not overlap.
+ *
+ * @param dst Pointer to the destination array where the content is to be copied
+ * @param src Pointer to the source of data to be copied
+ * @param n Number of bytes to copy.
+ * @return dst
+ */
+void *memcpy(void *dst, const void *src, size_t n) {
+    if (n >= STRING_LARGE_THRESHOLD && large_memcpy) {
+        return large_memcpy(dst, src, n);
+    }
+
+    copy_forward(dst, src, n);
+    return dst;
+}
+
 /** memmove:
- * Copies the values of n bytes from dst to src
+ * Copies n bytes from src to dst. The blocks may overlap: when dst lies inside the source block the copy runs
+ * backwards, so that no byte is overwritten before it is copied.
  *
  * @param dst Pointer to the destination array where the content is to be copied
  * @param src Pointer to the source of data to be copied
@@ -23,13 +143,18 @@ size_t strlen(const char *s) {
  * @return dst
  */
 void *memmove(void *dst, const void *src, size_t n) {
-    char *d = (char*) dst;
-    char *s = (char*) src;
+    if ((uintptr_t) dst <= (uintptr_t) src || (uintptr_t) dst >= (uintptr_t) src + n) {
+        if ((uintptr_t) dst + n <= (uintptr_t) src || (uintptr_t) dst >= (uintptr_t) src + n) {
+            return memcpy(dst, src, n);
+        }
 
-    for(size_t i=0; i < n; i++)
-        d[i] = s[i];
+        // Overlapping with dst below src, a forward copy reads every byte before it is overwritten.
+        copy_forward(dst, src, n);
+        return dst;
+    }
 
-    return d;
+    copy_backward(dst, src, n);
+    return dst;
 }
 
 /** memset:
@@ -37,14 +162,59 @@ void *memmove(void *dst, const void *src, size_t n) {
  * @param dest  Pointer to the block of memory to fill.
  * @param value Value to be set.
  * @param n Number of bytes to be set to the value.
- * @return ptr
+ * @return dest
  */
 void *memset(void *dest, int value, size_t n) {
-    char *ptr = (char *)dest;
-    while(n-- > 0) {
-        *ptr++ = value;
+#if defined(__i386__)
+    uint32_t pattern = (uint8_t) value * 0x01010101u;
+    uint32_t ecx, edi;
+#else
+    uint8_t *d = dest;
+#endif
+
+    if (n >= STRING_LARGE_THRESHOLD && large_memset) {
+        return large_memset(dest, value, n);
+    }
+
+#if defined(__i386__)
+    asm volatile("rep stosl\n\t"
+                 "movl %[bytes], %%ecx\n\t"
+                 "rep stosb"
+                 : "=&c"(ecx), "=&D"(edi)
+                 : "0"(n >> 2), [bytes] "g"(n & 3), "1"(dest), "a"(pattern)
+                 : "memory");
+#else
+    while (n--) {
+        *d++ = (uint8_t) value;
+    }
+#endif
+
+    return dest;
+}
+
+/** memcmp:
+ * Compares the first n bytes of two blocks of memory.
+ *
+ * @param s1 Pointer to the first block
+ * @param s2 Pointer to the second block
+ * @param n  Number of bytes to compare
+ * @return 0 if the blocks are equal, otherwise the difference of the first differing bytes (as unsigned char)
+ */
+int memcmp(const void *s1, const void *s2, size_t n) {
+    const uint8_t *a = (const uint8_t *) s1;
+    const uint8_t *b = (const uint8_t *) s2;
+    size_t i = 0;
+
+    // Skip the equal words, the differing word is then compared byte by byte.
+    while (i + 4 <= n && *(const string_word_t *) (a + i) == *(const string_word_t *) (b + i)) {
+        i += 4;
+    }
+    for (; i < n; i++) {
+        if (a[i] != b[i]) {
+            return a[i] - b[i];
+        }
     }
-    return ptr;
+    return 0;
 }
 
 /** itoa:
@@ -68,16 +238,17 @@ char *itoa(int value, char *str, int base) {
     }
 
     char *ptr = str, *ptr1 = str, tmp_char;
-    int tmp_value;
+    int negative = value < 0 && base == 10;
+    // The magnitude, computed without overflow for INT_MIN; the other bases take the bits of value as they are.
+    unsigned int magnitude = negative ? 0u - (unsigned int) value : (unsigned int) value;
 
     do {
-        tmp_value = value;
-        value /= base;
-        *ptr++ = "zyxwvutsrqponmlkjihgfedcba9876543210123456789abcdefghijklmnopqrstuvwxyz" [35 + (tmp_value - value * base)];
-    } while(value);
+        *ptr++ = "0123456789abcdefghijklmnopqrstuvwxyz" [magnitude % base];
+        magnitude /= base;
+    } while(magnitude);
 
     // Apply negative sign
-    if (tmp_value < 0 && base == 10) {
+    if (negative) {
         *ptr++ = '-';
     }
 
@@ -0,0 +1,310 @@
+#include "paging.h"
+#include "../physical/pmm.h"
+#include "../../kernel/cpu/cpu.h"
+#include "../../include/string.h"
+
+/* Paging
+ *
+ * The loader enables paging with a temporary page directory (boot_page_directory in loader.s) which maps the first
+ * 4 MB both at address 0 and at KERNEL_VIRTUAL_BASE, so the kernel can jump to its higher half. init_paging replaces it
+ * with the kernel page directory built here:
+ *
+ *  - The first 4 MB of the direct map, which contain the kernel image, are mapped through a page table, so the
+ *    .text and .rodata sections can be mapped read-only (enforced in ring 0 by CR0.WP).
+ *  - The rest of the direct map uses 4 MB pages (CR4.PSE), so the whole kernel address space is covered by a few
+ *    hundred TLB entries at most and no page tables have to be allocated for it.
+ *  - Every kernel mapping is global (CR4.PGE). The kernel half is the same in every address space, so its TLB entries
+ *    survive CR3 reloads on address space switches.
+ *
+ * The identity mapping of the first 4 MB is dropped, the lower 3 GB are left to user address spaces.
+ *
+ * Above the direct map, the MMIO window takes the uncached mappings of device registers.
+ *
+ * Based on https://wiki.osdev.org/Paging and https://wiki.osdev.org/Higher_Half_x86_Bare_Bones */
+
+// Defined in link.ld, the boundaries of the read-only part of the kernel image (.text and .rodata).
+extern uint32_t kernel_readonly_start;
+extern uint32_t kernel_readonly_end;
+
+static uint32_t kernel_page_directory[1024] __attribute__((aligned(PAGE_SIZE)));
+// Maps the first 4 MB of the direct map, which contain the kernel image.
+static uint32_t kernel_page_table[1024] __attribute__((aligned(PAGE_SIZE)));
+/* Maps the MMIO window. It is part of the kernel page directory from the start, so the address spaces created later
+ * share it and device mappings added at any time are visible in all of them. */
+static uint32_t mmio_page_table[1024] __attribute__((aligned(PAGE_SIZE)));
+static uint32_t mmio_next = KERNEL_MMIO_BASE;
+
+static uint32_t direct_map_end;
+static uint32_t global_flag;
+
+/** ram_top:
+ *  Returns the end of the highest available memory region: the highest of the upper memory size and the memory map,
+ *  of those GRUB provided. 0 if it provided neither.
+ *
+ *  @param mbi The multiboot information structure
+ */
+static uint64_t ram_top(struct multiboot_info *mbi) {
+    uint64_t top = 0;
+
+    // mem_upper is only valid with its flag set.
+    if (mbi->flags & MULTIBOOT_INFO_MEMORY) {
+        top = 0x100000 + (uint64_t) mbi->mem_upper * 1024;
+    }
+
+    if (mbi->flags & MULTIBOOT_INFO_MEM_MAP) {
+        uint32_t entry = (uint32_t) phys_to_virt(mbi->mmap_addr);
+        uint32_t mmap_end = entry + mbi->mmap_length;
+
+        for (; entry < mmap_end; entry += ((struct multiboot_mmap_entry *) entry)->size + sizeof(uint32_t)) {
+            struct multiboot_mmap_entry *region = (struct multiboot_mmap_entry *) entry;
+
+            if (region->type == MULTIBOOT_MEMORY_AVAILABLE && region->addr + region->len > top) {
+                top = region->addr + region->len;
+            }
+        }
+    }
+
+    return top;
+}
+
+/** init_paging:
+ *  Builds the kernel page directory and switches to it.
+ *
+ *  @param mbi The multiboot information structure
+ */
+void init_paging(struct multiboot_info *mbi) {
+    uint32_t readonly_start = virt_to_phys(&kernel_readonly_start);
+    uint32_t readonly_end = virt_to_phys(&kernel_readonly_end);
+    uint64_t top = ram_top(mbi);
+
+    // The direct map covers the memory up to the highest available address, in whole 4 MB pages.
+    if (top > KERNEL_DIRECT_MAP_SIZE) {
+        top = KERNEL_DIRECT_MAP_SIZE;
+    }
+    direct_map_end = ((uint32_t) top + LARGE_PAGE_SIZE - 1) & ~(LARGE_PAGE_SIZE - 1);
+    if (direct_map_end == 0) {
+        direct_map_end = LARGE_PAGE_SIZE;
+    }
+
+    if (cpu_has_feature(CPU_FEATURE_PGE)) {
+        global_flag = PTE_GLOBAL;
+    }
+
+    memset(kernel_page_directory, 0, sizeof(kernel_page_directory));
+
+    for (uint32_t i = 0; i < 1024; i++) {
+        uint32_t address = i * PAGE_SIZE;
+        uint32_t flags = PTE_PRESENT | global_flag;
+
+        if (address < readonly_start || address >= readonly_end) {
+            flags |= PTE_WRITABLE;
+        }
+        kernel_page_table[i] = address | flags;
+    }
+    kernel_page_directory[KERNEL_PDE_INDEX] = virt_to_phys(kernel_page_table) | PTE_PRESENT | PTE_WRITABLE;
+
+    for (uint32_t address = LARGE_PAGE_SIZE; address < direct_map_end; address += LARGE_PAGE_SIZE) {
+        kernel_page_directory[KERNEL_PDE_INDEX + (address >> 22)] =
+                address | PTE_PRESENT | PTE_WRITABLE | PTE_LARGE | global_flag;
+    }
+
+    memset(mmio_page_table, 0, sizeof(mmio_page_table));
+    kernel_page_directory[KERNEL_MMIO_BASE >> 22] = virt_to_phys(mmio_page_table) | PTE_PRESENT | PTE_WRITABLE;
+
+    paging_init_cpu();
+    paging_switch_directory(kernel_page_directory);
+}
+
+/** paging_init_cpu:
+ *  Sets the paging controls of the running processor. init_paging does it for the bootstrap processor.
+ */
+void paging_init_cpu() {
+    // Read-only pages must also be read-only for the kernel, and global pages need CR4.PGE.
+    write_cr0(read_cr0() | CR0_WP);
+    write_cr4(read_cr4() | CR4_PSE | (global_flag ? CR4_PGE : 0));
+}
+
+/** paging_direct_map_end:
+ *  Returns the physical address where the direct map ends. Frames below it can be reached through phys_to_virt.
+ */
+uint32_t paging_direct_map_end() {
+    return direct_map_end;
+}
+
+/** paging_kernel_directory:
+ *  Returns the page directory which only maps the kernel.
+ */
+uint32_t *paging_kernel_directory() {
+    return kernel_page_directory;
+}
+
+/** paging_switch_directory:
+ *  Loads the given page directory into CR3. Global TLB entries (the kernel mappings) are kept.
+ *
+ *  @param directory Page directory
+ */
+void paging_switch_directory(uint32_t *directory) {
+    write_cr3(virt_to_phys(directory));
+}
+
+/** paging_create_directory:
+ *  Creates a page directory for a new address space. The user half is empty, the kernel half is shared with the
+ *  kernel page directory. Kernel mappings outside the direct map must therefore be in place before address spaces are
+ *  created.
+ *
+ *  @return The page directory, 0 if the memory is exhausted
+ */
+uint32_t *paging_create_directory() {
+    uint32_t frame = pmm_alloc_frame();
+    uint32_t *directory;
+
+    if (frame == 0) {
+        return 0;
+    }
+
+    directory = phys_to_virt(frame);
+    memset(directory, 0, KERNEL_PDE_INDEX * sizeof(uint32_t));
+    memmove(&directory[KERNEL_PDE_INDEX], &kernel_page_directory[KERNEL_PDE_INDEX],
+            (1024 - KERNEL_PDE_INDEX) * sizeof(uint32_t));
+
+    return directory;
+}
+
+/** paging_destroy_directory:
+ *  Frees a page directory created by paging_create_directory and the page tables of its user half.
+ *
+ *  @param directory Page directory
+ */
+void paging_destroy_directory(uint32_t *directory) {
+    if (directory == kernel_page_directory) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < KERNEL_PDE_INDEX; i++) {
+        if ((directory[i] & PTE_PRESENT) && !(directory[i] & PTE_LARGE)) {
+            pmm_free_frame(directory[i] & PTE_ADDRESS_MASK);
+        }
+    }
+    pmm_free_frame(virt_to_phys(directory));
+}
+
+/** flush_if_active:
+ *  Invalidates the TLB entry of the given address if the page directory is the active one.
+ */
+static void flush_if_active(uint32_t *directory, uint32_t virtual_address) {
+    if (read_cr3() == virt_to_phys(directory) || virtual_address >= KERNEL_VIRTUAL_BASE) {
+        invlpg(virtual_address);
+    }
+}
+
+/** paging_map_page:
+ *  Maps a 4 KB page, allocating the page table if needed.
+ *
+ *  @param directory        Page directory
+ *  @param virtual_address  Virtual address of the page
+ *  @param physical_address Physical address of the page frame
+ *  @param flags            PTE_* flags of the mapping
+ *  @return                 0 on success, -1 if the page table can not be allocated or the address is covered by a
+ *                          4 MB page
+ */
+int paging_map_page(uint32_t *directory, uint32_t virtual_address, uint32_t physical_address, uint32_t flags) {
+    uint32_t pde_index = virtual_address >> 22;
+    uint32_t pte_index = (virtual_address >> 12) & 0x3FF;
+    uint32_t *table;
+
+    if (directory[pde_index] & PTE_LARGE) {
+        return -1;
+    }
+
+    if (!(directory[pde_index] & PTE_PRESENT)) {
+        uint32_t frame = pmm_alloc_frame();
+
+        if (frame == 0) {
+            return -1;
+        }
+        memset(phys_to_virt(frame), 0, PAGE_SIZE);
+        // Access rights are enforced by the page table entries, the directory entry allows everything.
+        directory[pde_index] = frame | PTE_PRESENT | PTE_WRITABLE |
+                               (virtual_address < KERNEL_VIRTUAL_BASE ? PTE_USER : 0);
+    }
+
+    table = phys_to_virt(directory[pde_index] & PTE_ADDRESS_MASK);
+    table[pte_index] = (physical_address & PTE_ADDRESS_MASK) | (flags & ~PTE_ADDRESS_MASK) | PTE_PRESENT;
+    flush_if_active(directory, virtual_address);
+
+    return 0;
+}
+
+/** paging_unmap_page:
+ *  Removes the mapping of a 4 KB page. The page frame itself is not freed.
+ *
+ *  @param directory       Page directory
+ *  @param virtual_address Virtual address of the page
+ */
+void paging_unmap_page(uint32_t *directory, uint32_t virtual_address) {
+    uint32_t pde_index = virtual_address >> 22;
+    uint32_t *table;
+
+    if (!(directory[pde_index] & PTE_PRESENT) || (directory[pde_index] & PTE_LARGE)) {
+        return;
+    }
+
+    table = phys_to_virt(directory[pde_index] & PTE_ADDRESS_MASK);
+    table[(virtual_address >> 12) & 0x3FF] = 0;
+    flush_if_active(directory, virtual_address);
+}
+
+/** paging_get_physical:
+ *  Translates a virtual address with the given page directory.
+ *
+ *  @param directory       Page directory
+ *  @param virtual_address Virtual address
+ *  @return                Physical address, 0 if the address is not mapped
+ */
+uint32_t paging_get_physical(uint32_t *directory, uint32_t virtual_address) {
+    uint32_t pde = directory[virtual_address >> 22];
+    uint32_t pte;
+
+    if (!(pde & PTE_PRESENT)) {
+        return 0;
+    }
+    if (pde & PTE_LARGE) {
+        return (pde & ~(LARGE_PAGE_SIZE - 1)) | (virtual_address & (LARGE_PAGE_SIZE - 1));
+    }
+
+    pte = ((uint32_t *) phys_to_virt(pde & PTE_ADDRESS_MASK))[(virtual_address >> 12) & 0x3FF];
+    if (!(pte & PTE_PRESENT)) {
+        return 0;
+    }
+    return (pte & PTE_ADDRESS_MASK) | (virtual_address & (PAGE_SIZE - 1));
+}
+
+/** paging_map_mmio:
+ *  Maps device memory into the MMIO window, uncached. The mappings are permanent.
+ *
+ *  @param physical_address Physical address of the registers
+ *  @param size             Size of the register block in bytes
+ *  @return                 Virtual address of physical_address, 0 if the window is full
+ */
+void *paging_map_mmio(uint32_t physical_address, uint32_t size) {
+    uint32_t offset = physical_address & (PAGE_SIZE - 1);
+    uint32_t pages = (offset + size + PAGE_SIZE - 1) / PAGE_SIZE;
+    uint32_t virtual_address;
+
+    if (pages > (KERNEL_MMIO_BASE + KERNEL_MMIO_SIZE - mmio_next) / PAGE_SIZE) {
+        return 0;
+    }
+
+    virtual_address = mmio_next;
+    mmio_next += pages * PAGE_SIZE;
+    for (uint32_t i = 0; i < pages; i++) {
+        uint32_t page = virtual_address + i * PAGE_SIZE;
+
+        mmio_page_table[(page >> 12) & 0x3FF] = ((physical_address & PTE_ADDRESS_MASK) + i * PAGE_SIZE) |
+                                                PTE_PRESENT | PTE_WRITABLE | PTE_CACHE_DISABLE |
+                                                PTE_WRITE_THROUGH | global_flag;
+        invlpg(page);
+    }
+
+    return (void *) (virtual_address + offset);
+}
\ No newline at end of file
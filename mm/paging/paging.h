@@ -0,0 +1,58 @@
+#ifndef __PAGING_H__
+#define __PAGING_H__
+
+#include "../../include/stdint.h"
+#include "../../init/multiboot.h"
+
+/* The kernel is linked at KERNEL_VIRTUAL_BASE + 1 MB and loaded at 1 MB. The physical memory from address 0 up to
+ * KERNEL_DIRECT_MAP_SIZE is mapped linearly at KERNEL_VIRTUAL_BASE, so the kernel can reach any frame in that range
+ * by adding the base to its physical address.
+ *
+ * Virtual memory layout:
+ *  0x00000000 - 0xBFFFFFFF  user space
+ *  0xC0000000 - 0xF7FFFFFF  direct map of the physical memory (kernel image, page tables, heap, ...)
+ *  0xF8000000 - 0xF83FFFFF  device memory (MMIO) window
+ *  0xF8400000 - 0xFFFFFFFF  reserved for kernel mappings which are not backed by the direct map */
+#define KERNEL_VIRTUAL_BASE     0xC0000000
+#define KERNEL_DIRECT_MAP_SIZE  0x38000000
+#define KERNEL_PDE_INDEX        (KERNEL_VIRTUAL_BASE >> 22)
+
+#define phys_to_virt(address)   ((void *) ((uint32_t) (address) + KERNEL_VIRTUAL_BASE))
+#define virt_to_phys(address)   ((uint32_t) (address) - KERNEL_VIRTUAL_BASE)
+
+#define LARGE_PAGE_SIZE         0x400000
+
+// Device memory (APIC registers, ...) is mapped uncached into a window above the direct map, see paging_map_mmio.
+#define KERNEL_MMIO_BASE        0xF8000000
+#define KERNEL_MMIO_SIZE        LARGE_PAGE_SIZE
+
+/* Page directory and page table entry flags
+ * Bit:     | 31 .. 12 | 11 10 9 | 8 |  7  | 6 | 5 |  4  |  3  |  2  |  1  | 0 |
+ * Content: | address  |  avail  | G | PS  | D | A | PCD | PWT | U/S | R/W | P |
+ *
+ * PS is only meaningful in a page directory entry, it maps a 4 MB page instead of pointing to a page table. G keeps
+ * the translation in the TLB when CR3 is reloaded, as long as CR4.PGE is set. */
+#define PTE_PRESENT             0x001
+#define PTE_WRITABLE            0x002
+#define PTE_USER                0x004
+#define PTE_WRITE_THROUGH       0x008
+#define PTE_CACHE_DISABLE       0x010
+#define PTE_ACCESSED            0x020
+#define PTE_DIRTY               0x040
+#define PTE_LARGE               0x080
+#define PTE_GLOBAL              0x100
+#define PTE_ADDRESS_MASK        0xFFFFF000
+
+void init_paging(struct multiboot_info *mbi);
+void paging_init_cpu();
+uint32_t *paging_kernel_directory();
+uint32_t *paging_create_directory();
+void paging_destroy_directory(uint32_t *directory);
+void paging_switch_directory(uint32_t *directory);
+int paging_map_page(uint32_t *directory, uint32_t virtual_address, uint32_t physical_address, uint32_t flags);
+void paging_unmap_page(uint32_t *directory, uint32_t virtual_address);
+uint32_t paging_get_physical(uint32_t *directory, uint32_t virtual_address);
+uint32_t paging_direct_map_end();
+void *paging_map_mmio(uint32_t physical_address, uint32_t size);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,539 @@
+#include "pmm.h"
+#include "../paging/paging.h"
+#include "../../kernel/sync/spinlock.h"
+#include "../../kernel/log/log.h"
+#include "../../kernel/module/module.h"
+#include "../../include/string.h"
+
+/* Physical Memory Manager
+ *
+ * Page frames are handed out by a binary buddy allocator. Free memory is kept as naturally aligned blocks of 2^order
+ * frames, one free list per order. Allocating a block takes the first block of the smallest order that fits and splits
+ * it in halves until it has the requested size; freeing a block merges it with its buddy (the other half of the
+ * parent block) as long as the buddy is free as well. Both operations touch at most PMM_MAX_ORDER + 1 lists, so they
+ * stay O(log n) no matter how much memory the machine has.
+ *
+ * The memory is split in two zones with their own free lists. The normal zone is the memory covered by the direct map
+ * of the kernel (see mm/paging/paging.h), the kernel can access it through phys_to_virt. The highmem zone is the rest,
+ * it can only be accessed through a mapping, which makes it suitable for user pages. The boundary is 4 MB aligned, so
+ * a block and its buddy are always in the same zone.
+ *
+ * The free lists of both zones are protected by pmm_lock.
+ *
+ * Based on https://www.kernel.org/doc/gorman/html/understand/understand009.html */
+
+// Defined in link.ld, the addresses of these symbols are the boundaries of the kernel image.
+extern uint32_t kernel_physical_start;
+extern uint32_t kernel_physical_end;
+
+// Memory below 1 MB is used by the BIOS, GRUB and memory-mapped I/O, it is never handed out.
+#define PMM_LOW_MEMORY_END      0x100000
+
+// Memory ranges that must not be handed out even though the memory map reports them as available: low memory, the
+// kernel image and the page frame descriptors, plus one range per module.
+#define PMM_FIXED_RESERVED_RANGES   3
+#define PMM_MAX_RESERVED_RANGES     (PMM_FIXED_RESERVED_RANGES + MODULE_MAX_COUNT)
+
+struct pmm_range {
+    uint32_t start;     // first frame number of the range
+    uint32_t end;       // frame number after the last frame of the range
+};
+
+// Descriptors of all the page frames, indexed by frame number.
+static struct page *page_array;
+static uint32_t page_count;
+
+struct pmm_zone {
+    struct page *free_lists[PMM_MAX_ORDER + 1];
+    uint32_t free_frames;
+    uint32_t total_frames;
+};
+
+static struct pmm_zone zones[PMM_ZONE_COUNT];
+// Frame number of the first frame of the highmem zone
+static uint32_t highmem_start;
+
+static struct pmm_range reserved_ranges[PMM_MAX_RESERVED_RANGES];
+static int reserved_range_count;
+static struct spinlock pmm_lock = SPINLOCK_INIT;
+
+/** page_to_phys:
+ *  Returns the physical address of the page frame described by the given descriptor.
+ *
+ *  @param page Page frame descriptor
+ *  @return     Physical address of the page frame
+ */
+uint32_t page_to_phys(struct page *page) {
+    return (uint32_t) (page - page_array) << PAGE_SHIFT;
+}
+
+/** phys_to_page:
+ *  Returns the descriptor of the page frame that contains the given physical address.
+ *
+ *  @param address  Physical address
+ *  @return         Page frame descriptor, 0 if the address is beyond the managed memory
+ */
+struct page *phys_to_page(uint32_t address) {
+    uint32_t pfn = address >> PAGE_SHIFT;
+
+    if (pfn >= page_count) {
+        return 0;
+    }
+    return &page_array[pfn];
+}
+
+/** zone_of:
+ *  Returns the zone which contains the given frame.
+ *
+ *  @param pfn Frame number
+ */
+static struct pmm_zone *zone_of(uint32_t pfn) {
+    return &zones[pfn < highmem_start ? PMM_ZONE_NORMAL : PMM_ZONE_HIGHMEM];
+}
+
+/** free_list_push:
+ *  Puts the given block at the head of the free list of the given order.
+ *
+ *  @param zone  Zone of the block
+ *  @param page  First frame of the block
+ *  @param order Order of the block
+ */
+static void free_list_push(struct pmm_zone *zone, struct page *page, unsigned int order) {
+    page->flags = PAGE_FREE;
+    page->order = order;
+    page->prev = 0;
+    page->next = zone->free_lists[order];
+    if (zone->free_lists[order]) {
+        zone->free_lists[order]->prev = page;
+    }
+    zone->free_lists[order] = page;
+}
+
+/** free_list_remove:
+ *  Unlinks the given block from the free list of the given order.
+ *
+ *  @param zone  Zone of the block
+ *  @param page  First frame of the block
+ *  @param order Order of the block
+ */
+static void free_list_remove(struct pmm_zone *zone, struct page *page, unsigned int order) {
+    if (page->prev) {
+        page->prev->next = page->next;
+    }
+    else {
+        zone->free_lists[order] = page->next;
+    }
+    if (page->next) {
+        page->next->prev = page->prev;
+    }
+    page->next = 0;
+    page->prev = 0;
+    page->flags &= ~PAGE_FREE;
+}
+
+/** free_block:
+ *  Returns a block to the allocator, merging it with its buddies as long as they are free.
+ *
+ *  @param pfn   Frame number of the first frame of the block
+ *  @param order Order of the block
+ */
+static void free_block(uint32_t pfn, unsigned int order) {
+    struct pmm_zone *zone = zone_of(pfn);
+
+    zone->free_frames += 1 << order;
+
+    while (order < PMM_MAX_ORDER) {
+        uint32_t buddy_pfn = pfn ^ (1 << order);
+        struct page *buddy;
+
+        if (buddy_pfn >= page_count) {
+            break;
+        }
+        buddy = &page_array[buddy_pfn];
+        if (!(buddy->flags & PAGE_FREE) || buddy->order != order) {
+            break;
+        }
+
+        // The buddy is free, take it off its list and continue with the merged block.
+        free_list_remove(zone, buddy, order);
+        pfn &= ~(1 << order);
+        order++;
+    }
+
+    free_list_push(zone, &page_array[pfn], order);
+}
+
+/** zone_alloc_pages:
+ *  Allocates a block of 2^order page frames from the given zone.
+ *
+ *  @param zone  Zone to allocate from
+ *  @param order Order of the block
+ *  @return      Physical address of the block, 0 if there is no free block large enough
+ */
+static uint32_t zone_alloc_pages(struct pmm_zone *zone, unsigned int order) {
+    unsigned int current_order = order;
+    struct page *page;
+    uint32_t flags;
+
+    if (order > PMM_MAX_ORDER) {
+        return 0;
+    }
+
+    flags = spin_lock_irqsave(&pmm_lock);
+
+    // Find the smallest free block that is large enough.
+    while (current_order <= PMM_MAX_ORDER && zone->free_lists[current_order] == 0) {
+        current_order++;
+    }
+    if (current_order > PMM_MAX_ORDER) {
+        spin_unlock_irqrestore(&pmm_lock, flags);
+        return 0;
+    }
+
+    page = zone->free_lists[current_order];
+    free_list_remove(zone, page, current_order);
+
+    // Split the block in halves, putting the upper halves back to the free lists, until it has the requested size.
+    while (current_order > order) {
+        current_order--;
+        free_list_push(zone, page + (1 << current_order), current_order);
+    }
+
+    page->flags = 0;
+    page->order = order;
+    page->private = 0;
+    zone->free_frames -= 1 << order;
+
+    spin_unlock_irqrestore(&pmm_lock, flags);
+    return page_to_phys(page);
+}
+
+/** pmm_alloc_pages:
+ *  Allocates a physically contiguous block of 2^order page frames from the normal zone. The block is aligned to its
+ *  own size and can be accessed through phys_to_virt.
+ *
+ *  @param order Order of the block
+ *  @return      Physical address of the block, 0 if there is no free block large enough
+ */
+uint32_t pmm_alloc_pages(unsigned int order) {
+    return zone_alloc_pages(&zones[PMM_ZONE_NORMAL], order);
+}
+
+/** pmm_alloc_highmem_frame:
+ *  Allocates a single page frame, preferring the highmem zone to keep the direct-mapped memory for the kernel. The
+ *  frame is only guaranteed to be accessible through a mapping, which makes it suitable for user pages.
+ *
+ *  @return Physical address of the page frame, 0 if the memory is exhausted
+ */
+uint32_t pmm_alloc_highmem_frame() {
+    uint32_t address = zone_alloc_pages(&zones[PMM_ZONE_HIGHMEM], 0);
+
+    if (address == 0) {
+        address = zone_alloc_pages(&zones[PMM_ZONE_NORMAL], 0);
+    }
+    return address;
+}
+
+/** pmm_free_pages:
+ *  Frees a block allocated by pmm_alloc_pages.
+ *
+ *  @param address Physical address of the block
+ *  @param order   Order the block was allocated with
+ */
+void pmm_free_pages(uint32_t address, unsigned int order) {
+    struct page *page = phys_to_page(address);
+    uint32_t flags;
+
+    if (page == 0 || order > PMM_MAX_ORDER || (address & ((PAGE_SIZE << order) - 1))) {
+        return;
+    }
+
+    flags = spin_lock_irqsave(&pmm_lock);
+    // Ignore addresses which were never handed out, and blocks which are already free.
+    if (!(page->flags & (PAGE_FREE | PAGE_RESERVED))) {
+        free_block(address >> PAGE_SHIFT, order);
+    }
+    spin_unlock_irqrestore(&pmm_lock, flags);
+}
+
+/** pmm_alloc_frame:
+ *  Allocates a single page frame.
+ *
+ *  @return Physical address of the page frame, 0 if the memory is exhausted
+ */
+uint32_t pmm_alloc_frame() {
+    return pmm_alloc_pages(0);
+}
+
+/** pmm_free_frame:
+ *  Frees a page frame allocated by pmm_alloc_frame.
+ *
+ *  @param address Physical address of the page frame
+ */
+void pmm_free_frame(uint32_t address) {
+    pmm_free_pages(address, 0);
+}
+
+/** pmm_free_frame_count:
+ *  Returns the number of free page frames.
+ */
+uint32_t pmm_free_frame_count() {
+    return zones[PMM_ZONE_NORMAL].free_frames + zones[PMM_ZONE_HIGHMEM].free_frames;
+}
+
+/** pmm_total_frame_count:
+ *  Returns the number of page frames managed by the allocator.
+ */
+uint32_t pmm_total_frame_count() {
+    return zones[PMM_ZONE_NORMAL].total_frames + zones[PMM_ZONE_HIGHMEM].total_frames;
+}
+
+/** pmm_zone_free_frame_count:
+ *  Returns the number of free page frames in the given zone.
+ *
+ *  @param zone PMM_ZONE_NORMAL or PMM_ZONE_HIGHMEM
+ */
+uint32_t pmm_zone_free_frame_count(int zone) {
+    return zones[zone].free_frames;
+}
+
+/** pmm_reserve_range:
+ *  Marks a physical memory range which must never be handed out. Must be called before the free memory is added.
+ *  Once the table is full, the range which grows least is widened to cover the new one as well: that keeps memory
+ *  back which could have been used, but never hands out memory which is in use.
+ *
+ *  @param start Physical address of the start of the range
+ *  @param end   Physical address of the end of the range
+ */
+static void pmm_reserve_range(uint32_t start, uint32_t end) {
+    uint32_t first = start >> PAGE_SHIFT;
+    uint32_t last = (end + PAGE_SIZE - 1) >> PAGE_SHIFT;
+    struct pmm_range *range;
+
+    if (reserved_range_count == PMM_MAX_RESERVED_RANGES) {
+        uint32_t best_growth = 0xFFFFFFFF;
+
+        range = &reserved_ranges[0];
+        for (int i = 0; i < reserved_range_count; i++) {
+            uint32_t low = first < reserved_ranges[i].start ? first : reserved_ranges[i].start;
+            uint32_t high = last > reserved_ranges[i].end ? last : reserved_ranges[i].end;
+            uint32_t growth = (high - low) - (reserved_ranges[i].end - reserved_ranges[i].start);
+
+            if (growth < best_growth) {
+                best_growth = growth;
+                range = &reserved_ranges[i];
+            }
+        }
+        log_error("PMM: reserved ranges full, widening 0x%x-0x%x to cover 0x%x-0x%x", range->start << PAGE_SHIFT,
+                  range->end << PAGE_SHIFT, start, end);
+        if (first < range->start) {
+            range->start = first;
+        }
+        if (last > range->end) {
+            range->end = last;
+        }
+        return;
+    }
+    range = &reserved_ranges[reserved_range_count++];
+    range->start = first;
+    range->end = last;
+}
+
+/** pmm_free_range:
+ *  Hands the given frames to the buddy allocator, in the largest naturally aligned blocks that fit in the range.
+ *
+ *  @param start First frame number of the range
+ *  @param end   Frame number after the last frame of the range
+ */
+static void pmm_free_range(uint32_t start, uint32_t end) {
+    while (start < end) {
+        unsigned int order = PMM_MAX_ORDER;
+
+        while (order > 0 && ((start & ((1 << order) - 1)) || start + (1 << order) > end)) {
+            order--;
+        }
+
+        for (uint32_t pfn = start; pfn < start + (1 << order); pfn++) {
+            page_array[pfn].flags = 0;
+        }
+        zone_of(start)->total_frames += 1 << order;
+        free_block(start, order);
+        start += 1 << order;
+    }
+}
+
+/** pmm_add_range:
+ *  Adds the available frames of the given range, skipping the reserved ranges.
+ *
+ *  @param start First frame number of the range
+ *  @param end   Frame number after the last frame of the range
+ */
+static void pmm_add_range(uint32_t start, uint32_t end) {
+    if (start >= end) {
+        return;
+    }
+
+    for (int i = 0; i < reserved_range_count; i++) {
+        struct pmm_range *range = &reserved_ranges[i];
+
+        if (range->start < end && range->end > start) {
+            if (range->start > start) {
+                pmm_add_range(start, range->start);
+            }
+            if (range->end < end) {
+                pmm_add_range(range->end, end);
+            }
+            return;
+        }
+    }
+
+    pmm_free_range(start, end);
+}
+
+/** region_bounds:
+ *  Clips a memory map entry to the 32-bit physical address space and to whole page frames.
+ *
+ *  @param entry Memory map entry
+ *  @param start Set to the first frame number of the region
+ *  @param end   Set to the frame number after the last frame of the region
+ */
+static void region_bounds(struct multiboot_mmap_entry *entry, uint32_t *start, uint32_t *end) {
+    uint64_t first = entry->addr;
+    uint64_t last = entry->addr + entry->len;
+
+    if (first > 0x100000000ULL) {
+        first = 0x100000000ULL;
+    }
+    if (last > 0x100000000ULL) {
+        last = 0x100000000ULL;
+    }
+
+    *start = (uint32_t) ((first + PAGE_SIZE - 1) >> PAGE_SHIFT);
+    *end = (uint32_t) (last >> PAGE_SHIFT);
+}
+
+/** next_mmap_entry:
+ *  Returns the memory map entry following the given one.
+ */
+static struct multiboot_mmap_entry *next_mmap_entry(struct multiboot_mmap_entry *entry) {
+    return (struct multiboot_mmap_entry *) ((uint32_t) entry + entry->size + sizeof(entry->size));
+}
+
+/** place_page_array:
+ *  Finds room for the page frame descriptors in the available memory of the normal zone, outside the reserved ranges
+ *  (the kernel image, the modules, ...).
+ *
+ *  @param mmap_start First entry of the memory map
+ *  @param mmap_end   End of the memory map
+ *  @param size       Size of the descriptor array in bytes
+ *  @return           Physical address of the array, 0 if there is no room for it
+ */
+static uint32_t place_page_array(struct multiboot_mmap_entry *mmap_start, struct multiboot_mmap_entry *mmap_end,
+                                 uint32_t size) {
+    uint32_t frames = (size + PAGE_SIZE - 1) >> PAGE_SHIFT;
+    struct multiboot_mmap_entry *entry;
+
+    for (entry = mmap_start; entry < mmap_end; entry = next_mmap_entry(entry)) {
+        uint32_t start, end;
+
+        if (entry->type != MULTIBOOT_MEMORY_AVAILABLE) {
+            continue;
+        }
+        region_bounds(entry, &start, &end);
+        // Move past every reserved range the array would overlap, then check the others again.
+        for (int i = 0; i < reserved_range_count; i++) {
+            struct pmm_range *range = &reserved_ranges[i];
+
+            if (start < range->end && start + frames > range->start) {
+                start = range->end;
+                i = -1;
+            }
+        }
+        if (end > highmem_start) {
+            end = highmem_start;
+        }
+        if (start + frames <= end) {
+            return start << PAGE_SHIFT;
+        }
+    }
+
+    return 0;
+}
+
+/** init_pmm:
+ *  Initializes the physical memory manager from the memory map provided by GRUB. Every frame reported as available,
+ *  except the ones below 1 MB and the ones used by the kernel image, the modules and the page frame descriptors, is
+ *  handed to the buddy allocator.
+ *
+ *  @param mbi The multiboot information structure
+ */
+void init_pmm(struct multiboot_info *mbi) {
+    struct multiboot_mmap_entry *entry;
+    struct multiboot_mmap_entry *mmap_start = phys_to_virt(mbi->mmap_addr);
+    struct multiboot_mmap_entry *mmap_end = phys_to_virt(mbi->mmap_addr + mbi->mmap_length);
+    struct multiboot_mmap_entry fallback;
+    uint32_t array_address, array_size;
+
+    /* Without a memory map, fall back to the upper memory size, which describes the memory starting at 1 MB up to
+     * the first memory hole. */
+    if (!(mbi->flags & MULTIBOOT_INFO_MEM_MAP)) {
+        if (!(mbi->flags & MULTIBOOT_INFO_MEMORY)) {
+            return;
+        }
+        fallback.size = sizeof(fallback) - sizeof(fallback.size);
+        fallback.addr = PMM_LOW_MEMORY_END;
+        fallback.len = (uint64_t) mbi->mem_upper * 1024;
+        fallback.type = MULTIBOOT_MEMORY_AVAILABLE;
+        mmap_start = &fallback;
+        mmap_end = &fallback + 1;
+    }
+
+    // The descriptor array covers every frame up to the end of the highest available region.
+    page_count = 0;
+    for (entry = mmap_start; entry < mmap_end; entry = next_mmap_entry(entry)) {
+        uint32_t start, end;
+
+        region_bounds(entry, &start, &end);
+        if (entry->type == MULTIBOOT_MEMORY_AVAILABLE && end > page_count) {
+            page_count = end;
+        }
+    }
+
+    pmm_reserve_range(0, PMM_LOW_MEMORY_END);
+    pmm_reserve_range((uint32_t) &kernel_physical_start, (uint32_t) &kernel_physical_end);
+    // The modules GRUB loaded stay where they are, their users read them in place.
+    if (mbi->flags & MULTIBOOT_INFO_MODS) {
+        struct multiboot_module *modules = phys_to_virt(mbi->mods_addr);
+
+        for (uint32_t i = 0; i < mbi->mods_count; i++) {
+            pmm_reserve_range(modules[i].mod_start, modules[i].mod_end);
+        }
+    }
+
+    highmem_start = paging_direct_map_end() >> PAGE_SHIFT;
+    array_size = page_count * sizeof(struct page);
+    array_address = place_page_array(mmap_start, mmap_end, array_size);
+    if (array_address == 0) {
+        page_count = 0;
+        return;
+    }
+
+    // Every frame starts as reserved, the available ones are released below.
+    page_array = phys_to_virt(array_address);
+    memset(page_array, 0, array_size);
+    for (uint32_t pfn = 0; pfn < page_count; pfn++) {
+        page_array[pfn].flags = PAGE_RESERVED;
+    }
+
+    pmm_reserve_range(array_address, array_address + array_size);
+
+    for (entry = mmap_start; entry < mmap_end; entry = next_mmap_entry(entry)) {
+        uint32_t start, end;
+
+        if (entry->type != MULTIBOOT_MEMORY_AVAILABLE) {
+            continue;
+        }
+        region_bounds(entry, &start, &end);
+        pmm_add_range(start, end);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef __PMM_H__
+#define __PMM_H__
+
+#include "../../include/stdint.h"
+#include "../../init/multiboot.h"
+
+#define PAGE_SIZE           4096
+#define PAGE_SHIFT          12
+
+/* The largest block handed out by the buddy allocator is 2^PMM_MAX_ORDER pages (4 MB), which is also the size of a
+ * large page, so the biggest blocks can be mapped with a single page directory entry. */
+#define PMM_MAX_ORDER       10
+
+// Zones of the physical memory
+#define PMM_ZONE_NORMAL     0       /* Memory covered by the direct map of the kernel */
+#define PMM_ZONE_HIGHMEM    1       /* Memory above the direct map */
+#define PMM_ZONE_COUNT      2
+
+// Flags of a page frame descriptor
+#define PAGE_FREE           0x01    /* First frame of a block which sits on a free list */
+#define PAGE_RESERVED       0x02    /* Frame is not managed by the allocator (hole, BIOS, kernel image, ...) */
+#define PAGE_SLAB           0x04    /* Frame belongs to a slab, private points to the slab */
+#define PAGE_KMALLOC        0x08    /* First frame of a block allocated by kmalloc */
+
+/* Every physical page frame below the highest usable address is described by a struct page. Only the first frame of
+ * a free block carries meaningful PAGE_FREE/order values; the allocator finds the buddy of a block by flipping the
+ * order bit of its frame number and looking at the descriptor of that frame. The owner of an allocated frame may use
+ * private to find its own bookkeeping from the frame. */
+struct page {
+    struct page *next;
+    struct page *prev;
+    uint16_t flags;
+    uint16_t order;
+    void *private;
+};
+
+void init_pmm(struct multiboot_info *mbi);
+uint32_t pmm_alloc_pages(unsigned int order);
+void pmm_free_pages(uint32_t address, unsigned int order);
+uint32_t pmm_alloc_highmem_frame();
+uint32_t pmm_alloc_frame();
+void pmm_free_frame(uint32_t address);
+uint32_t pmm_free_frame_count();
+uint32_t pmm_total_frame_count();
+uint32_t pmm_zone_free_frame_count(int zone);
+struct page *phys_to_page(uint32_t address);
+uint32_t page_to_phys(struct page *page);
+
+#endif
\ No newline at end of file
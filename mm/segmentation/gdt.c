@@ -1,22 +1,22 @@
 #include "gdt.h"
+#include "../../include/string.h"
+#include "../../kernel/smp/smp.h"
 
 // Defined in gdt_flush.s We use this to properly reload the new segment registers.
 extern void gdt_flush(uint32_t);
 
-/* Our GDT, with 3 entries, and finally our special GDT pointer */
-struct gdt_entry gdt_entries[GDT_ENTRY_COUNT];
-struct gdt gdt_pointer;
-
 /** gdt_set_gate:
  * Creates a GDT entry in the specified index.
  *
+ * @param gdt_entries The GDT
  * @param index The index for the gdt_entry.
  * @param base  The base address for the segment.
  * @param limit The top address the segment.
  * @param access_byte The access byte for the GDT to identify access.
  * @param flags Flags for setting the segment descriptor.
  */
-static void gdt_set_gate(int32_t index, uint32_t base, uint32_t limit, uint8_t access_byte, unsigned flags) {
+static void gdt_set_gate(struct gdt_entry *gdt_entries, int32_t index, uint32_t base, uint32_t limit,
+                         uint8_t access_byte, unsigned flags) {
     gdt_entries[index].base_addr_low        = (base  & 0xFFFF);
     gdt_entries[index].base_addr_middle     = (base >> 16) & 0xFF;
     gdt_entries[index].base_addr_high       = (base >> 24) & 0xFF;
@@ -41,17 +41,29 @@ static void gdt_set_gate(int32_t index, uint32_t base, uint32_t limit, uint8_t a
  * address for the DS data segment after reset initialization is 0. */
 
 /** init_gdt:
- * This function will set up the special GDT pointer, set up the first 3 entries in our GDT, and then finally call
- * gdt_flush() in our assembler file in order to tell the processor where the new GDT is and update the new segment
- * registers */
+ * Sets up the GDT of the bootstrap processor.
+ */
 void init_gdt() {
+    gdt_init_cpu(smp_get_cpu(0));
+}
+
+/** gdt_init_cpu:
+ * This function will set up the special GDT pointer, set up the entries in the GDT of a processor, and then finally
+ * call gdt_flush() in our assembler file in order to tell the processor where the new GDT is and update the new
+ * segment registers. Then it loads the TSS and points gs to the per-CPU area. Called by each processor for itself.
+ *
+ * @param cpu The per-CPU area of the running processor
+ */
+void gdt_init_cpu(struct cpu *cpu) {
+    struct gdt_entry *gdt_entries = cpu->gdt;
+
     // Set up the GDT pointer
-    gdt_pointer.address = (sizeof(struct gdt_entry) * GDT_ENTRY_COUNT) - 1;
-    gdt_pointer.size = (unsigned int) &gdt_entries;
+    cpu->gdt_pointer.address = (sizeof(struct gdt_entry) * GDT_ENTRY_COUNT) - 1;
+    cpu->gdt_pointer.size = (unsigned int) gdt_entries;
 
     /* Null Segment.
      * The first descriptor in the GDT is always a null descriptor and can never be used to access memory.*/
-    gdt_set_gate(0, 0, 0, 0, 0);
+    gdt_set_gate(gdt_entries, 0, 0, 0, 0, 0);
 
     /* Code Segment
      *
@@ -79,7 +91,7 @@ void init_gdt() {
      * Bit:     |  3  |  2  |  1  |     0      |
      * Content: |  G  |  DB |  L  |  reserved  |
      * Value:   |  1  |  1  |  0  |     0      | = 1100 */
-    gdt_set_gate(1, 0, 0xFFFFFFFF, 0x9A, 0b1100);
+    gdt_set_gate(gdt_entries, GDT_KERNEL_CODE, 0, 0xFFFFFFFF, 0x9A, 0b1100);
 
     /* Data Segment
      *
@@ -107,8 +119,40 @@ void init_gdt() {
      * Bit:     |  3  |  2  |  1  |     0      |
      * Content: |  G  |  DB |  L  |  reserved  |
      * Value:   |  1  |  1  |  0  |     0      | = 1100 */
-    gdt_set_gate(2, 0, 0xFFFFFFFF, 0x92, 0b1100);
+    gdt_set_gate(gdt_entries, GDT_KERNEL_DATA, 0, 0xFFFFFFFF, 0x92, 0b1100);
+
+    /* User Code and Data Segments
+     *
+     * The same flat segments with DPL = 3, so code running in ring 3 can use them.
+     *
+     * Access Bytes
+     * Bit:     |  7  |  6  5 |  4  |  3  |  2  |  1  |  0  |
+     * Content: |  P  |  DPL  |  S  |  E  |  DC |  RW |  A  |
+     * Code:    |  1  |  1 1  |  1  |  1  |  0  |  1  |  0  | = 1111 1010 = 0xFA
+     * Data:    |  1  |  1 1  |  1  |  0  |  0  |  1  |  0  | = 1111 0010 = 0xF2 */
+    gdt_set_gate(gdt_entries, GDT_USER_CODE, 0, 0xFFFFFFFF, 0xFA, 0b1100);
+    gdt_set_gate(gdt_entries, GDT_USER_DATA, 0, 0xFFFFFFFF, 0xF2, 0b1100);
+
+    /* Task State Segment
+     *
+     * Access byte 0x89: P = 1, DPL = 0, S = 0 (system segment), Type = 1001 (32-bit TSS, available).
+     * Flags 0000: the limit is in bytes. */
+    memset(&cpu->tss, 0, sizeof(struct tss));
+    cpu->tss.ss0 = KERNEL_DATA_SELECTOR;
+    cpu->tss.esp0 = cpu->stack_top;
+    // An offset beyond the limit means there is no I/O permission bitmap.
+    cpu->tss.iomap_base = sizeof(struct tss);
+    gdt_set_gate(gdt_entries, GDT_TSS, (uint32_t) &cpu->tss, sizeof(struct tss) - 1, 0x89, 0b0000);
+
+    /* Per-CPU data segment
+     *
+     * A data segment like the kernel data segment (0x92), but based at the per-CPU area and byte granular (flags 0100),
+     * so gs:offset addresses the fields of struct cpu of the running processor. */
+    gdt_set_gate(gdt_entries, GDT_PERCPU, (uint32_t) cpu, sizeof(struct cpu) - 1, 0x92, 0b0100);
 
     // Flush out the old GDT and install the new changes!
-    gdt_flush((uint32_t) &gdt_pointer);
+    gdt_flush((uint32_t) &cpu->gdt_pointer);
+
+    asm volatile("ltr %w0" : : "r"(TSS_SELECTOR));
+    asm volatile("mov %w0, %%gs" : : "r"(PERCPU_SELECTOR));
 }
\ No newline at end of file
@@ -3,7 +3,30 @@
 
 #include "../../include/stdint.h"
 
-#define GDT_ENTRY_COUNT     3
+/* Every processor has its own GDT with the same layout: the flat kernel and user segments, its TSS, and a small data
+ * segment over its per-CPU area (struct cpu), which gs selects.
+ *
+ * sysenter and sysexit derive their segments from the kernel code selector: kernel code, kernel data, user code and
+ * user data must be consecutive entries in this order. */
+#define GDT_ENTRY_COUNT     7
+#define GDT_KERNEL_CODE     1
+#define GDT_KERNEL_DATA     2
+#define GDT_USER_CODE       3
+#define GDT_USER_DATA       4
+#define GDT_TSS             5
+#define GDT_PERCPU          6
+
+// Requested privilege level of the user selectors
+#define GDT_RPL_USER        3
+
+// A selector is the index of the entry times 8, plus the requested privilege level.
+#define GDT_SELECTOR(index) ((index) << 3)
+#define KERNEL_CODE_SELECTOR    GDT_SELECTOR(GDT_KERNEL_CODE)
+#define KERNEL_DATA_SELECTOR    GDT_SELECTOR(GDT_KERNEL_DATA)
+#define USER_CODE_SELECTOR      (GDT_SELECTOR(GDT_USER_CODE) | GDT_RPL_USER)
+#define USER_DATA_SELECTOR      (GDT_SELECTOR(GDT_USER_DATA) | GDT_RPL_USER)
+#define TSS_SELECTOR            GDT_SELECTOR(GDT_TSS)
+#define PERCPU_SELECTOR         GDT_SELECTOR(GDT_PERCPU)
 
 /* Segmentation provides a mechanism for dividing the processor’s addressable memory space (called the linear address
  * space) into smaller protected address spaces called segments. Segments can be used to hold the code, data, and stack
@@ -114,6 +137,31 @@ struct gdt {
     uint32_t size;
 } __attribute__((packed));
 
+/* Task State Segment. Without hardware task switching, only the stack of ring 0 (esp0:ss0), loaded when an interrupt
+ * arrives in a less privileged ring, and the I/O permission bitmap offset are used. The scheduler points esp0 to the
+ * kernel stack of a thread running user code when it switches to it. */
+struct tss {
+    uint32_t prev_task;
+    uint32_t esp0;
+    uint32_t ss0;
+    uint32_t esp1;
+    uint32_t ss1;
+    uint32_t esp2;
+    uint32_t ss2;
+    uint32_t cr3;
+    uint32_t eip;
+    uint32_t eflags;
+    uint32_t eax, ecx, edx, ebx;
+    uint32_t esp, ebp, esi, edi;
+    uint32_t es, cs, ss, ds, fs, gs;
+    uint32_t ldt;
+    uint16_t trap;
+    uint16_t iomap_base;
+} __attribute__((packed));
+
+struct cpu;
+
 extern void init_gdt();
+void gdt_init_cpu(struct cpu *cpu);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,472 @@
+#include "slab.h"
+#include "../physical/pmm.h"
+#include "../paging/paging.h"
+#include "../../kernel/sync/spinlock.h"
+#include "../../include/string.h"
+#include "../../kernel/console/console.h"
+
+/* Slab Allocator
+ *
+ * Kernel objects are allocated from object caches. A cache hands out objects of one size from slabs, blocks of pages
+ * taken from the PMM and cut into equally sized slots. Allocation pops the first free object of a partial slab and
+ * free pushes the object back to the free list of its slab, both in constant time and without fragmenting the PMM.
+ *
+ * A cache can have a constructor, which is run once per object when a slab is created, not on every allocation:
+ * objects are expected to be returned to the cache in their constructed state. The free pointer of such caches is
+ * stored after the object, so it does not overwrite constructed fields.
+ *
+ * kmalloc is built on top of a set of power-of-two caches. Each page of a slab points to its slab through its page
+ * frame descriptor, so kfree finds the cache of an object from its address alone.
+ *
+ * The caches are used by threads and interrupt handlers on every processor. Each cache has its own lock, so
+ * allocations from different caches do not contend; the lists are only touched with the lock held and the interrupts
+ * disabled.
+ *
+ * Based on "The Slab Allocator: An Object-Caching Kernel Memory Allocator" by Jeff Bonwick */
+
+// The cache the cache descriptors are allocated from.
+static struct kmem_cache cache_cache;
+static struct kmem_cache *cache_chain;
+static struct spinlock cache_chain_lock = SPINLOCK_INIT;
+
+static struct kmem_cache *kmalloc_caches[KMALLOC_CACHE_COUNT];
+static const char *kmalloc_cache_names[KMALLOC_CACHE_COUNT] = {
+    "kmalloc-8", "kmalloc-16", "kmalloc-32", "kmalloc-64", "kmalloc-128",
+    "kmalloc-256", "kmalloc-512", "kmalloc-1024", "kmalloc-2048",
+};
+
+#define ALIGN_UP(value, align)  (((value) + (align) - 1) & ~((align) - 1))
+
+/** get_free_pointer:
+ *  Returns the object following the given free object on the free list of its slab.
+ */
+static void *get_free_pointer(struct kmem_cache *cache, void *object) {
+    return *(void **) ((uint32_t) object + cache->free_offset);
+}
+
+/** set_free_pointer:
+ *  Sets the object following the given free object on the free list of its slab.
+ */
+static void set_free_pointer(struct kmem_cache *cache, void *object, void *next) {
+    *(void **) ((uint32_t) object + cache->free_offset) = next;
+}
+
+/** slab_list_add:
+ *  Puts the slab at the head of the given list.
+ */
+static void slab_list_add(struct slab **head, struct slab *slab) {
+    slab->prev = 0;
+    slab->next = *head;
+    if (*head) {
+        (*head)->prev = slab;
+    }
+    *head = slab;
+}
+
+/** slab_list_remove:
+ *  Unlinks the slab from the given list.
+ */
+static void slab_list_remove(struct slab **head, struct slab *slab) {
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    }
+    else {
+        *head = slab->next;
+    }
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+    slab->next = 0;
+    slab->prev = 0;
+}
+
+/** cache_setup:
+ *  Computes the layout of the slabs of a cache.
+ *
+ *  @param cache The cache
+ *  @param name  Name of the cache, shown in the statistics
+ *  @param size  Size of an object
+ *  @param align Alignment of an object, a power of two. 0 means pointer alignment.
+ *  @param ctor  Constructor run on every object of a new slab, can be 0
+ *  @return      0 on success, -1 if the objects are too large
+ */
+static int cache_setup(struct kmem_cache *cache, const char *name, uint32_t size, uint32_t align,
+                       void (*ctor)(void *)) {
+    uint32_t order, count = 0;
+
+    memset(cache, 0, sizeof(struct kmem_cache));
+    spin_lock_init(&cache->lock);
+
+    if (align < sizeof(void *)) {
+        align = sizeof(void *);
+    }
+
+    cache->name = name;
+    cache->object_size = size;
+    cache->align = align;
+    cache->ctor = ctor;
+
+    // A constructed object must keep its contents while it is free, so its free pointer goes after the object.
+    cache->size = ALIGN_UP(size, sizeof(void *));
+    if (ctor) {
+        cache->free_offset = cache->size;
+        cache->size += sizeof(void *);
+    }
+    cache->size = ALIGN_UP(cache->size, align);
+    cache->first_object = ALIGN_UP(sizeof(struct slab), align);
+
+    // Use the smallest slab which holds enough objects to keep the waste and the number of slabs low.
+    for (order = 0; order <= PMM_MAX_ORDER; order++) {
+        uint32_t slab_size = PAGE_SIZE << order;
+
+        if (slab_size > cache->first_object) {
+            count = (slab_size - cache->first_object) / cache->size;
+        }
+        if (count >= SLAB_MIN_OBJECTS || (count > 0 && order >= SLAB_MAX_ORDER)) {
+            break;
+        }
+    }
+    if (count == 0) {
+        return -1;
+    }
+
+    cache->order = order;
+    cache->objects_per_slab = count;
+
+    return 0;
+}
+
+/** cache_grow:
+ *  Takes a new slab from the PMM, constructs its objects and puts it on the empty list of the cache.
+ *
+ *  @param cache The cache
+ *  @return      The new slab, 0 if the memory is exhausted
+ */
+static struct slab *cache_grow(struct kmem_cache *cache) {
+    uint32_t address = pmm_alloc_pages(cache->order);
+    struct slab *slab;
+
+    if (address == 0) {
+        return 0;
+    }
+
+    slab = phys_to_virt(address);
+    slab->cache = cache;
+    slab->inuse = 0;
+    slab->free_list = 0;
+
+    // Chain the objects in address order, so consecutive allocations return neighbouring objects.
+    for (int i = cache->objects_per_slab - 1; i >= 0; i--) {
+        void *object = (void *) ((uint32_t) slab + cache->first_object + i * cache->size);
+
+        if (cache->ctor) {
+            cache->ctor(object);
+        }
+        set_free_pointer(cache, object, slab->free_list);
+        slab->free_list = object;
+    }
+
+    for (uint32_t i = 0; i < (1u << cache->order); i++) {
+        struct page *page = phys_to_page(address + i * PAGE_SIZE);
+
+        page->flags |= PAGE_SLAB;
+        page->private = slab;
+    }
+
+    slab_list_add(&cache->empty, slab);
+    cache->empty_slabs++;
+    cache->total_slabs++;
+    cache->grows++;
+
+    return slab;
+}
+
+/** slab_destroy:
+ *  Gives an empty slab, which is on no list, back to the PMM.
+ *
+ *  @param cache The cache of the slab
+ *  @param slab  The slab
+ */
+static void slab_destroy(struct kmem_cache *cache, struct slab *slab) {
+    uint32_t address = virt_to_phys(slab);
+
+    for (uint32_t i = 0; i < (1u << cache->order); i++) {
+        struct page *page = phys_to_page(address + i * PAGE_SIZE);
+
+        page->flags &= ~PAGE_SLAB;
+        page->private = 0;
+    }
+
+    pmm_free_pages(address, cache->order);
+    cache->total_slabs--;
+    cache->shrinks++;
+}
+
+/** kmem_cache_alloc:
+ *  Allocates an object from the cache.
+ *
+ *  @param cache The cache
+ *  @return      The object, 0 if the memory is exhausted
+ */
+void *kmem_cache_alloc(struct kmem_cache *cache) {
+    uint32_t flags = spin_lock_irqsave(&cache->lock);
+    struct slab *slab = cache->partial;
+    void *object;
+
+    if (slab == 0) {
+        slab = cache->empty;
+        if (slab == 0) {
+            slab = cache_grow(cache);
+            if (slab == 0) {
+                spin_unlock_irqrestore(&cache->lock, flags);
+                return 0;
+            }
+        }
+        // The slab moves from the empty list to the partial list.
+        slab_list_remove(&cache->empty, slab);
+        cache->empty_slabs--;
+        slab_list_add(&cache->partial, slab);
+    }
+
+    object = slab->free_list;
+    slab->free_list = get_free_pointer(cache, object);
+    slab->inuse++;
+
+    if (slab->inuse == cache->objects_per_slab) {
+        slab_list_remove(&cache->partial, slab);
+        slab_list_add(&cache->full, slab);
+    }
+
+    cache->allocs++;
+    cache->active_objects++;
+
+    spin_unlock_irqrestore(&cache->lock, flags);
+    return object;
+}
+
+/** kmem_cache_free:
+ *  Returns an object to its cache. Objects of caches with a constructor must be in their constructed state.
+ *
+ *  @param cache  The cache the object was allocated from
+ *  @param object The object
+ */
+void kmem_cache_free(struct kmem_cache *cache, void *object) {
+    struct page *page = phys_to_page(virt_to_phys(object));
+    struct slab *slab;
+    uint32_t flags;
+
+    if (page == 0 || !(page->flags & PAGE_SLAB)) {
+        return;
+    }
+    slab = page->private;
+    if (slab->cache != cache) {
+        return;
+    }
+
+    flags = spin_lock_irqsave(&cache->lock);
+
+    if (slab->inuse == cache->objects_per_slab) {
+        slab_list_remove(&cache->full, slab);
+        slab_list_add(&cache->partial, slab);
+    }
+
+    set_free_pointer(cache, object, slab->free_list);
+    slab->free_list = object;
+    slab->inuse--;
+
+    // Keep a single empty slab to absorb alloc/free cycles around a slab boundary, give the others back.
+    if (slab->inuse == 0) {
+        slab_list_remove(&cache->partial, slab);
+        if (cache->empty_slabs > 0) {
+            slab_destroy(cache, slab);
+        }
+        else {
+            slab_list_add(&cache->empty, slab);
+            cache->empty_slabs++;
+        }
+    }
+
+    cache->frees++;
+    cache->active_objects--;
+    spin_unlock_irqrestore(&cache->lock, flags);
+}
+
+/** kmem_cache_shrink:
+ *  Gives all the empty slabs of the cache back to the PMM.
+ *
+ *  @param cache The cache
+ */
+void kmem_cache_shrink(struct kmem_cache *cache) {
+    uint32_t flags = spin_lock_irqsave(&cache->lock);
+
+    while (cache->empty) {
+        struct slab *slab = cache->empty;
+
+        slab_list_remove(&cache->empty, slab);
+        cache->empty_slabs--;
+        slab_destroy(cache, slab);
+    }
+    spin_unlock_irqrestore(&cache->lock, flags);
+}
+
+/** kmem_cache_create:
+ *  Creates an object cache.
+ *
+ *  @param name  Name of the cache, shown in the statistics. The string is not copied.
+ *  @param size  Size of an object
+ *  @param align Alignment of an object, a power of two. 0 means pointer alignment.
+ *  @param ctor  Constructor run on every object of a new slab, can be 0
+ *  @return      The cache, 0 on failure
+ */
+struct kmem_cache *kmem_cache_create(const char *name, uint32_t size, uint32_t align, void (*ctor)(void *)) {
+    struct kmem_cache *cache = kmem_cache_alloc(&cache_cache);
+    uint32_t flags;
+
+    if (cache == 0) {
+        return 0;
+    }
+    if (cache_setup(cache, name, size, align, ctor) != 0) {
+        kmem_cache_free(&cache_cache, cache);
+        return 0;
+    }
+
+    flags = spin_lock_irqsave(&cache_chain_lock);
+    cache->next = cache_chain;
+    cache_chain = cache;
+    spin_unlock_irqrestore(&cache_chain_lock, flags);
+
+    return cache;
+}
+
+/** kmem_cache_destroy:
+ *  Destroys a cache created by kmem_cache_create. All its objects must have been freed.
+ *
+ *  @param cache The cache
+ *  @return      0 on success, -1 if the cache still has allocated objects
+ */
+int kmem_cache_destroy(struct kmem_cache *cache) {
+    struct kmem_cache **link;
+    uint32_t flags;
+
+    if (cache->active_objects) {
+        return -1;
+    }
+    kmem_cache_shrink(cache);
+
+    flags = spin_lock_irqsave(&cache_chain_lock);
+    for (link = &cache_chain; *link; link = &(*link)->next) {
+        if (*link == cache) {
+            *link = cache->next;
+            break;
+        }
+    }
+    spin_unlock_irqrestore(&cache_chain_lock, flags);
+
+    kmem_cache_free(&cache_cache, cache);
+    return 0;
+}
+
+/** kmalloc:
+ *  Allocates a block of memory. Blocks up to KMALLOC_MAX_CACHE_SIZE come from the power-of-two caches and are aligned
+ *  to 8 bytes, larger blocks are whole pages from the PMM.
+ *
+ *  @param size Size of the block
+ *  @return     The block, 0 if the memory is exhausted
+ */
+void *kmalloc(size_t size) {
+    uint32_t order = 0;
+    uint32_t address;
+    struct page *page;
+
+    if (size == 0) {
+        return 0;
+    }
+
+    if (size <= KMALLOC_MAX_CACHE_SIZE) {
+        // Index of the smallest power of two which is >= size, counted from KMALLOC_MIN_SIZE (2^3).
+        uint32_t index = size <= KMALLOC_MIN_SIZE ? 0 : 32 - __builtin_clz(size - 1) - 3;
+
+        return kmem_cache_alloc(kmalloc_caches[index]);
+    }
+
+    // Larger than the largest block of the buddy allocator, also keeps the shift below from overflowing.
+    if (size > ((size_t) PAGE_SIZE << PMM_MAX_ORDER)) {
+        return 0;
+    }
+    while (((size_t) PAGE_SIZE << order) < size) {
+        order++;
+    }
+    address = pmm_alloc_pages(order);
+    if (address == 0) {
+        return 0;
+    }
+
+    page = phys_to_page(address);
+    page->flags |= PAGE_KMALLOC;
+
+    return phys_to_virt(address);
+}
+
+/** kzalloc:
+ *  Allocates a zeroed block of memory.
+ *
+ *  @param size Size of the block
+ *  @return     The block, 0 if the memory is exhausted
+ */
+void *kzalloc(size_t size) {
+    void *ptr = kmalloc(size);
+
+    if (ptr) {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+/** kfree:
+ *  Frees a block allocated by kmalloc.
+ *
+ *  @param ptr The block, can be 0
+ */
+void kfree(void *ptr) {
+    struct page *page;
+
+    if (ptr == 0) {
+        return;
+    }
+
+    page = phys_to_page(virt_to_phys(ptr));
+    if (page == 0) {
+        return;
+    }
+
+    if (page->flags & PAGE_SLAB) {
+        struct slab *slab = page->private;
+        kmem_cache_free(slab->cache, ptr);
+    }
+    else if (page->flags & PAGE_KMALLOC) {
+        page->flags &= ~PAGE_KMALLOC;
+        pmm_free_pages(virt_to_phys(ptr), page->order);
+    }
+}
+
+/** slab_print_stats:
+ *  Writes the statistics of every cache to the console.
+ */
+void slab_print_stats() {
+    for (struct kmem_cache *cache = cache_chain; cache; cache = cache->next) {
+        os_printf("%-12s size %5u active %5u slabs %4u allocs %u frees %u\n", cache->name, cache->object_size,
+                  cache->active_objects, cache->total_slabs, cache->allocs, cache->frees);
+    }
+}
+
+/** init_slab:
+ *  Sets up the cache of the cache descriptors and the kmalloc caches. Requires the PMM.
+ */
+void init_slab() {
+    cache_setup(&cache_cache, "kmem_cache", sizeof(struct kmem_cache), 0, 0);
+    cache_chain = &cache_cache;
+
+    for (int i = 0; i < KMALLOC_CACHE_COUNT; i++) {
+        kmalloc_caches[i] = kmem_cache_create(kmalloc_cache_names[i], KMALLOC_MIN_SIZE << i, KMALLOC_MIN_SIZE, 0);
+    }
+}
\ No newline at end of file
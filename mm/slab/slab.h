@@ -0,0 +1,68 @@
+#ifndef __SLAB_H__
+#define __SLAB_H__
+
+#include "../../include/stdint.h"
+#include "../../include/stddef.h"
+#include "../../kernel/sync/spinlock.h"
+
+// kmalloc serves sizes up to KMALLOC_MAX_CACHE_SIZE from power-of-two caches, larger sizes straight from the PMM.
+#define KMALLOC_MIN_SIZE            8
+#define KMALLOC_MAX_CACHE_SIZE      2048
+#define KMALLOC_CACHE_COUNT         9       /* 8, 16, 32, ..., 2048 */
+
+// A slab holds at least this many objects, unless that would make it larger than 2^SLAB_MAX_ORDER pages.
+#define SLAB_MIN_OBJECTS            8
+#define SLAB_MAX_ORDER              3
+
+/* A slab is a block of 2^order pages carved into equally sized objects. Its header sits at the start of the block,
+ * the free objects are chained through a pointer stored free_offset bytes into each free object. */
+struct slab {
+    struct slab *next;
+    struct slab *prev;
+    struct kmem_cache *cache;
+    void *free_list;            // first free object of the slab
+    uint32_t inuse;             // number of allocated objects
+};
+
+/* An object cache. Each cache keeps its slabs on three lists, so allocation and free never search: partially used
+ * slabs are served first, then a cached empty slab, and only then a new slab is taken from the PMM. */
+struct kmem_cache {
+    const char *name;
+    uint32_t object_size;       // size requested at creation
+    uint32_t size;              // size of an object slot, including alignment and the free pointer
+    uint32_t align;
+    uint32_t free_offset;       // offset of the free pointer in a free object
+    uint32_t order;             // a slab is 2^order pages
+    uint32_t objects_per_slab;
+    uint32_t first_object;      // offset of the first object from the start of the slab
+    void (*ctor)(void *object);
+
+    struct spinlock lock;       // protects the slab lists and the statistics
+    struct slab *partial;
+    struct slab *full;
+    struct slab *empty;
+
+    // Statistics
+    uint32_t allocs;            // successful allocations
+    uint32_t frees;
+    uint32_t active_objects;    // allocated objects
+    uint32_t total_slabs;
+    uint32_t empty_slabs;
+    uint32_t grows;             // slabs taken from the PMM
+    uint32_t shrinks;           // slabs given back to the PMM
+
+    struct kmem_cache *next;    // all caches are chained for statistics
+};
+
+void init_slab();
+struct kmem_cache *kmem_cache_create(const char *name, uint32_t size, uint32_t align, void (*ctor)(void *));
+int kmem_cache_destroy(struct kmem_cache *cache);
+void *kmem_cache_alloc(struct kmem_cache *cache);
+void kmem_cache_free(struct kmem_cache *cache, void *object);
+void kmem_cache_shrink(struct kmem_cache *cache);
+void *kmalloc(size_t size);
+void *kzalloc(size_t size);
+void kfree(void *ptr);
+void slab_print_stats();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "vm.h"
+#include "../paging/paging.h"
+#include "../segmentation/gdt.h"
+#include "../physical/pmm.h"
+#include "../slab/slab.h"
+#include "../../include/string.h"
+#include "../../kernel/cpu/cpu.h"
+#include "../../kernel/log/log.h"
+#include "../../kernel/sched/sched.h"
+#include "../../kernel/syscall/syscall.h"
+#include "../../drivers/interrupts/isr.h"
+
+/* Demand paging
+ *
+ * The user pages of an address space are not allocated when they are mapped. vm_map only records an area; the first
+ * access to a page of it raises a page fault, and the handler allocates a frame, fills it from the area and maps it.
+ * Loading a program costs the pages it touches: the pages of its file are copied from the module on first use, and
+ * its BSS and stack are zero-filled on first use. */
+
+// Vector of the page fault exception
+#define VM_PAGE_FAULT_VECTOR    14
+
+static struct kmem_cache *space_cache;
+static struct kmem_cache *area_cache;
+
+/** find_area:
+ *  Returns the area of the address space which contains the given address, 0 if there is none. Called with the lock
+ *  of the address space held.
+ */
+static struct vm_area *find_area(struct address_space *space, uint32_t address) {
+    for (struct vm_area *area = space->areas; area; area = area->next) {
+        if (address >= area->start && address < area->end) {
+            return area;
+        }
+    }
+    return 0;
+}
+
+/** fill_page:
+ *  Fills a frame with the contents of a page of the area: the part of the file the page covers, zeros elsewhere.
+ */
+static void fill_page(struct vm_area *area, uint32_t page, uint8_t *data) {
+    uint32_t page_end = page + PAGE_SIZE;
+    uint32_t file_end = area->file_start + area->file_size;
+    uint32_t from = area->file_start > page ? area->file_start : page;
+    uint32_t to = file_end < page_end ? file_end : page_end;
+
+    if (area->file == 0 || from >= to) {
+        memset(data, 0, PAGE_SIZE);
+        return;
+    }
+    memset(data, 0, from - page);
+    memcpy(data + (from - page), area->file + (from - area->file_start), to - from);
+    memset(data + (to - page), 0, page_end - to);
+}
+
+/** page_fault_handler:
+ *  Handles the page faults. A fault on a user page of an area of the running thread's address space faults the page
+ *  in, from user mode or from the kernel accessing user memory. Any other fault of user code ends it, like the exit
+ *  system call with VM_FAULT_EXIT_STATUS. A fault of the kernel on user memory inside user_copy makes the copy fail,
+ *  any other fault of the kernel halts the system.
+ */
+static void page_fault_handler(struct interrupt_frame *frame) {
+    uint32_t address = read_cr2();
+    struct thread *thread = thread_current();
+
+    if (thread && thread->space && address < KERNEL_VIRTUAL_BASE &&
+        vm_fault(thread->space, address, frame->error_code) == 0) {
+        return;
+    }
+
+    if ((frame->cs & GDT_RPL_USER) == GDT_RPL_USER) {
+        log_error("%s: page fault at 0x%x (eip 0x%x, error 0x%x)", thread->name, address, frame->eip,
+                  frame->error_code);
+        user_exit(VM_FAULT_EXIT_STATUS);
+    }
+    // The kernel copying from user memory gets an error back.
+    if (address < KERNEL_VIRTUAL_BASE && user_fault_fixup(frame)) {
+        return;
+    }
+
+    // The dump includes cr2, the faulting address.
+    exception_halt(frame);
+}
+
+/** init_vm:
+ *  Sets up the address spaces and the page fault handler. Requires the slab allocator and the IDT.
+ */
+void init_vm() {
+    space_cache = kmem_cache_create("address_space", sizeof(struct address_space), 0, 0);
+    area_cache = kmem_cache_create("vm_area", sizeof(struct vm_area), 0, 0);
+    register_interrupt_handler(VM_PAGE_FAULT_VECTOR, page_fault_handler);
+}
+
+/** vm_create:
+ *  Creates an empty address space, with the kernel half shared with the kernel page directory.
+ *
+ *  @return The address space, 0 if the memory is exhausted
+ */
+struct address_space *vm_create() {
+    struct address_space *space = kmem_cache_alloc(space_cache);
+
+    if (space == 0) {
+        return 0;
+    }
+    space->directory = paging_create_directory();
+    if (space->directory == 0) {
+        kmem_cache_free(space_cache, space);
+        return 0;
+    }
+    space->areas = 0;
+    spin_lock_init(&space->lock);
+
+    return space;
+}
+
+/** vm_destroy:
+ *  Frees an address space, the frames faulted in and its page tables. It must not be active on any processor.
+ *
+ *  @param space The address space
+ */
+void vm_destroy(struct address_space *space) {
+    struct vm_area *area = space->areas;
+
+    while (area) {
+        struct vm_area *next = area->next;
+
+        for (uint32_t page = area->start; page < area->end; page += PAGE_SIZE) {
+            uint32_t frame = paging_get_physical(space->directory, page);
+
+            if (frame) {
+                pmm_free_frame(frame & PTE_ADDRESS_MASK);
+            }
+        }
+        kmem_cache_free(area_cache, area);
+        area = next;
+    }
+
+    paging_destroy_directory(space->directory);
+    kmem_cache_free(space_cache, space);
+}
+
+/** vm_map:
+ *  Adds an area of user pages to an address space. No memory is allocated for the pages, they are filled in by
+ *  vm_fault once they are accessed.
+ *
+ *  @param space     The address space
+ *  @param address   Start of the area, rounded down to a page
+ *  @param size      Size of the area in bytes, the end is rounded up to a page
+ *  @param flags     PTE_* flags of the pages, PTE_USER is added
+ *  @param file      Contents of the area starting at address, in kernel memory which outlives the address space; 0 to
+ *                   zero-fill the area
+ *  @param file_size Size of file, the rest of the area is zero-filled
+ *  @return          0 on success, -1 if the area leaves the user half, overlaps another area or the memory is exhausted
+ */
+int vm_map(struct address_space *space, uint32_t address, uint32_t size, uint32_t flags, const uint8_t *file,
+           uint32_t file_size) {
+    uint32_t start = address & PTE_ADDRESS_MASK;
+    uint32_t end;
+    struct vm_area *area;
+    uint32_t lock_flags;
+
+    if (size == 0 || file_size > size || address >= KERNEL_VIRTUAL_BASE || size > KERNEL_VIRTUAL_BASE - address) {
+        return -1;
+    }
+    end = (address + size + PAGE_SIZE - 1) & PTE_ADDRESS_MASK;
+
+    area = kmem_cache_alloc(area_cache);
+    if (area == 0) {
+        return -1;
+    }
+    area->start = start;
+    area->end = end;
+    area->flags = (flags & ~PTE_ADDRESS_MASK) | PTE_USER;
+    area->file = file;
+    area->file_start = address;
+    area->file_size = file ? file_size : 0;
+
+    lock_flags = spin_lock_irqsave(&space->lock);
+    for (struct vm_area *other = space->areas; other; other = other->next) {
+        if (start < other->end && end > other->start) {
+            spin_unlock_irqrestore(&space->lock, lock_flags);
+            kmem_cache_free(area_cache, area);
+            return -1;
+        }
+    }
+    area->next = space->areas;
+    space->areas = area;
+    spin_unlock_irqrestore(&space->lock, lock_flags);
+
+    return 0;
+}
+
+/** vm_fault:
+ *  Resolves a page fault in the user half of an address space: allocates a frame for the page, fills it from its
+ *  area and maps it.
+ *
+ *  @param space      The address space
+ *  @param address    The faulting address
+ *  @param error_code The error code of the page fault, VM_FAULT_* bits
+ *  @return           0 if the access can be retried, -1 if it is not allowed or the memory is exhausted
+ */
+int vm_fault(struct address_space *space, uint32_t address, uint32_t error_code) {
+    uint32_t page = address & PTE_ADDRESS_MASK;
+    uint32_t lock_flags = spin_lock_irqsave(&space->lock);
+    struct vm_area *area = find_area(space, address);
+    uint32_t frame;
+    int result = -1;
+
+    if (area == 0 || (error_code & VM_FAULT_PRESENT)) {
+        // No area, or a protection violation such as a write to a read-only page.
+    }
+    else if ((error_code & VM_FAULT_WRITE) && !(area->flags & PTE_WRITABLE)) {
+        // A write to a read-only page not faulted in yet.
+    }
+    else if (paging_get_physical(space->directory, page)) {
+        // Another thread of the address space faulted the page in first.
+        result = 0;
+    }
+    else if ((frame = pmm_alloc_frame()) != 0) {
+        fill_page(area, page, phys_to_virt(frame));
+        if (paging_map_page(space->directory, page, frame, area->flags) == 0) {
+            result = 0;
+        }
+        else {
+            pmm_free_frame(frame);
+        }
+    }
+    spin_unlock_irqrestore(&space->lock, lock_flags);
+
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef __VM_H__
+#define __VM_H__
+
+#include "../../include/stdint.h"
+#include "../../kernel/sync/spinlock.h"
+
+// Bits of the error code of a page fault
+#define VM_FAULT_PRESENT        0x1     /* the page was present, the access violated its protection */
+#define VM_FAULT_WRITE          0x2     /* the access was a write */
+#define VM_FAULT_USER           0x4     /* the access came from user mode */
+
+// Exit status of user code killed by a page fault it has no area for
+#define VM_FAULT_EXIT_STATUS    -1
+
+/* A range of user pages, filled in on the first access (see vm_fault). The bytes from file_start on are copied from
+ * file, up to file_size of them; everything else in the area reads as zero. */
+struct vm_area {
+    uint32_t start;             // address of the first page
+    uint32_t end;               // address after the last page
+    uint32_t flags;             // PTE_* flags of the pages
+    const uint8_t *file;        // contents of the area in kernel memory (e.g. a module), 0 for zero-filled memory
+    uint32_t file_start;        // virtual address of the first byte of file
+    uint32_t file_size;
+    struct vm_area *next;
+};
+
+// The user half of an address space: its page directory and the areas its pages are faulted in from.
+struct address_space {
+    uint32_t *directory;
+    struct vm_area *areas;
+    struct spinlock lock;
+};
+
+void init_vm();
+struct address_space *vm_create();
+void vm_destroy(struct address_space *space);
+int vm_map(struct address_space *space, uint32_t address, uint32_t size, uint32_t flags, const uint8_t *file,
+           uint32_t file_size);
+int vm_fault(struct address_space *space, uint32_t address, uint32_t error_code);
+
+#endif
\ No newline at end of file
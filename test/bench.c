@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "test.h"
+
+/* Throughput of lib/ next to the C library of the host. Like Google Benchmark, a case runs with a doubling number of
+ * iterations until one run takes at least the minimum time, and that run gives the time per iteration. The numbers
+ * compare implementations on the build machine, the kernel has its own benchmarks in bench/ for the real target. */
+
+#define BENCH_BUFFER_SIZE       (64 * 1024 + 64)
+
+static uint8_t source[BENCH_BUFFER_SIZE] __attribute__((aligned(64)));
+static uint8_t destination[BENCH_BUFFER_SIZE] __attribute__((aligned(64)));
+static char long_string[1024];
+
+// Called through pointers, so the compiler can neither inline nor drop the C library versions.
+static void *(*volatile libc_memcpy)(void *, const void *, size_t) = memcpy;
+static void *(*volatile libc_memmove)(void *, const void *, size_t) = memmove;
+static void *(*volatile libc_memset)(void *, int, size_t) = memset;
+static size_t (*volatile libc_strlen)(const char *) = strlen;
+static int (*volatile libc_vsnprintf)(char *, size_t, const char *, va_list) = vsnprintf;
+
+// Results stored here are not optimized away.
+static volatile size_t bench_sink;
+
+/* A benchmark case: run repeats the operation iterations times, bytes is the number of bytes one iteration processes,
+ * 0 if a throughput in bytes makes no sense. */
+struct bench_case {
+    const char *name;
+    void (*run)(uint64_t iterations, size_t arg, int libc);
+    size_t arg;
+    size_t bytes;
+};
+
+static void run_memcpy(uint64_t iterations, size_t size, int libc) {
+    void *(*copy)(void *, const void *, size_t) = libc ? libc_memcpy : saturn_memcpy;
+
+    for (uint64_t i = 0; i < iterations; i++) {
+        copy(destination, source, size);
+    }
+}
+
+static void run_memmove(uint64_t iterations, size_t size, int libc) {
+    void *(*move)(void *, const void *, size_t) = libc ? libc_memmove : saturn_memmove;
+
+    // Overlapping with the destination above the source, the backward copy.
+    for (uint64_t i = 0; i < iterations; i++) {
+        move(source + 8, source, size);
+    }
+}
+
+static void run_memset(uint64_t iterations, size_t size, int libc) {
+    void *(*fill)(void *, int, size_t) = libc ? libc_memset : saturn_memset;
+
+    for (uint64_t i = 0; i < iterations; i++) {
+        fill(destination, (int) i, size);
+    }
+}
+
+static void run_strlen(uint64_t iterations, size_t offset, int libc) {
+    size_t (*length)(const char *) = libc ? libc_strlen : saturn_strlen;
+
+    for (uint64_t i = 0; i < iterations; i++) {
+        bench_sink += length(long_string + offset);
+    }
+}
+
+/** format:
+ *  Formats a typical log line with either implementation.
+ */
+static int format(int libc, char *buf, size_t size, const char *format, ...) {
+    va_list ap;
+    int length;
+
+    va_start(ap, format);
+    length = libc ? libc_vsnprintf(buf, size, format, ap) : saturn_vsnprintf(buf, size, format, ap);
+    va_end(ap);
+
+    return length;
+}
+
+static void run_snprintf(uint64_t iterations, size_t arg, int libc) {
+    char buf[128];
+
+    (void) arg;
+    for (uint64_t i = 0; i < iterations; i++) {
+        bench_sink += format(libc, buf, sizeof(buf), "[%5u.%06u] %s: irq %d took %llu cycles at 0x%08x", (unsigned) i,
+                             123456u, "INFO", 4, (unsigned long long) i * 977, 0xC0100000u);
+    }
+}
+
+static const struct bench_case cases[] = {
+    {"memcpy/16", run_memcpy, 16, 16},
+    {"memcpy/256", run_memcpy, 256, 256},
+    {"memcpy/4096", run_memcpy, 4096, 4096},
+    {"memcpy/65536", run_memcpy, 65536, 65536},
+    {"memmove_backward/4096", run_memmove, 4096, 4096},
+    {"memset/256", run_memset, 256, 256},
+    {"memset/4096", run_memset, 4096, 4096},
+    {"strlen/1023", run_strlen, 0, 1023},
+    {"strlen_unaligned/1020", run_strlen, 3, 1020},
+    {"snprintf/log_line", run_snprintf, 0, 0},
+};
+
+/** now:
+ *  Returns a monotonic time in seconds.
+ */
+static double now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/** measure:
+ *  Runs a case with a doubling number of iterations until a run takes min_time, and returns the nanoseconds per
+ *  iteration of that run.
+ */
+static double measure(const struct bench_case *bench, int libc, double min_time) {
+    for (uint64_t iterations = 1;; iterations *= 2) {
+        double start = now();
+        double elapsed;
+
+        bench->run(iterations, bench->arg, libc);
+        elapsed = now() - start;
+        if (elapsed >= min_time || iterations >= (1ull << 40)) {
+            return elapsed * 1e9 / iterations;
+        }
+    }
+}
+
+/** bench_lib:
+ *  Measures every case with lib/ and with the C library, and writes a table of the results.
+ *
+ *  @param min_time Least time in seconds of the measured run of each case
+ */
+void bench_lib(double min_time) {
+    memset(source, 0x5A, sizeof(source));
+    memset(long_string, 'x', sizeof(long_string) - 1);
+
+    printf("%-24s %14s %12s %14s %12s\n", "benchmark", "saturn ns/op", "MB/s", "libc ns/op", "MB/s");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        double saturn = measure(&cases[i], 0, min_time);
+        double libc = measure(&cases[i], 1, min_time);
+
+        if (cases[i].bytes) {
+            printf("%-24s %14.1f %12.0f %14.1f %12.0f\n", cases[i].name, saturn, cases[i].bytes * 1e3 / saturn, libc,
+                   cases[i].bytes * 1e3 / libc);
+        }
+        else {
+            printf("%-24s %14.1f %12s %14.1f %12s\n", cases[i].name, saturn, "-", libc, "-");
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+
+/* Differential fuzzing of lib/ against the C library of the host: every random case runs through the saturn_
+ * function and its libc counterpart, and the results must match byte for byte. */
+
+#define FUZZ_BUFFER_SIZE        4096
+#define FUZZ_MAX_LENGTH         (2 * TEST_LARGE_THRESHOLD)
+
+static uint8_t fuzz_buffer[FUZZ_BUFFER_SIZE];
+static uint8_t reference_buffer[FUZZ_BUFFER_SIZE];
+
+/** fuzz_fill:
+ *  Fills both buffers with the same random bytes.
+ */
+static void fuzz_fill() {
+    for (size_t i = 0; i < FUZZ_BUFFER_SIZE; i++) {
+        fuzz_buffer[i] = reference_buffer[i] = (uint8_t) test_random();
+    }
+}
+
+/** random_length:
+ *  Returns a length below FUZZ_MAX_LENGTH, mostly short ones, where the head and tail handling lives.
+ */
+static size_t random_length() {
+    return (test_random() & 3) ? test_random() % 64 : test_random() % FUZZ_MAX_LENGTH;
+}
+
+/** random_offset:
+ *  Returns an offset at which a block of the given length fits into the buffers.
+ */
+static size_t random_offset(size_t length) {
+    return test_random() % (FUZZ_BUFFER_SIZE - length);
+}
+
+static void fuzz_memmove() {
+    size_t n = random_length();
+    size_t src = random_offset(n);
+    // Near the source half of the time, so that the blocks overlap in both directions.
+    size_t dst = (test_random() & 1) ? random_offset(n) : src - (src < 16 ? src : 16) + test_random() % 32;
+
+    if (dst + n > FUZZ_BUFFER_SIZE) {
+        dst = FUZZ_BUFFER_SIZE - n;
+    }
+    fuzz_fill();
+    saturn_memmove(fuzz_buffer + dst, fuzz_buffer + src, n);
+    memmove(reference_buffer + dst, reference_buffer + src, n);
+    TEST_CHECK(memcmp(fuzz_buffer, reference_buffer, FUZZ_BUFFER_SIZE) == 0, "memmove(+%zu, +%zu, %zu)", dst, src,
+               n);
+}
+
+static void fuzz_memcpy() {
+    size_t n = random_length();
+    size_t src = random_offset(n);
+    size_t dst = random_offset(n);
+
+    if (dst < src + n && src < dst + n) {
+        return;
+    }
+    fuzz_fill();
+    saturn_memcpy(fuzz_buffer + dst, fuzz_buffer + src, n);
+    memcpy(reference_buffer + dst, reference_buffer + src, n);
+    TEST_CHECK(memcmp(fuzz_buffer, reference_buffer, FUZZ_BUFFER_SIZE) == 0, "memcpy(+%zu, +%zu, %zu)", dst, src, n);
+}
+
+static void fuzz_memset() {
+    size_t n = random_length();
+    size_t dest = random_offset(n);
+    int value = (int) test_random();
+
+    fuzz_fill();
+    saturn_memset(fuzz_buffer + dest, value, n);
+    memset(reference_buffer + dest, value, n);
+    TEST_CHECK(memcmp(fuzz_buffer, reference_buffer, FUZZ_BUFFER_SIZE) == 0, "memset(+%zu, 0x%x, %zu)", dest, value,
+               n);
+}
+
+/** sign:
+ *  Reduces a comparison result to -1, 0 or 1, only the sign of memcmp is specified.
+ */
+static int sign(int value) {
+    return (value > 0) - (value < 0);
+}
+
+static void fuzz_memcmp() {
+    size_t n = random_length();
+    size_t a = random_offset(n);
+    size_t b = random_offset(n);
+
+    fuzz_fill();
+    // Mostly equal blocks with a single difference, which has to be found at any position.
+    memcpy(fuzz_buffer + b, fuzz_buffer + a, n);
+    if (n && (test_random() & 1)) {
+        fuzz_buffer[b + test_random() % n] = (uint8_t) test_random();
+    }
+    TEST_CHECK(sign(saturn_memcmp(fuzz_buffer + a, fuzz_buffer + b, n)) == sign(memcmp(fuzz_buffer + a,
+               fuzz_buffer + b, n)), "memcmp(+%zu, +%zu, %zu)", a, b, n);
+}
+
+static void fuzz_strlen() {
+    size_t start = test_random() % 64;
+    size_t n = random_length();
+    size_t limit = test_random() % (FUZZ_MAX_LENGTH + 16);
+
+    for (size_t i = 0; i < n; i++) {
+        fuzz_buffer[start + i] = (uint8_t) (test_random() | 1);
+    }
+    fuzz_buffer[start + n] = 0;
+    TEST_CHECK(saturn_strlen((char *) fuzz_buffer + start) == strlen((char *) fuzz_buffer + start),
+               "strlen at +%zu of length %zu", start, n);
+    TEST_CHECK(saturn_strnlen((char *) fuzz_buffer + start, limit) == strnlen((char *) fuzz_buffer + start, limit),
+               "strnlen at +%zu of length %zu, limit %zu", start, n, limit);
+}
+
+static void fuzz_itoa() {
+    int value = (int) test_random() >> (test_random() % 32);
+    int base = 2 + test_random() % 35;
+    char expected[40];
+    char actual[40];
+
+    // The reference: decimal with sign, every other base on the bits of the value.
+    if (base == 10) {
+        snprintf(expected, sizeof(expected), "%d", value);
+    }
+    else {
+        unsigned int magnitude = (unsigned int) value;
+        char digits[40];
+        int count = 0;
+
+        do {
+            digits[count++] = "0123456789abcdefghijklmnopqrstuvwxyz"[magnitude % base];
+            magnitude /= base;
+        } while (magnitude);
+        for (int i = 0; i < count; i++) {
+            expected[i] = digits[count - 1 - i];
+        }
+        expected[count] = 0;
+    }
+    saturn_itoa(value, actual, base);
+    TEST_CHECK(strcmp(actual, expected) == 0, "itoa(%d, %d) gave \"%s\", expected \"%s\"", value, base, actual,
+               expected);
+}
+
+/** fuzz_string:
+ *  Compares the string and memory functions of lib/string.c with the C library on random blocks.
+ */
+void fuzz_string(uint32_t iterations) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        fuzz_memmove();
+        fuzz_memcpy();
+        fuzz_memset();
+        fuzz_memcmp();
+        fuzz_strlen();
+        fuzz_itoa();
+    }
+}
+
+/** format_both:
+ *  Formats with saturn_vsnprintf and vsnprintf into buffers of the same size and compares the results.
+ */
+static void format_both(size_t size, const char *format, ...) {
+    char actual[256];
+    char expected[256];
+    int actual_length;
+    int expected_length;
+    va_list ap;
+
+    memset(actual, '#', sizeof(actual));
+    memset(expected, '#', sizeof(expected));
+    va_start(ap, format);
+    actual_length = saturn_vsnprintf(actual, size, format, ap);
+    va_end(ap);
+    va_start(ap, format);
+    expected_length = vsnprintf(expected, size, format, ap);
+    va_end(ap);
+
+    TEST_CHECK(actual_length == expected_length && memcmp(actual, expected, sizeof(actual)) == 0,
+               "\"%s\" into %zu bytes: got \"%.*s\" (%d), expected \"%.*s\" (%d)", format, size,
+               size ? (int) size - 1 : 0, actual, actual_length, size ? (int) size - 1 : 0, expected,
+               expected_length);
+}
+
+static const char *const fuzz_strings[] = {"", "a", "SaturnOS", "kernel log ring", "0123456789abcdefghijklmnop"};
+
+// Calls format_both with the value, preceded by the width and the precision if the format takes them as arguments.
+#define FORMAT_BOTH(value)                                                                                      \
+    do {                                                                                                        \
+        if (star_width && star_precision) {                                                                     \
+            format_both(size, format, width, precision, value);                                                 \
+        }                                                                                                       \
+        else if (star_width) {                                                                                  \
+            format_both(size, format, width, value);                                                            \
+        }                                                                                                       \
+        else if (star_precision) {                                                                              \
+            format_both(size, format, precision, value);                                                        \
+        }                                                                                                       \
+        else {                                                                                                  \
+            format_both(size, format, value);                                                                   \
+        }                                                                                                       \
+    } while (0)
+
+/** fuzz_format:
+ *  Builds a random conversion within what lib/printf.c supports and the C standard defines, and formats a random
+ *  value with it: no '#' on signed conversions, only '-' on %c, %s and %p, no precision on %c and %p.
+ */
+static void fuzz_format() {
+    static const char conversions[] = "diuxXocsp%";
+    static const char *const lengths[] = {"", "hh", "h", "l", "ll", "z"};
+    char conversion = conversions[test_random() % (sizeof(conversions) - 1)];
+    int integer = conversion != 'c' && conversion != 's' && conversion != 'p' && conversion != '%';
+    const char *length = integer ? lengths[test_random() % 6] : "";
+    int star_width = (test_random() & 7) == 0;
+    int star_precision = (test_random() & 7) == 0 && conversion != 'c' && conversion != 'p' && conversion != '%';
+    int width = (int) (test_random() % 24) - (star_width ? 12 : 0);
+    int precision = (int) (test_random() % 24) - (star_precision ? 4 : 0);
+    size_t size = (test_random() & 3) ? 200 : test_random() % 32;
+    char format[64];
+    char *f = format;
+    uint64_t bits = ((uint64_t) test_random() << 32 | test_random()) >> (test_random() % 64);
+
+    *f++ = '%';
+    if (conversion != '%') {
+        if ((test_random() & 3) == 0) {
+            *f++ = '-';
+        }
+        if (integer) {
+            static const char flags[] = "0+ #";
+
+            for (int i = 0; i < 4; i++) {
+                if ((test_random() & 3) == 0 && !(flags[i] == '#' && (conversion == 'd' || conversion == 'i'))) {
+                    *f++ = flags[i];
+                }
+            }
+        }
+        if (star_width) {
+            *f++ = '*';
+        }
+        else if (test_random() & 1) {
+            f += sprintf(f, "%d", width);
+        }
+        if (star_precision) {
+            f += sprintf(f, ".*");
+        }
+        else if (conversion != 'c' && conversion != 'p' && (test_random() & 1)) {
+            f += sprintf(f, ".%d", precision);
+        }
+        f += sprintf(f, "%s", length);
+    }
+    *f++ = conversion;
+    // Literal text around the conversion, so that the position in the output varies.
+    sprintf(f, "%s", (test_random() & 1) ? " |end" : "");
+
+    switch (conversion) {
+        case 'd':
+        case 'i':
+            if (strcmp(length, "ll") == 0) {
+                FORMAT_BOTH((long long) bits);
+            }
+            else if (strcmp(length, "l") == 0 || strcmp(length, "z") == 0) {
+                FORMAT_BOTH((long) bits);
+            }
+            else {
+                FORMAT_BOTH((int) bits);
+            }
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            if (strcmp(length, "ll") == 0) {
+                FORMAT_BOTH((unsigned long long) bits);
+            }
+            else if (strcmp(length, "l") == 0 || strcmp(length, "z") == 0) {
+                FORMAT_BOTH((unsigned long) bits);
+            }
+            else {
+                FORMAT_BOTH((unsigned int) bits);
+            }
+            break;
+        case 'c':
+            FORMAT_BOTH((int) (' ' + bits % 95));
+            break;
+        case 's':
+            FORMAT_BOTH(fuzz_strings[bits % (sizeof(fuzz_strings) / sizeof(fuzz_strings[0]))]);
+            break;
+        case 'p':
+            // Not a null pointer, which the C library prints as "(nil)".
+            FORMAT_BOTH((void *) (uintptr_t) (bits | 1));
+            break;
+        default:
+            format_both(size, format);
+            break;
+    }
+}
+
+/** fuzz_printf:
+ *  Compares vsnprintf of lib/printf.c with the C library on random conversions and buffer sizes.
+ */
+void fuzz_printf(uint32_t iterations) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        fuzz_format();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef __TEST_H__
+#define __TEST_H__
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Host harness of lib/ (make test-host)
+ *
+ * Unlike the rest of the tree this code runs on the build machine, against the C library of the host. lib/ is linked
+ * from host/libsaturn.a, where every symbol carries the prefix saturn_ (see the host-lib target), so the functions
+ * under test and their counterparts of the C library can be called side by side. */
+
+// lib/string.c
+size_t saturn_strlen(const char *s);
+size_t saturn_strnlen(const char *s, size_t maxlen);
+void *saturn_memcpy(void *dst, const void *src, size_t n);
+void *saturn_memmove(void *dst, const void *src, size_t n);
+void *saturn_memset(void *dest, int value, size_t n);
+int saturn_memcmp(const void *s1, const void *s2, size_t n);
+char *saturn_itoa(int value, char *str, int base);
+void saturn_string_set_large_ops(void *(*copy)(void *, const void *, size_t), void *(*fill)(void *, int, size_t));
+
+// lib/printf.c
+int saturn_vsnprintf(char *buf, size_t size, const char *format, va_list ap);
+int saturn_snprintf(char *buf, size_t size, const char *format, ...);
+
+// lib/div64.c
+uint32_t saturn_div64_u32(uint64_t *value, uint32_t divisor);
+
+// Copies and fills of at least this many bytes go to the large routines, see include/string.h.
+#define TEST_LARGE_THRESHOLD    512
+
+/* Records a failure with its location and a printf-style description when the condition does not hold. The harness
+ * goes on with the next check and exits with a non-zero status at the end. */
+#define TEST_CHECK(condition, ...)                                                                              \
+    do {                                                                                                        \
+        test_checks++;                                                                                          \
+        if (!(condition)) {                                                                                     \
+            test_fail(__FILE__, __LINE__, __VA_ARGS__);                                                         \
+        }                                                                                                       \
+    } while (0)
+
+extern unsigned int test_checks;
+extern unsigned int test_failures;
+
+void test_fail(const char *file, int line, const char *format, ...) __attribute__((format(printf, 3, 4)));
+void test_seed(uint32_t seed);
+uint32_t test_random();
+
+void test_string();
+void test_printf();
+void fuzz_string(uint32_t iterations);
+void fuzz_printf(uint32_t iterations);
+void bench_lib(double min_time);
+
+#endif
\ No newline at end of file
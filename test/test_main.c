@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+
+/* Runs the unit tests, the differential fuzzers and the throughput benchmarks of lib/ on the host.
+ *
+ * Options:
+ *     --seed=N         seed of the fuzzers, a failure prints the seed it ran with
+ *     --iterations=N   random cases per fuzzer
+ *     --bench-time=S   least time in seconds each benchmark runs, 0 skips the benchmarks */
+
+#define TEST_DEFAULT_ITERATIONS 200000
+#define TEST_DEFAULT_BENCH_TIME 0.05
+
+unsigned int test_checks;
+unsigned int test_failures;
+
+static uint32_t random_state;
+
+/** test_fail:
+ *  Reports a failed check. Only the first failures are written, the count covers all of them.
+ */
+void test_fail(const char *file, int line, const char *format, ...) {
+    va_list ap;
+
+    if (test_failures++ >= 20) {
+        return;
+    }
+    fprintf(stderr, "%s:%d: ", file, line);
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+}
+
+/** test_seed:
+ *  Seeds the generator of test_random.
+ */
+void test_seed(uint32_t seed) {
+    random_state = seed ? seed : 1;
+}
+
+/** test_random:
+ *  Returns a pseudo-random number (xorshift32). The same seed gives the same sequence on every host.
+ */
+uint32_t test_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+int main(int argc, char **argv) {
+    uint32_t seed = 0x5A7E2105;
+    uint32_t iterations = TEST_DEFAULT_ITERATIONS;
+    double bench_time = TEST_DEFAULT_BENCH_TIME;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--seed=", 7) == 0) {
+            seed = strtoul(argv[i] + 7, 0, 0);
+        }
+        else if (strncmp(argv[i], "--iterations=", 13) == 0) {
+            iterations = strtoul(argv[i] + 13, 0, 0);
+        }
+        else if (strncmp(argv[i], "--bench-time=", 13) == 0) {
+            bench_time = strtod(argv[i] + 13, 0);
+        }
+        else {
+            fprintf(stderr, "usage: %s [--seed=N] [--iterations=N] [--bench-time=S]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    test_string();
+    test_printf();
+    printf("unit tests: %u checks, %u failed\n", test_checks, test_failures);
+
+    test_seed(seed);
+    fuzz_string(iterations);
+    fuzz_printf(iterations);
+    printf("fuzzing (seed 0x%x): %u checks, %u failed\n", seed, test_checks, test_failures);
+
+    if (test_failures) {
+        printf("FAILED\n");
+        return 1;
+    }
+
+    if (bench_time > 0) {
+        bench_lib(bench_time);
+    }
+    return 0;
+}
\ No newline at end of file
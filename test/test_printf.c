@@ -0,0 +1,110 @@
+#include <string.h>
+#include "test.h"
+
+// Unit tests of lib/printf.c and lib/div64.c.
+
+/** check_format:
+ *  Formats into a buffer of the given size and compares the output and the returned length.
+ */
+static void check_format(const char *file, int line, size_t size, const char *expected, int expected_length,
+                         const char *format, ...) {
+    char buf[256];
+    va_list ap;
+    int length;
+
+    memset(buf, '#', sizeof(buf));
+    va_start(ap, format);
+    length = saturn_vsnprintf(buf, size, format, ap);
+    va_end(ap);
+
+    test_checks++;
+    if (length != expected_length || (size && strcmp(buf, expected) != 0) || buf[size] != '#') {
+        test_fail(file, line, "\"%s\": got \"%s\" (%d), expected \"%s\" (%d)", format, size ? buf : "", length,
+                  expected, expected_length);
+    }
+}
+
+// Formats into a large buffer, expected is the whole output.
+#define CHECK_FORMAT(expected, ...) \
+    check_format(__FILE__, __LINE__, 200, expected, (int) strlen(expected), __VA_ARGS__)
+
+// Formats into a buffer of size bytes, expected is the stored part and length the full length.
+#define CHECK_TRUNCATED(size, expected, length, ...) \
+    check_format(__FILE__, __LINE__, size, expected, length, __VA_ARGS__)
+
+static void test_conversions() {
+    CHECK_FORMAT("plain text", "plain text");
+    CHECK_FORMAT("42 -42 0", "%d %i %d", 42, -42, 0);
+    CHECK_FORMAT("-2147483648", "%d", (int) 0x80000000);
+    CHECK_FORMAT("4294967295", "%u", 0xFFFFFFFFu);
+    CHECK_FORMAT("ff FF 17", "%x %X %o", 255, 255, 15);
+    CHECK_FORMAT("c string", "%c %s", 'c', "string");
+    CHECK_FORMAT("100%", "%d%%", 100);
+    CHECK_FORMAT("0x1234", "%p", (void *) 0x1234);
+    CHECK_FORMAT("%y", "%y");
+}
+
+static void test_length_modifiers() {
+    CHECK_FORMAT("-1 255", "%hhd %hhu", 255, 255);
+    CHECK_FORMAT("-1 65535", "%hd %hu", 65535, 65535);
+    CHECK_FORMAT("-9223372036854775808", "%lld", (long long) 0x8000000000000000ull);
+    CHECK_FORMAT("18446744073709551615", "%llu", 0xFFFFFFFFFFFFFFFFull);
+    CHECK_FORMAT("123456789", "%ld", 123456789L);
+    CHECK_FORMAT("4096", "%zu", (size_t) 4096);
+}
+
+static void test_flags_width_precision() {
+    CHECK_FORMAT("   42|42   |00042", "%5d|%-5d|%05d", 42, 42, 42);
+    CHECK_FORMAT("+42 -42  42", "%+d %+d % d", 42, -42, 42);
+    CHECK_FORMAT("-0042", "%05d", -42);
+    CHECK_FORMAT("0x2a 0X2A 052", "%#x %#X %#o", 42, 42, 42);
+    CHECK_FORMAT("0 0", "%#x %#o", 0, 0);
+    CHECK_FORMAT("  00042", "%7.5d", 42);
+    CHECK_FORMAT("   42", "%05.2d", 42);
+    CHECK_FORMAT("", "%.0d", 0);
+    CHECK_FORMAT("   ab|ab   |abc", "%5.2s|%-5.2s|%.*s", "abc", "abc", 3, "abcdef");
+    CHECK_FORMAT("   42|42   ", "%*d|%*d", 5, 42, -5, 42);
+    CHECK_FORMAT("    x|x    ", "%5c|%-5c", 'x', 'x');
+}
+
+static void test_truncation() {
+    CHECK_TRUNCATED(0, "", 5, "hello");
+    CHECK_TRUNCATED(1, "", 5, "hello");
+    CHECK_TRUNCATED(4, "hel", 5, "hello");
+    CHECK_TRUNCATED(6, "hello", 5, "hello");
+    CHECK_TRUNCATED(5, "    ", 6, "%6d", -1);
+    CHECK_TRUNCATED(3, "12", 10, "%d", 1234567890);
+}
+
+static void test_div64() {
+    static const struct {
+        uint64_t value;
+        uint32_t divisor;
+    } cases[] = {
+        {0, 1},
+        {12345, 10},
+        {0xFFFFFFFFFFFFFFFFull, 1},
+        {0xFFFFFFFFFFFFFFFFull, 0xFFFFFFFF},
+        {1000000000000ull, 1000000000},
+        {0x123456789ABCDEFull, 7},
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        uint64_t quotient = cases[i].value;
+        uint32_t remainder = saturn_div64_u32(&quotient, cases[i].divisor);
+
+        TEST_CHECK(quotient == cases[i].value / cases[i].divisor && remainder == cases[i].value % cases[i].divisor,
+                   "div64_u32(%llu, %u)", (unsigned long long) cases[i].value, cases[i].divisor);
+    }
+}
+
+/** test_printf:
+ *  Runs the unit tests of lib/printf.c and lib/div64.c.
+ */
+void test_printf() {
+    test_conversions();
+    test_length_modifiers();
+    test_flags_width_precision();
+    test_truncation();
+    test_div64();
+}
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include <limits.h>
+#include <string.h>
+#include "test.h"
+
+// Unit tests of lib/string.c.
+
+static uint8_t buffer[2 * TEST_LARGE_THRESHOLD + 64];
+static size_t large_copies;
+static size_t large_fills;
+
+static void *count_copy(void *dst, const void *src, size_t n) {
+    large_copies++;
+    return memcpy(dst, src, n);
+}
+
+static void *count_fill(void *dest, int value, size_t n) {
+    large_fills++;
+    return memset(dest, value, n);
+}
+
+/** fill_pattern:
+ *  Numbers the bytes of the buffer, so a misplaced byte shows up in a comparison.
+ */
+static void fill_pattern() {
+    for (size_t i = 0; i < sizeof(buffer); i++) {
+        buffer[i] = (uint8_t) (i * 7 + 1);
+    }
+}
+
+static void test_strlen() {
+    char s[64];
+
+    // Every alignment of the start and the end, the word-wise scan must stop at the first zero byte.
+    for (size_t start = 0; start < 8; start++) {
+        for (size_t length = 0; length < 40; length++) {
+            memset(s, 'a', sizeof(s));
+            s[start + length] = 0;
+            TEST_CHECK(saturn_strlen(s + start) == length, "strlen at offset %zu, length %zu", start, length);
+            TEST_CHECK(saturn_strnlen(s + start, length / 2) == length / 2, "strnlen limit %zu", length / 2);
+            TEST_CHECK(saturn_strnlen(s + start, length + 5) == length, "strnlen of length %zu", length);
+        }
+    }
+    TEST_CHECK(saturn_strnlen("abc", 0) == 0, "strnlen with limit 0");
+}
+
+static void test_memcpy_memset() {
+    uint8_t expected[64];
+
+    fill_pattern();
+    TEST_CHECK(saturn_memcpy(buffer + 3, buffer + 100, 37) == buffer + 3, "memcpy returns dst");
+    TEST_CHECK(memcmp(buffer + 3, buffer + 100, 37) == 0, "memcpy copies the bytes");
+
+    memset(expected, 0xAB, sizeof(expected));
+    fill_pattern();
+    TEST_CHECK(saturn_memset(buffer + 1, 0x1AB, 61) == buffer + 1, "memset returns dest");
+    TEST_CHECK(memcmp(buffer + 1, expected, 61) == 0, "memset stores the low byte of the value");
+    TEST_CHECK(buffer[0] == 1 && buffer[62] == (uint8_t) (62 * 7 + 1), "memset stays within the block");
+
+    TEST_CHECK(saturn_memcpy(buffer, buffer + 1, 0) == buffer, "memcpy of 0 bytes");
+    TEST_CHECK(saturn_memset(buffer, 0, 0) == buffer, "memset of 0 bytes");
+}
+
+static void test_memmove() {
+    uint8_t expected[sizeof(buffer)];
+
+    // Overlapping in both directions, by less and by more than a word.
+    for (int shift = -9; shift <= 9; shift++) {
+        size_t src = 20;
+        size_t dst = src + shift;
+
+        fill_pattern();
+        memcpy(expected, buffer, sizeof(buffer));
+        memmove(expected + dst, expected + src, 101);
+        TEST_CHECK(saturn_memmove(buffer + dst, buffer + src, 101) == buffer + dst, "memmove returns dst");
+        TEST_CHECK(memcmp(buffer, expected, sizeof(buffer)) == 0, "memmove with a shift of %d", shift);
+    }
+}
+
+static void test_memcmp() {
+    TEST_CHECK(saturn_memcmp("abc", "abc", 3) == 0, "memcmp of equal blocks");
+    TEST_CHECK(saturn_memcmp("abc", "abd", 3) < 0, "memcmp of a smaller block");
+    TEST_CHECK(saturn_memcmp("abd", "abc", 3) > 0, "memcmp of a greater block");
+    TEST_CHECK(saturn_memcmp("\x01", "\xFF", 1) < 0, "memcmp compares unsigned bytes");
+    TEST_CHECK(saturn_memcmp("abc", "xyz", 0) == 0, "memcmp of 0 bytes");
+}
+
+static void test_itoa() {
+    static const struct {
+        int value;
+        int base;
+        const char *expected;
+    } cases[] = {
+        {0, 10, "0"},
+        {7, 10, "7"},
+        {-42, 10, "-42"},
+        {INT_MAX, 10, "2147483647"},
+        {INT_MIN, 10, "-2147483648"},
+        {255, 16, "ff"},
+        {-1, 16, "ffffffff"},
+        {INT_MIN, 16, "80000000"},
+        {-8, 8, "37777777770"},
+        {5, 2, "101"},
+        {35, 36, "z"},
+        {1, 1, ""},
+        {1, 37, ""},
+    };
+    char s[40];
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        TEST_CHECK(saturn_itoa(cases[i].value, s, cases[i].base) == s, "itoa returns str");
+        TEST_CHECK(strcmp(s, cases[i].expected) == 0, "itoa(%d, %d) gave \"%s\", expected \"%s\"", cases[i].value,
+                   cases[i].base, s, cases[i].expected);
+    }
+}
+
+static void test_large_ops() {
+    fill_pattern();
+    saturn_string_set_large_ops(count_copy, count_fill);
+
+    saturn_memcpy(buffer, buffer + TEST_LARGE_THRESHOLD + 32, TEST_LARGE_THRESHOLD - 1);
+    saturn_memset(buffer, 0, TEST_LARGE_THRESHOLD - 1);
+    TEST_CHECK(large_copies == 0 && large_fills == 0, "blocks below the threshold stay with the built-in loops");
+
+    saturn_memcpy(buffer, buffer + TEST_LARGE_THRESHOLD + 32, TEST_LARGE_THRESHOLD);
+    saturn_memset(buffer, 0, TEST_LARGE_THRESHOLD);
+    TEST_CHECK(large_copies == 1 && large_fills == 1, "blocks of the threshold go to the large routines");
+
+    saturn_string_set_large_ops(0, 0);
+    saturn_memcpy(buffer, buffer + TEST_LARGE_THRESHOLD + 32, TEST_LARGE_THRESHOLD);
+    TEST_CHECK(large_copies == 1, "the large routines can be removed");
+}
+
+/** test_string:
+ *  Runs the unit tests of lib/string.c.
+ */
+void test_string() {
+    test_strlen();
+    test_memcpy_memset();
+    test_memmove();
+    test_memcmp();
+    test_itoa();
+    test_large_ops();
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+; fault - A user program that raises an exception: cli is a privileged instruction, in ring 3 it raises a general
+; protection fault. The kernel ends the program with USER_FAULT_EXIT_STATUS (see interrupt_handler in
+; drivers/interrupts/isr.c) and keeps running; the exit system call after it is never reached.
+global _start
+
+SYSCALL_EXIT equ 0                  ; see kernel/syscall/syscall.h
+
+section .text
+_start:
+    cli
+
+    mov   eax, SYSCALL_EXIT
+    xor   ebx, ebx                  ; status
+    int   0x80
\ No newline at end of file
@@ -0,0 +1,27 @@
+; hello - A user program. GRUB loads it as a module and the kernel runs it in an address space of its own (see
+; kernel/process/process.c). It writes a greeting and exits with the value of a variable in its BSS, which reads as 0
+; since the BSS is zero-filled when it is first touched.
+global _start
+
+SYSCALL_EXIT equ 0                  ; see kernel/syscall/syscall.h
+SYSCALL_WRITE equ 1
+
+section .text
+_start:
+    mov   eax, SYSCALL_WRITE
+    mov   ebx, message              ; buffer
+    mov   esi, message_length       ; length
+    int   0x80
+
+    mov   eax, SYSCALL_EXIT
+    mov   ebx, [status]             ; status
+    int   0x80
+
+section .data
+message:
+    db    "Hello from user mode!", 10
+message_length equ $ - message
+
+section .bss
+status:
+    resd  1
\ No newline at end of file